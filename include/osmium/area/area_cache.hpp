@@ -0,0 +1,306 @@
+#ifndef OSMIUM_AREA_AREA_CACHE_HPP
+#define OSMIUM_AREA_AREA_CACHE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        namespace detail {
+
+            struct area_cache_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t reserved;
+                uint64_t num_areas;
+                uint64_t data_size;
+            }; // struct area_cache_header
+
+            constexpr const char area_cache_magic[8] = {'O', 'S', 'M', 'A', 'R', 'E', 'A', '\0'};
+
+            enum : uint32_t {
+                area_cache_version = 1
+            };
+
+            // Read exactly size bytes from fd, throws if the file is too short.
+            inline void read_exactly(const int fd, char* data, std::size_t size) {
+                while (size > 0) {
+                    const auto chunk = static_cast<unsigned int>(std::min<std::size_t>(size, 1024UL * 1024UL * 1024UL));
+                    const auto nread = osmium::io::detail::reliable_read(fd, data, chunk);
+                    if (nread == 0) {
+                        throw std::runtime_error{"Area cache file is truncated"};
+                    }
+                    data += nread;
+                    size -= static_cast<std::size_t>(nread);
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Stores assembled areas by their area ID, so they can be kept
+         * between runs. The cache can be written to a file with dump() and
+         * read again with the constructor taking a file descriptor.
+         *
+         * Together with the AreaDependencies class this allows updating a
+         * set of areas from a change file: Find the areas affected by the
+         * changes, assemble only those again (see
+         * MultipolygonManager::set_area_filter()), remove the affected
+         * areas from the cache and add the newly assembled ones.
+         */
+        class AreaCache {
+
+            enum : std::size_t {
+                initial_buffer_size = 1024UL * 1024UL
+            };
+
+            osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+
+            // Maps area IDs to the offset of the area in the buffer.
+            std::unordered_map<osmium::object_id_type, std::size_t> m_index{};
+
+            std::size_t m_count_removed = 0;
+
+            class cleanup_helper {
+
+                osmium::memory::Buffer& m_buffer;
+                std::unordered_map<osmium::object_id_type, std::size_t>& m_index;
+
+            public:
+
+                cleanup_helper(osmium::memory::Buffer& buffer, std::unordered_map<osmium::object_id_type, std::size_t>& index) :
+                    m_buffer(buffer),
+                    m_index(index) {
+                }
+
+                void moving_in_buffer(std::size_t old_offset, std::size_t new_offset) {
+                    m_index[m_buffer.get<osmium::Area>(old_offset).id()] = new_offset;
+                }
+
+            }; // class cleanup_helper
+
+        public:
+
+            /// Create an empty cache.
+            AreaCache() = default;
+
+            /**
+             * Read a cache from a file written by dump().
+             *
+             * @param fd File descriptor to read from.
+             * @throws std::runtime_error If the file isn't a valid area cache.
+             * @throws std::system_error If reading failed.
+             */
+            explicit AreaCache(const int fd) {
+                detail::area_cache_header header; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                detail::read_exactly(fd, reinterpret_cast<char*>(&header), sizeof(header));
+
+                if (std::memcmp(header.magic, detail::area_cache_magic, sizeof(header.magic)) != 0) {
+                    throw std::runtime_error{"Not an area cache file"};
+                }
+                if (header.version != detail::area_cache_version) {
+                    throw std::runtime_error{"Unsupported area cache file version " + std::to_string(header.version)};
+                }
+                if (header.data_size % osmium::memory::align_bytes != 0) {
+                    throw std::runtime_error{"Invalid area cache file"};
+                }
+
+                const auto size = static_cast<std::size_t>(header.data_size);
+                m_buffer = osmium::memory::Buffer{std::max<std::size_t>(size, initial_buffer_size), osmium::memory::Buffer::auto_grow::yes};
+                detail::read_exactly(fd, reinterpret_cast<char*>(m_buffer.reserve_space(size)), size);
+                m_buffer.commit();
+
+                m_index.reserve(static_cast<std::size_t>(header.num_areas));
+                for (auto it = m_buffer.begin<osmium::Area>(); it != m_buffer.end<osmium::Area>(); ++it) {
+                    m_index[it->id()] = static_cast<std::size_t>(it.data() - m_buffer.data());
+                }
+
+                if (m_index.size() != header.num_areas) {
+                    throw std::runtime_error{"Invalid area cache file"};
+                }
+            }
+
+            /// The number of areas in the cache.
+            std::size_t size() const noexcept {
+                return m_index.size();
+            }
+
+            /// Is the cache empty?
+            bool empty() const noexcept {
+                return m_index.empty();
+            }
+
+            /**
+             * Return an estimate of the number of bytes currently used by
+             * this cache.
+             */
+            std::size_t used_memory() const noexcept {
+                return sizeof(AreaCache) +
+                       m_buffer.capacity() +
+                       m_index.size() * (sizeof(std::pair<osmium::object_id_type, std::size_t>) + sizeof(void*)) +
+                       m_index.bucket_count() * sizeof(void*);
+            }
+
+            /**
+             * Get the area with the given ID.
+             *
+             * @returns Pointer to the area or nullptr if it is not in the
+             *          cache. The pointer is invalidated by any function
+             *          changing the cache.
+             */
+            const osmium::Area* get(const osmium::object_id_type area_id) const {
+                const auto it = m_index.find(area_id);
+                if (it == m_index.end()) {
+                    return nullptr;
+                }
+                return &m_buffer.get<osmium::Area>(it->second);
+            }
+
+            /**
+             * Remove the area with the given ID from the cache.
+             *
+             * @returns true if the area was in the cache.
+             */
+            bool remove(const osmium::object_id_type area_id) {
+                const auto it = m_index.find(area_id);
+                if (it == m_index.end()) {
+                    return false;
+                }
+                m_buffer.get<osmium::Area>(it->second).set_removed(true);
+                m_index.erase(it);
+                ++m_count_removed;
+                return true;
+            }
+
+            /**
+             * Add an area to the cache. An area with the same ID already in
+             * the cache is replaced.
+             */
+            void add(const osmium::Area& area) {
+                remove(area.id());
+                if (m_count_removed > 1000 && m_count_removed > m_index.size()) {
+                    compact();
+                }
+                const auto offset = m_buffer.committed();
+                m_buffer.add_item(area);
+                m_buffer.commit();
+                m_index[area.id()] = offset;
+            }
+
+            /**
+             * Add all areas in the buffer to the cache. Other objects in the
+             * buffer are ignored.
+             */
+            void add_buffer(const osmium::memory::Buffer& buffer) {
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    add(area);
+                }
+            }
+
+            /**
+             * Free the memory used by removed areas for new areas.
+             * Usually you don't have to call this, add() will call it
+             * when needed.
+             */
+            void compact() {
+                cleanup_helper helper{m_buffer, m_index};
+                m_buffer.purge_removed(&helper);
+                m_count_removed = 0;
+            }
+
+            /**
+             * Call the function for each area in the cache. The order is
+             * unspecified.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (const auto& area : m_buffer.select<osmium::Area>()) {
+                    if (!area.removed()) {
+                        std::forward<TFunc>(func)(area);
+                    }
+                }
+            }
+
+            /**
+             * Write the cache to a file. Areas are written ordered by ID.
+             *
+             * @param fd File descriptor to write to.
+             * @throws std::system_error If writing failed.
+             */
+            void dump(const int fd) const {
+                std::vector<std::pair<osmium::object_id_type, std::size_t>> entries{m_index.cbegin(), m_index.cend()};
+                std::sort(entries.begin(), entries.end());
+
+                std::size_t data_size = 0;
+                for (const auto& entry : entries) {
+                    data_size += m_buffer.get<osmium::Area>(entry.second).padded_size();
+                }
+
+                detail::area_cache_header header; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                std::memcpy(header.magic, detail::area_cache_magic, sizeof(header.magic));
+                header.version = detail::area_cache_version;
+                header.reserved = 0;
+                header.num_areas = entries.size();
+                header.data_size = data_size;
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+
+                for (const auto& entry : entries) {
+                    const auto& area = m_buffer.get<osmium::Area>(entry.second);
+                    osmium::io::detail::reliable_write(fd, area.data(), area.padded_size());
+                }
+            }
+
+        }; // class AreaCache
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_AREA_CACHE_HPP
@@ -0,0 +1,418 @@
+#ifndef OSMIUM_AREA_AREA_DEPENDENCIES_HPP
+#define OSMIUM_AREA_AREA_DEPENDENCIES_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/area_cache.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        namespace detail {
+
+            struct area_dependencies_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t reserved;
+                uint64_t num_node_entries;
+                uint64_t num_way_entries;
+            }; // struct area_dependencies_header
+
+            constexpr const char area_dependencies_magic[8] = {'O', 'S', 'M', 'A', 'D', 'E', 'P', '\0'};
+
+            enum : uint32_t {
+                area_dependencies_version = 2
+            };
+
+        } // namespace detail
+
+        /**
+         * Keeps track of which objects the areas depend on: Which ways
+         * contain a node and which multipolygon relations contain a way.
+         * With this the areas that have to be assembled again after some
+         * objects changed can be found.
+         *
+         * This works like the osmium::index::RelationsMapStash and
+         * RelationsMapIndex classes, but uses 64 bit IDs throughout (node
+         * IDs don't fit into 32 bit) and the index can be updated and
+         * written to a file.
+         *
+         * Usage:
+         * @code
+         * osmium::area::AreaDependencies deps;
+         * // for all closed ways that can become areas and all member ways
+         * // of multipolygon relations
+         * deps.add_way(way);
+         * // for all multipolygon relations
+         * deps.add_relation(relation);
+         * deps.sort();
+         * ...
+         * // later, with the objects from a change file
+         * const auto area_ids = deps.affected_areas(changes);
+         * const auto missing_ways = deps.apply_changes(changes, [](const osmium::OSMObject& object) {
+         *     // return true for ways and relations that can become areas
+         * });
+         * // get the ways in missing_ways from the database and
+         * for (...) {
+         *     deps.add_way(way);
+         * }
+         * deps.sort();
+         * @endcode
+         *
+         * Only add ways and relations that can become areas (or are members
+         * of those), otherwise the index gets very large. Each entry takes
+         * 16 bytes.
+         *
+         * Objects with negative IDs are kept apart from those with positive
+         * IDs, the IDs are stored as they are.
+         */
+        class AreaDependencies {
+
+            struct entry {
+                osmium::object_id_type key;
+                osmium::object_id_type value;
+
+                bool operator<(const entry& other) const noexcept {
+                    return std::tie(key, value) < std::tie(other.key, other.value);
+                }
+
+                bool operator==(const entry& other) const noexcept {
+                    return key == other.key && value == other.value;
+                }
+            }; // struct entry
+
+            std::vector<entry> m_node_to_way{};
+            std::vector<entry> m_way_to_relation{};
+
+            static void sort_unique(std::vector<entry>& entries) {
+                std::sort(entries.begin(), entries.end());
+                entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+            }
+
+            static void sort_unique(std::vector<osmium::object_id_type>& ids) {
+                std::sort(ids.begin(), ids.end());
+                ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            }
+
+            static std::pair<std::vector<entry>::const_iterator, std::vector<entry>::const_iterator>
+            key_range(const std::vector<entry>& entries, osmium::object_id_type key) {
+                return std::equal_range(entries.begin(), entries.end(), entry{key, 0}, [](const entry& a, const entry& b) {
+                    return a.key < b.key;
+                });
+            }
+
+            template <typename TFunc>
+            static void for_each_value(const std::vector<entry>& entries, osmium::object_id_type key, TFunc&& func) {
+                const auto range = key_range(entries, key);
+                for (auto it = range.first; it != range.second; ++it) {
+                    std::forward<TFunc>(func)(it->value);
+                }
+            }
+
+            // Remove all entries with the values in the sorted vector.
+            static void remove_values(std::vector<entry>& entries, const std::vector<osmium::object_id_type>& values) {
+                if (values.empty()) {
+                    return;
+                }
+                entries.erase(std::remove_if(entries.begin(), entries.end(), [&values](const entry& e) {
+                    return std::binary_search(values.begin(), values.end(), e.value);
+                }), entries.end());
+            }
+
+            static void write_entries(const int fd, const std::vector<entry>& entries) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entry));
+            }
+
+            static void read_entries(const int fd, std::vector<entry>& entries, uint64_t count) {
+                entries.resize(static_cast<std::size_t>(count));
+                detail::read_exactly(fd, reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(entry));
+            }
+
+        public:
+
+            /// Create an empty index.
+            AreaDependencies() = default;
+
+            /**
+             * Read an index from a file written by dump().
+             *
+             * @param fd File descriptor to read from.
+             * @throws std::runtime_error If the file isn't a valid file.
+             * @throws std::system_error If reading failed.
+             */
+            explicit AreaDependencies(const int fd) {
+                detail::area_dependencies_header header; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                detail::read_exactly(fd, reinterpret_cast<char*>(&header), sizeof(header));
+
+                if (std::memcmp(header.magic, detail::area_dependencies_magic, sizeof(header.magic)) != 0) {
+                    throw std::runtime_error{"Not an area dependencies file"};
+                }
+                if (header.version != detail::area_dependencies_version) {
+                    throw std::runtime_error{"Unsupported area dependencies file version " + std::to_string(header.version)};
+                }
+
+                read_entries(fd, m_node_to_way, header.num_node_entries);
+                read_entries(fd, m_way_to_relation, header.num_way_entries);
+            }
+
+            /// Add dependencies of the way on all its nodes.
+            void add_way(const osmium::Way& way) {
+                for (const auto& node_ref : way.nodes()) {
+                    m_node_to_way.push_back(entry{node_ref.ref(), way.id()});
+                }
+            }
+
+            /// Add dependencies of the relation on all its member ways.
+            void add_relation(const osmium::Relation& relation) {
+                for (const auto& member : relation.members()) {
+                    if (member.type() == osmium::item_type::way) {
+                        m_way_to_relation.push_back(entry{member.ref(), relation.id()});
+                    }
+                }
+            }
+
+            /**
+             * Sort the index. Call this after adding ways and relations and
+             * before any lookups.
+             */
+            void sort() {
+                sort_unique(m_node_to_way);
+                sort_unique(m_way_to_relation);
+            }
+
+            /// The number of node-to-way and way-to-relation entries.
+            std::size_t size() const noexcept {
+                return m_node_to_way.size() + m_way_to_relation.size();
+            }
+
+            /**
+             * Return an estimate of the number of bytes currently used by
+             * this index.
+             */
+            std::size_t used_memory() const noexcept {
+                return sizeof(AreaDependencies) +
+                       (m_node_to_way.capacity() + m_way_to_relation.capacity()) * sizeof(entry);
+            }
+
+            /**
+             * Call func with the area ID of every area that depends on the
+             * object, including the area created from the object itself.
+             * Areas can be reported more than once.
+             *
+             * @pre sort() must have been called.
+             */
+            template <typename TFunc>
+            void for_each_affected_area(const osmium::OSMObject& object, TFunc&& func) const {
+                const auto way_changed = [&](osmium::object_id_type way_id) {
+                    func(osmium::object_id_to_area_id(way_id, osmium::item_type::way));
+                    for_each_value(m_way_to_relation, way_id, [&](osmium::object_id_type relation_id) {
+                        func(osmium::object_id_to_area_id(relation_id, osmium::item_type::relation));
+                    });
+                };
+
+                switch (object.type()) {
+                    case osmium::item_type::node:
+                        for_each_value(m_node_to_way, object.id(), way_changed);
+                        break;
+                    case osmium::item_type::way:
+                        way_changed(object.id());
+                        break;
+                    case osmium::item_type::relation:
+                        func(osmium::object_id_to_area_id(object.id(), osmium::item_type::relation));
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            /**
+             * Get the IDs of all areas that depend on any of the objects in
+             * the buffer (usually read from a change file). Call this before
+             * apply_changes().
+             *
+             * @returns Sorted vector of unique area IDs.
+             * @pre sort() must have been called.
+             */
+            std::vector<osmium::object_id_type> affected_areas(const osmium::memory::Buffer& changes) const {
+                std::vector<osmium::object_id_type> area_ids;
+                for (const auto& object : changes.select<osmium::OSMObject>()) {
+                    for_each_affected_area(object, [&area_ids](osmium::object_id_type area_id) {
+                        area_ids.push_back(area_id);
+                    });
+                }
+                std::sort(area_ids.begin(), area_ids.end());
+                area_ids.erase(std::unique(area_ids.begin(), area_ids.end()), area_ids.end());
+                return area_ids;
+            }
+
+            /**
+             * Update the index with the objects in the buffer. The
+             * dependencies of changed and deleted ways and relations are
+             * removed. Those of changed ways and relations that are still
+             * visible are added again if the filter returns true for them.
+             * Changed ways that are members of a relation in the index are
+             * always added. If the buffer contains several versions of an
+             * object, the last one is used.
+             *
+             * Relations in the buffer can have member ways which are not in
+             * the buffer and not in the index, for instance if an existing
+             * way was added to a multipolygon. Their IDs are returned. Call
+             * add_way() with those ways (from your database) and then
+             * sort(), otherwise changes to their nodes will not be found.
+             *
+             * Complexity: Linear in the size of the index plus
+             *             n log n for the changed objects.
+             *
+             * @param changes Buffer with the changed objects.
+             * @param filter Function called with a const OSMObject& for
+             *               each visible way and relation, returning true
+             *               if it can become an area and should be added.
+             * @returns Sorted vector of IDs of member ways missing from
+             *          the index.
+             */
+            template <typename TFilter>
+            std::vector<osmium::object_id_type> apply_changes(const osmium::memory::Buffer& changes, TFilter&& filter) {
+                // Only the last version of each object is used.
+                std::vector<const osmium::OSMObject*> objects;
+                for (const auto& object : changes.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::way || object.type() == osmium::item_type::relation) {
+                        objects.push_back(&object);
+                    }
+                }
+                std::stable_sort(objects.begin(), objects.end(), [](const osmium::OSMObject* a, const osmium::OSMObject* b) {
+                    return std::make_tuple(a->type(), a->id()) < std::make_tuple(b->type(), b->id());
+                });
+                const auto last_versions = std::unique(objects.rbegin(), objects.rend(), [](const osmium::OSMObject* a, const osmium::OSMObject* b) {
+                    return a->type() == b->type() && a->id() == b->id();
+                });
+                objects.erase(objects.begin(), last_versions.base());
+
+                std::vector<osmium::object_id_type> ways;
+                std::vector<osmium::object_id_type> relations;
+                for (const auto* object : objects) {
+                    (object->type() == osmium::item_type::way ? ways : relations).push_back(object->id());
+                }
+
+                remove_values(m_node_to_way, ways);
+                remove_values(m_way_to_relation, relations);
+
+                // Relations first, so that we know which ways are members.
+                std::vector<osmium::object_id_type> member_ways;
+                for (const auto* object : objects) {
+                    if (object->type() == osmium::item_type::relation && object->visible() && filter(*object)) {
+                        const auto& relation = *static_cast<const osmium::Relation*>(object);
+                        add_relation(relation);
+                        for (const auto& member : relation.members()) {
+                            if (member.type() == osmium::item_type::way &&
+                                !std::binary_search(ways.begin(), ways.end(), member.ref())) {
+                                member_ways.push_back(member.ref());
+                            }
+                        }
+                    }
+                }
+                sort_unique(m_way_to_relation);
+
+                for (const auto* object : objects) {
+                    if (object->type() == osmium::item_type::way && object->visible()) {
+                        const auto range = key_range(m_way_to_relation, object->id());
+                        if (range.first != range.second || filter(*object)) {
+                            add_way(*static_cast<const osmium::Way*>(object));
+                        }
+                    }
+                }
+                sort_unique(m_node_to_way);
+
+                // Find member ways not in the index.
+                sort_unique(member_ways);
+                std::vector<bool> found(member_ways.size(), false);
+                for (const auto& e : m_node_to_way) {
+                    const auto it = std::lower_bound(member_ways.begin(), member_ways.end(), e.value);
+                    if (it != member_ways.end() && *it == e.value) {
+                        found[static_cast<std::size_t>(it - member_ways.begin())] = true;
+                    }
+                }
+                std::vector<osmium::object_id_type> missing;
+                for (std::size_t i = 0; i < member_ways.size(); ++i) {
+                    if (!found[i]) {
+                        missing.push_back(member_ways[i]);
+                    }
+                }
+
+                return missing;
+            }
+
+            /**
+             * Write the index to a file.
+             *
+             * @param fd File descriptor to write to.
+             * @throws std::system_error If writing failed.
+             * @pre sort() must have been called.
+             */
+            void dump(const int fd) const {
+                detail::area_dependencies_header header; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                std::memcpy(header.magic, detail::area_dependencies_magic, sizeof(header.magic));
+                header.version = detail::area_dependencies_version;
+                header.reserved = 0;
+                header.num_node_entries = m_node_to_way.size();
+                header.num_way_entries = m_way_to_relation.size();
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                write_entries(fd, m_node_to_way);
+                write_entries(fd, m_way_to_relation);
+            }
+
+        }; // class AreaDependencies
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_AREA_DEPENDENCIES_HPP
@@ -57,6 +57,11 @@ namespace osmium {
         /**
          * Assembles area objects from closed ways or multipolygon relations
          * and their members.
+         *
+         * An Assembler can be used for any number of objects one after the
+         * other. Each call clears the state (including the statistics) left
+         * from the previous call, but keeps the memory allocated for it, so
+         * reusing an Assembler is cheaper than creating a new one.
          */
         class Assembler : public detail::BasicAssemblerWithTags {
 
@@ -119,6 +124,8 @@ namespace osmium {
              *          area, true otherwise.
              */
             bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_way_polygons) {
                     return true;
                 }
@@ -177,6 +184,8 @@ namespace osmium {
              *          area(s), true otherwise.
              */
             bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_new_style_polygons) {
                     return true;
                 }
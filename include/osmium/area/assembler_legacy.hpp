@@ -69,6 +69,8 @@ namespace osmium {
         /**
          * Assembles area objects from closed ways or multipolygon relations
          * and their members.
+         *
+         * Objects of this class can be reused, see osmium::area::Assembler.
          */
         class AssemblerLegacy : public detail::BasicAssemblerWithTags {
 
@@ -215,6 +217,8 @@ namespace osmium {
              *          area, true otherwise.
              */
             bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_way_polygons) {
                     return true;
                 }
@@ -277,6 +281,8 @@ namespace osmium {
              *          area(s), true otherwise.
              */
             bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 assert(relation.members().size() >= members.size());
 
                 if (config().problem_reporter) {
@@ -53,6 +53,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
@@ -152,6 +153,11 @@ namespace osmium {
                 // The rings we are building from the segments
                 std::list<ProtoRing> m_rings;
 
+                // Rings not in use any more. They are kept around and moved
+                // back into m_rings when needed, so that they (and their
+                // vectors) don't have to be allocated again.
+                std::list<ProtoRing> m_spare_rings;
+
                 // All node locations
                 std::vector<slocation> m_locations;
 
@@ -237,6 +243,20 @@ namespace osmium {
                     return &m_segment_list[it->item];
                 }
 
+                ProtoRing* add_ring(NodeRefSegment* segment) {
+                    if (m_spare_rings.empty()) {
+                        m_rings.emplace_back(segment);
+                    } else {
+                        m_rings.splice(m_rings.end(), m_spare_rings, m_spare_rings.begin());
+                        m_rings.back().reinitialize(segment);
+                    }
+                    return &m_rings.back();
+                }
+
+                void remove_ring(std::list<ProtoRing>::iterator ring) {
+                    m_spare_rings.splice(m_spare_rings.end(), m_rings, ring);
+                }
+
                 class rings_stack_element {
 
                     double m_y;
@@ -283,27 +303,94 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * The segments which might be below a location when looking
+                 * for the ring enclosing it. These are the segments up to
+                 * some position in the (sorted) segment list whose x range
+                 * ends at or after the x coordinate of the location. When
+                 * the locations are checked in order, segments are only
+                 * added and removed once, so finding the enclosing rings of
+                 * all rings is not quadratic in the number of rings any more.
+                 */
+                class segments_in_x_range {
+
+                    std::vector<NodeRefSegment*> m_segments;
+                    NodeRefSegment* m_first;
+                    NodeRefSegment* m_next;
+                    int32_t m_x = std::numeric_limits<int32_t>::min();
+
+                public:
+
+                    explicit segments_in_x_range(SegmentList& segment_list) :
+                        m_segments(),
+                        m_first(segment_list.empty() ? nullptr : &segment_list.front()),
+                        m_next(m_first) {
+                    }
+
+                    /**
+                     * Update the set to contain all segments up to and
+                     * including last that end at or after x. This is fast
+                     * if x doesn't decrease between calls, otherwise the set
+                     * is rebuilt.
+                     */
+                    void update(const NodeRefSegment* last, int32_t x) {
+                        if (x < m_x) {
+                            m_segments.clear();
+                            m_next = m_first;
+                        }
+                        m_x = x;
+
+                        m_segments.erase(std::remove_if(m_segments.begin(), m_segments.end(), [x](const NodeRefSegment* segment) {
+                            return segment->second().location().x() < x;
+                        }), m_segments.end());
+
+                        for (; m_next <= last; ++m_next) {
+                            if (m_next->second().location().x() >= x) {
+                                m_segments.push_back(m_next);
+                            }
+                        }
+                    }
+
+                    /// Iterate over segments from the end of the segment list.
+                    std::vector<NodeRefSegment*>::const_reverse_iterator begin() const noexcept {
+                        return m_segments.crbegin();
+                    }
+
+                    std::vector<NodeRefSegment*>::const_reverse_iterator end() const noexcept {
+                        return m_segments.crend();
+                    }
+
+                }; // class segments_in_x_range
+
                 ProtoRing* find_enclosing_ring(NodeRefSegment* segment) {
+                    segments_in_x_range candidates{m_segment_list};
+                    return find_enclosing_ring(segment, candidates);
+                }
+
+                ProtoRing* find_enclosing_ring(NodeRefSegment* ring_segment, segments_in_x_range& candidates) {
                     if (debug()) {
-                        std::cerr << "    Looking for ring enclosing " << *segment << "\n";
+                        std::cerr << "    Looking for ring enclosing " << *ring_segment << "\n";
                     }
 
-                    const auto location = segment->first().location();
-                    const auto end_location = segment->second().location();
+                    const auto location = ring_segment->first().location();
+                    const auto end_location = ring_segment->second().location();
 
-                    while (segment->first().location() == location) {
-                        if (segment == &m_segment_list.back()) {
+                    while (ring_segment->first().location() == location) {
+                        if (ring_segment == &m_segment_list.back()) {
                             break;
                         }
-                        ++segment;
+                        ++ring_segment;
                     }
 
+                    // Only segments with an x range containing the location
+                    // can be below it, all others are ignored anyway.
+                    candidates.update(ring_segment, location.x());
+
                     int nesting = 0;
 
                     rings_stack outer_rings;
-                    while (segment >= &m_segment_list.front()) {
-                        if (!segment->is_direction_done()) {
-                            --segment;
+                    for (NodeRefSegment* segment : candidates) {
+                        if (segment > ring_segment || !segment->is_direction_done()) {
                             continue;
                         }
                         if (debug()) {
@@ -362,7 +449,6 @@ namespace osmium {
                                 }
                             }
                         }
-                        --segment;
                     }
 
                     if (nesting % 2 == 0) {
@@ -400,7 +486,7 @@ namespace osmium {
                     return std::find(m_split_locations.cbegin(), m_split_locations.cend(), location) != m_split_locations.cend();
                 }
 
-                uint32_t add_new_ring(slocation& node) {
+                uint32_t add_new_ring(slocation& node, segments_in_x_range& candidates) {
                     NodeRefSegment* segment = &m_segment_list[node.item];
                     assert(!segment->is_done());
 
@@ -415,12 +501,11 @@ namespace osmium {
                     ProtoRing* outer_ring = nullptr;
 
                     if (segment != &m_segment_list.front()) {
-                        outer_ring = find_enclosing_ring(segment);
+                        outer_ring = find_enclosing_ring(segment, candidates);
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = add_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -470,8 +555,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = add_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -514,8 +598,8 @@ namespace osmium {
                     });
                 }
 
-                void find_inner_outer_complex(ProtoRing* ring) {
-                    ProtoRing* outer_ring = find_enclosing_ring(ring->min_segment());
+                void find_inner_outer_complex(ProtoRing* ring, segments_in_x_range& candidates) {
+                    ProtoRing* outer_ring = find_enclosing_ring(ring->min_segment(), candidates);
                     if (outer_ring) {
                         outer_ring->add_inner_ring(ring);
                         ring->set_outer_ring(outer_ring);
@@ -549,11 +633,12 @@ namespace osmium {
                     if (debug()) {
                         std::cerr << "    First ring is outer: " << *rings.front() << "\n";
                     }
+                    segments_in_x_range candidates{m_segment_list};
                     for (auto it = std::next(rings.begin()); it != rings.end(); ++it) {
                         if (debug()) {
                             std::cerr << "    Checking (at min segment " << *((*it)->min_segment()) << ") ring " << **it << "\n";
                         }
-                        find_inner_outer_complex(*it);
+                        find_inner_outer_complex(*it, candidates);
                         if (debug()) {
                             std::cerr << "    Ring is " << ((*it)->is_outer() ? "OUTER: " : "INNER: ") << **it << "\n";
                         }
@@ -595,10 +680,11 @@ namespace osmium {
 
                 void create_rings_simple_case() {
                     auto count_remaining = m_segment_list.size();
+                    segments_in_x_range candidates{m_segment_list};
                     for (slocation& sl : m_locations) {
                         const NodeRefSegment& segment = m_segment_list[sl.item];
                         if (!segment.is_done()) {
-                            count_remaining -= add_new_ring(sl);
+                            count_remaining -= add_new_ring(sl, candidates);
                             if (count_remaining == 0) {
                                 return;
                             }
@@ -642,7 +728,7 @@ namespace osmium {
                     }
 
                     open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    remove_ring(r2);
 
                     if (r1->closed()) {
                         open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
@@ -1164,6 +1250,22 @@ namespace osmium {
                     return m_config.debug_level > 1;
                 }
 
+                /**
+                 * Reset the assembler so that it can be used to assemble the
+                 * next area. All memory allocated for segments, rings, and
+                 * locations is kept and reused, so reusing an assembler is
+                 * cheaper than creating a new one. The statistics are also
+                 * reset.
+                 */
+                void reset() {
+                    m_segment_list.clear();
+                    m_spare_rings.splice(m_spare_rings.end(), m_rings);
+                    m_locations.clear();
+                    m_split_locations.clear();
+                    m_stats = area_stats{};
+                    m_num_members = 0;
+                }
+
                 /**
                  * Get statistics from assembler. Call this after running the
                  * assembler to get statistics and data about errors.
@@ -47,9 +47,13 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <numeric>
+#include <queue>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -58,6 +62,92 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Set of "active" segments used in the sweep-line algorithm in
+             * SegmentList::find_intersections(). Segments are kept in a
+             * complete binary tree ordered by the lower end of their y range.
+             * The leaves hold the upper end of the y range of active
+             * segments, inner nodes the maximum of their children. This
+             * allows finding all active segments overlapping a y range in
+             * O(log n + k) time.
+             */
+            class active_segments {
+
+                // (lower end of y range, index of segment) ordered by y
+                std::vector<std::pair<int32_t, uint32_t>> m_by_ymin;
+
+                // position of each segment in m_by_ymin
+                std::vector<uint32_t> m_rank;
+
+                std::vector<int32_t> m_tree;
+
+                std::size_t m_size = 1;
+
+                enum : int32_t {
+                    inactive = std::numeric_limits<int32_t>::min()
+                };
+
+                template <typename TFunc>
+                void query(std::size_t node, std::size_t begin, std::size_t end, std::size_t limit, int32_t ymin, TFunc&& func) const {
+                    if (begin >= limit || m_tree[node] < ymin) {
+                        return;
+                    }
+                    if (node >= m_size) {
+                        std::forward<TFunc>(func)(m_by_ymin[begin].second);
+                        return;
+                    }
+                    const std::size_t middle = begin + (end - begin) / 2;
+                    query(node * 2, begin, middle, limit, ymin, func);
+                    query(node * 2 + 1, middle, end, limit, ymin, func);
+                }
+
+                void update(uint32_t index, int32_t value) noexcept {
+                    std::size_t node = m_size + m_rank[index];
+                    m_tree[node] = value;
+                    for (node /= 2; node > 0; node /= 2) {
+                        m_tree[node] = std::max(m_tree[node * 2], m_tree[node * 2 + 1]);
+                    }
+                }
+
+            public:
+
+                explicit active_segments(const std::vector<NodeRefSegment>& segments) :
+                    m_rank(segments.size()) {
+                    m_by_ymin.reserve(segments.size());
+                    for (uint32_t i = 0; i < segments.size(); ++i) {
+                        m_by_ymin.emplace_back(std::min(segments[i].first().location().y(), segments[i].second().location().y()), i);
+                    }
+                    std::sort(m_by_ymin.begin(), m_by_ymin.end());
+                    for (uint32_t i = 0; i < m_by_ymin.size(); ++i) {
+                        m_rank[m_by_ymin[i].second] = i;
+                    }
+                    while (m_size < segments.size()) {
+                        m_size *= 2;
+                    }
+                    m_tree.assign(m_size * 2, inactive);
+                }
+
+                void insert(uint32_t index, int32_t ymax) noexcept {
+                    update(index, ymax);
+                }
+
+                void remove(uint32_t index) noexcept {
+                    update(index, inactive);
+                }
+
+                /**
+                 * Call func with the index of all active segments whose y
+                 * range overlaps [ymin, ymax].
+                 */
+                template <typename TFunc>
+                void for_each_overlapping(int32_t ymin, int32_t ymax, TFunc&& func) const {
+                    const auto limit = std::upper_bound(m_by_ymin.cbegin(), m_by_ymin.cend(),
+                                                        std::make_pair(ymax, std::numeric_limits<uint32_t>::max())) - m_by_ymin.cbegin();
+                    query(1, 0, m_size, static_cast<std::size_t>(limit), ymin, std::forward<TFunc>(func));
+                }
+
+            }; // class active_segments
+
             /**
              * Iterate over all relation members and the vector of ways at the
              * same time and call given function with the relation member and
@@ -113,6 +203,21 @@ namespace osmium {
                     });
                 }
 
+                bool check_intersection(ProblemReporter* problem_reporter, const NodeRefSegment& s1, const NodeRefSegment& s2) const {
+                    const osmium::Location intersection{calculate_intersection(s1, s2)};
+                    if (!intersection) {
+                        return false;
+                    }
+                    if (m_debug) {
+                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                    }
+                    if (problem_reporter) {
+                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                    }
+                    return true;
+                }
+
                 uint32_t extract_segments_from_way_impl(ProblemReporter* problem_reporter, uint64_t& duplicate_nodes, const osmium::Way& way, role_type role) {
                     uint32_t invalid_locations = 0;
 
@@ -210,6 +315,14 @@ namespace osmium {
                     m_debug = debug;
                 }
 
+                /**
+                 * Remove all segments from the list. The memory used is
+                 * kept, so it can be reused for the next area.
+                 */
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 /// Sort the list of segments.
                 void sort() {
                     std::sort(m_segments.begin(), m_segments.end());
@@ -307,14 +420,45 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Number of segments from which on find_intersections() uses
+                 * the sweep-line algorithm.
+                 */
+                enum : std::size_t {
+                    min_segments_for_sweep_line = 1000
+                };
+
                 /**
                  * Find intersection between segments.
                  *
+                 * For small numbers of segments this uses a simple nested
+                 * loop (see find_intersections_simple()), otherwise a sweep
+                 * line algorithm (see find_intersections_sweep_line()). Both
+                 * report the same intersections in the same order.
+                 *
                  * @param problem_reporter Any intersections found are
                  *                         reported to this object.
                  * @returns true if there are intersections.
                  */
                 uint32_t find_intersections(ProblemReporter* problem_reporter) const {
+                    if (m_segments.size() < min_segments_for_sweep_line) {
+                        return find_intersections_simple(problem_reporter);
+                    }
+                    return find_intersections_sweep_line(problem_reporter);
+                }
+
+                /**
+                 * Find intersection between segments comparing each segment
+                 * with all following segments in the (sorted) list until a
+                 * segment is outside its x range. This is quadratic in the
+                 * number of segments for long segments overlapping in x
+                 * direction.
+                 *
+                 * @param problem_reporter Any intersections found are
+                 *                         reported to this object.
+                 * @returns true if there are intersections.
+                 */
+                uint32_t find_intersections_simple(ProblemReporter* problem_reporter) const {
                     if (m_segments.empty()) {
                         return 0;
                     }
@@ -332,18 +476,8 @@ namespace osmium {
                                 break;
                             }
 
-                            if (y_range_overlap(s1, s2)) {
-                                osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
-                                }
+                            if (y_range_overlap(s1, s2) && check_intersection(problem_reporter, s1, s2)) {
+                                ++found_intersections;
                             }
                         }
                     }
@@ -351,6 +485,59 @@ namespace osmium {
                     return found_intersections;
                 }
 
+                /**
+                 * Find intersection between segments using a sweep line
+                 * moving in x direction over the (sorted) list. All segments
+                 * crossing the sweep line are kept in a tree ordered by their
+                 * y range, so only segments with overlapping bounding boxes
+                 * have to be checked. This needs O((n + k) log n) time for n
+                 * segments and k overlapping bounding boxes.
+                 *
+                 * @param problem_reporter Any intersections found are
+                 *                         reported to this object.
+                 * @returns true if there are intersections.
+                 */
+                uint32_t find_intersections_sweep_line(ProblemReporter* problem_reporter) const {
+                    using end_type = std::pair<int32_t, uint32_t>;
+
+                    active_segments active{m_segments};
+
+                    // x coordinate where segments end, smallest first
+                    std::priority_queue<end_type, std::vector<end_type>, std::greater<end_type>> ends;
+
+                    // pairs of indexes of intersecting segments
+                    std::vector<std::pair<uint32_t, uint32_t>> found;
+
+                    for (uint32_t i = 0; i < m_segments.size(); ++i) {
+                        const NodeRefSegment& s2 = m_segments[i];
+
+                        while (!ends.empty() && ends.top().first < s2.first().location().x()) {
+                            active.remove(ends.top().second);
+                            ends.pop();
+                        }
+
+                        const std::pair<int32_t, int32_t> y = std::minmax(s2.first().location().y(), s2.second().location().y());
+                        active.for_each_overlapping(y.first, y.second, [&](uint32_t j) {
+                            const NodeRefSegment& s1 = m_segments[j];
+                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+                            if (calculate_intersection(s1, s2)) {
+                                found.emplace_back(j, i);
+                            }
+                        });
+
+                        active.insert(i, y.second);
+                        ends.emplace(s2.second().location().x(), i);
+                    }
+
+                    // report in the same order as find_intersections_simple()
+                    std::sort(found.begin(), found.end());
+                    for (const auto& pair : found) {
+                        check_intersection(problem_reporter, m_segments[pair.first], m_segments[pair.second]);
+                    }
+
+                    return static_cast<uint32_t>(found.size());
+                }
+
             }; // class SegmentList
 
         } // namespace detail
@@ -34,7 +34,12 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/area/stats.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -45,12 +50,20 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -60,6 +73,88 @@ namespace osmium {
      */
     namespace area {
 
+        namespace detail {
+
+            /**
+             * Result of assembling a batch of areas in a worker thread.
+             */
+            struct assembler_batch_result {
+
+                osmium::memory::Buffer buffer;
+                area_stats stats;
+
+            }; // struct assembler_batch_result
+
+            /**
+             * A batch of closed ways and relations (each followed by its
+             * member ways) to be assembled into areas in a worker thread.
+             * The batch owns copies of all objects it needs, so the
+             * relations manager can release the originals right away.
+             */
+            template <typename TAssembler>
+            class assembler_batch {
+
+                typename TAssembler::config_type m_config;
+                osmium::memory::Buffer m_input;
+
+            public:
+
+                assembler_batch(const typename TAssembler::config_type& config, osmium::memory::Buffer&& input) :
+                    m_config(config),
+                    m_input(std::move(input)) {
+                }
+
+                assembler_batch_result operator()() {
+                    assembler_batch_result result{osmium::memory::Buffer{m_input.committed(), osmium::memory::Buffer::auto_grow::yes}, area_stats{}};
+                    std::vector<const osmium::Way*> ways;
+
+                    // One assembler is used for the whole batch so the
+                    // memory it allocates is reused.
+                    TAssembler assembler{m_config};
+
+                    auto it = m_input.begin<osmium::OSMObject>();
+                    const auto end = m_input.end<osmium::OSMObject>();
+                    while (it != end) {
+                        if (it->type() == osmium::item_type::way) {
+                            const auto& way = static_cast<const osmium::Way&>(*it);
+                            ++it;
+                            try {
+                                assembler(way, result.buffer);
+                                result.stats += assembler.stats();
+                            } catch (const osmium::invalid_location&) {
+                                // XXX ignore
+                            }
+                            continue;
+                        }
+
+                        assert(it->type() == osmium::item_type::relation);
+                        const auto& relation = static_cast<const osmium::Relation&>(*it);
+                        ++it;
+
+                        ways.clear();
+                        for (const auto& member : relation.members()) {
+                            if (member.ref() != 0) {
+                                assert(it != end && it->type() == osmium::item_type::way);
+                                ways.push_back(static_cast<const osmium::Way*>(&*it));
+                                ++it;
+                            }
+                        }
+
+                        try {
+                            assembler(relation, ways, result.buffer);
+                            result.stats += assembler.stats();
+                        } catch (const osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    }
+
+                    return result;
+                }
+
+            }; // class assembler_batch
+
+        } // namespace detail
+
         /**
          * This class collects all data needed for creating areas from
          * relations tagged with type=multipolygon or type=boundary.
@@ -67,7 +162,10 @@ namespace osmium {
          * osmium::relations::RelationsManager.
          *
          * The actual assembling of the areas is done by the assembler
-         * class given as template argument.
+         * class given as template argument. The manager keeps one assembler
+         * (and one for each batch when assembling in a thread pool) and
+         * uses it for all areas, so the assembler must clear its state at
+         * the beginning of each call like osmium::area::Assembler does.
          *
          * @tparam TAssembler Multipolygon Assembler class.
          * @pre The Ids of all objects must be unique in the input data.
@@ -78,12 +176,142 @@ namespace osmium {
             using assembler_config_type = typename TAssembler::config_type;
             const assembler_config_type m_assembler_config;
 
+            // Assembler reused for all areas assembled in the calling thread.
+            TAssembler m_assembler;
+
             area_stats m_stats;
 
             osmium::TagsFilter m_filter;
 
+            const osmium::index::IdSet<osmium::unsigned_object_id_type>* m_area_filter = nullptr;
+
+            std::size_t m_max_way_members = 0;
+            std::function<bool(const osmium::Relation&)> m_relation_filter{};
+            std::function<bool(const osmium::Box&)> m_envelope_check{};
+            bool m_ring_closure_check = false;
+            std::size_t m_rejected_relations = 0;
+            std::vector<osmium::Location> m_end_locations{};
+
+            osmium::thread::Pool* m_pool = nullptr;
+            std::size_t m_batch_size = default_batch_size;
+            std::size_t m_batch_count = 0;
+            osmium::memory::Buffer m_batch{};
+            std::deque<std::future<detail::assembler_batch_result>> m_pending{};
+
+            bool area_wanted(osmium::object_id_type id, osmium::item_type type) const noexcept {
+                if (!m_area_filter) {
+                    return true;
+                }
+                const auto area_id = osmium::object_id_to_area_id(id, type);
+                return m_area_filter->get(static_cast<osmium::unsigned_object_id_type>(std::abs(area_id)));
+            }
+
+            // Check that the ends of the open member ways can be joined
+            // into rings: Each end location has to show up an even number
+            // of times.
+            bool rings_can_be_closed(const std::vector<const osmium::Way*>& ways) {
+                m_end_locations.clear();
+                for (const auto* way : ways) {
+                    if (way->nodes().size() > 1 && !way->ends_have_same_location()) {
+                        m_end_locations.push_back(way->nodes().front().location());
+                        m_end_locations.push_back(way->nodes().back().location());
+                    }
+                }
+
+                std::sort(m_end_locations.begin(), m_end_locations.end());
+                for (auto it = m_end_locations.cbegin(); it != m_end_locations.cend(); it += 2) {
+                    if (*it != *std::next(it)) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            // Run the checks on the member ways of a complete relation
+            // that are cheaper than assembling it.
+            bool relation_looks_valid(const std::vector<const osmium::Way*>& ways) {
+                if (m_envelope_check) {
+                    osmium::Box envelope;
+                    for (const auto* way : ways) {
+                        for (const auto& node_ref : way->nodes()) {
+                            envelope.extend(node_ref.location());
+                        }
+                    }
+                    if (!m_envelope_check(envelope)) {
+                        return false;
+                    }
+                }
+
+                return !m_ring_closure_check || rings_can_be_closed(ways);
+            }
+
+            void add_to_batch(const osmium::OSMObject& object) {
+                if (!m_batch) {
+                    m_batch = osmium::memory::Buffer{initial_batch_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                }
+                m_batch.add_item(object);
+                m_batch.commit();
+            }
+
+            void batch_done() {
+                if (++m_batch_count >= m_batch_size) {
+                    submit_batch();
+                }
+            }
+
+            void submit_batch() {
+                if (m_batch_count == 0) {
+                    return;
+                }
+                m_pending.push_back(m_pool->submit(detail::assembler_batch<TAssembler>{m_assembler_config, std::move(m_batch)}));
+                m_batch = osmium::memory::Buffer{};
+                m_batch_count = 0;
+
+                // Merge finished results in submission order, and wait for
+                // the oldest batch if too many are in flight.
+                const std::size_t max_pending = 2 * static_cast<std::size_t>(m_pool->num_threads());
+                while (!m_pending.empty() &&
+                       (m_pending.size() > max_pending || oldest_result_ready())) {
+                    merge_oldest_result();
+                }
+            }
+
+            bool oldest_result_ready() const {
+                return m_pending.front().wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+            }
+
+            // Assemble the last partial batch and wait for all batches.
+            void finish_pending() {
+                if (m_pool) {
+                    submit_batch();
+                }
+                while (!m_pending.empty()) {
+                    merge_oldest_result();
+                }
+            }
+
+            void merge_oldest_result() {
+                auto future = std::move(m_pending.front());
+                m_pending.pop_front();
+                auto result = future.get();
+                this->buffer().add_buffer(result.buffer);
+                this->buffer().commit();
+                m_stats += result.stats;
+                this->possibly_flush();
+            }
+
         public:
 
+            enum {
+                /// Default number of areas assembled in one batch by a worker thread.
+                default_batch_size = 1000
+            };
+
+            enum : std::size_t {
+                initial_batch_buffer_size = 64UL * 1024UL
+            };
+
             /**
              * Construct a MultipolygonManager.
              *
@@ -95,9 +323,166 @@ namespace osmium {
              */
             explicit MultipolygonManager(assembler_config_type assembler_config, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
                 m_assembler_config(std::move(assembler_config)),
+                m_assembler(m_assembler_config),
                 m_filter(std::move(filter)) {
             }
 
+            MultipolygonManager(const MultipolygonManager&) = delete;
+            MultipolygonManager& operator=(const MultipolygonManager&) = delete;
+
+            MultipolygonManager(MultipolygonManager&&) = delete;
+            MultipolygonManager& operator=(MultipolygonManager&&) = delete;
+
+            ~MultipolygonManager() noexcept {
+                // Make sure no worker thread outlives its result.
+                for (auto& future : m_pending) {
+                    future.wait();
+                }
+            }
+
+            /**
+             * Assemble areas in the worker threads of the given thread pool
+             * instead of in the thread calling the handler. Closed ways and
+             * completed relations (together with copies of their member
+             * ways) are collected into batches of batch_size objects which
+             * are then assembled in parallel. The results are added to the
+             * output buffer in the order the objects were seen, so the
+             * output is the same as when assembling in a single thread.
+             *
+             * Call this before the second pass. Assembled areas will show up
+             * in the output buffer a bit later than without a pool. Batches
+             * are kept running across input buffers: flush_output() (called
+             * by the second pass handler after each buffer) only adds the
+             * results that are ready, it doesn't wait for the others. All
+             * outstanding batches are finished by read() or, if you are
+             * using a callback, by calling finish_output() after the second
+             * pass. Areas still being assembled are lost otherwise.
+             *
+             * If the assembler configuration contains a problem reporter, it
+             * will be called from several threads at the same time, so it
+             * must be thread-safe.
+             *
+             * @param pool The thread pool to use. Set to nullptr to go back
+             *             to assembling in the calling thread.
+             * @param batch_size Number of closed ways and relations
+             *                   assembled in one task.
+             */
+            void set_thread_pool(osmium::thread::Pool* pool, std::size_t batch_size = default_batch_size) {
+                finish_pending();
+                m_pool = pool;
+                m_batch_size = batch_size > 0 ? batch_size : 1;
+            }
+
+            /**
+             * Only assemble areas with IDs in the given set. This can be
+             * used to assemble only the areas affected by some changes (see
+             * AreaDependencies). Objects that can't become a wanted area are
+             * rejected before looking at their tags. Area IDs are compared
+             * by their absolute value.
+             *
+             * Call this before the first pass. The set must be available
+             * until the second pass is done.
+             *
+             * @param area_ids The set of area IDs. Set to nullptr to
+             *                 assemble all areas again.
+             */
+            void set_area_filter(const osmium::index::IdSet<osmium::unsigned_object_id_type>* area_ids) noexcept {
+                m_area_filter = area_ids;
+            }
+
+            /**
+             * Ignore multipolygon relations with more than the given number
+             * of way members. They are rejected in the first pass, so their
+             * members are never collected.
+             *
+             * Call this before the first pass.
+             *
+             * @param max_way_members Maximum number of way members. Set to
+             *                        0 for no limit (the default).
+             */
+            void set_max_way_members(std::size_t max_way_members) noexcept {
+                m_max_way_members = max_way_members;
+            }
+
+            /**
+             * Set a function deciding in the first pass whether a relation
+             * should be assembled. It is called for relations of the right
+             * type matching the tags filter and must return false to
+             * reject the relation. Members of rejected relations are never
+             * collected.
+             *
+             * Call this before the first pass.
+             *
+             * @param filter The function. Set to nullptr to remove it.
+             */
+            void set_relation_filter(std::function<bool(const osmium::Relation&)> filter) {
+                m_relation_filter = std::move(filter);
+            }
+
+            /**
+             * Set a function checking the bounding box of a relation before
+             * it is assembled. It is called with the envelope of all member
+             * ways once the relation is complete and must return false to
+             * reject the relation, for instance if it is too large or
+             * outside the region of interest. No area is created for
+             * rejected relations, not even an empty one.
+             *
+             * @param check The function. Set to nullptr to remove it.
+             */
+            void set_envelope_check(std::function<bool(const osmium::Box&)> check) {
+                m_envelope_check = std::move(check);
+            }
+
+            /**
+             * Check before assembling a relation that the ends of all
+             * non-closed member ways meet an even number of other ends.
+             * Relations where this is not the case can't be assembled into
+             * a valid area and are rejected without calling the assembler.
+             * No area is created for them, not even an empty one, and no
+             * problems are reported.
+             */
+            void enable_ring_closure_check() noexcept {
+                m_ring_closure_check = true;
+            }
+
+            /**
+             * The number of relations rejected before assembly by the
+             * envelope check or ring closure check.
+             */
+            std::size_t rejected_relations() const noexcept {
+                return m_rejected_relations;
+            }
+
+            /**
+             * Add the results of all batches finished so far to the output
+             * buffer without waiting for the others. This is called
+             * automatically from flush_output().
+             */
+            void before_flush() {
+                while (!m_pending.empty() && oldest_result_ready()) {
+                    merge_oldest_result();
+                }
+            }
+
+            /**
+             * Finish assembling all outstanding batches and add the results
+             * to the output buffer. This is called automatically from
+             * read().
+             */
+            void before_read() {
+                finish_pending();
+            }
+
+            /**
+             * Finish assembling all outstanding batches and flush the output
+             * buffer. Call this after the second pass when using a thread
+             * pool (see set_thread_pool()) and a callback instead of read().
+             */
+            void finish_output() {
+                finish_pending();
+                this->flush_output();
+            }
+
             /**
              * Access the aggregated statistics generated by the assemblers
              * called from the manager.
@@ -108,9 +493,15 @@ namespace osmium {
 
             /**
              * We are interested in all relations tagged with type=multipolygon
-             * or type=boundary with at least one way member.
+             * or type=boundary with at least one way member, unless they are
+             * rejected by the checks configured with set_max_way_members()
+             * and set_relation_filter().
              */
             bool new_relation(const osmium::Relation& relation) const {
+                if (!area_wanted(relation.id(), osmium::item_type::relation)) {
+                    return false;
+                }
+
                 const char* type = relation.tags().get_value_by_key("type");
 
                 // ignore relations without "type" tag
@@ -119,9 +510,16 @@ namespace osmium {
                 }
 
                 if (((!std::strcmp(type, "multipolygon")) || (!std::strcmp(type, "boundary"))) && osmium::tags::match_any_of(relation.tags(), m_filter)) {
-                    return std::any_of(relation.members().cbegin(), relation.members().cend(), [](const RelationMember& member) {
+                    const auto num_ways = std::count_if(relation.members().cbegin(), relation.members().cend(), [](const RelationMember& member) {
                         return member.type() == osmium::item_type::way;
                     });
+                    if (num_ways == 0) {
+                        return false;
+                    }
+                    if (m_max_way_members > 0 && static_cast<std::size_t>(num_ways) > m_max_way_members) {
+                        return false;
+                    }
+                    return !m_relation_filter || m_relation_filter(relation);
                 }
 
                 return false;
@@ -142,10 +540,23 @@ namespace osmium {
                     }
                 }
 
+                if (!relation_looks_valid(ways)) {
+                    ++m_rejected_relations;
+                    return;
+                }
+
+                if (m_pool) {
+                    add_to_batch(relation);
+                    for (const auto* way : ways) {
+                        add_to_batch(*way);
+                    }
+                    batch_done();
+                    return;
+                }
+
                 try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
+                    m_assembler(relation, ways, this->buffer());
+                    m_stats += m_assembler.stats();
                 } catch (const osmium::invalid_location&) {
                     // XXX ignore
                 }
@@ -157,6 +568,10 @@ namespace osmium {
                     return;
                 }
 
+                if (!area_wanted(way.id(), osmium::item_type::way)) {
+                    return;
+                }
+
                 try {
                     if (!way.nodes().front().location() || !way.nodes().back().location()) {
                         throw osmium::invalid_location{"invalid location"};
@@ -170,9 +585,14 @@ namespace osmium {
                             return;
                         }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
+                        if (m_pool) {
+                            add_to_batch(way);
+                            batch_done();
+                            return;
+                        }
+
+                        m_assembler(way, this->buffer());
+                        m_stats += m_assembler.stats();
                         this->possibly_flush();
                     }
                 } catch (const osmium::invalid_location&) {
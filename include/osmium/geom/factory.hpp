@@ -45,10 +45,15 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -141,28 +146,157 @@ namespace osmium {
 
         }; // class IdentityProjection
 
+        /**
+         * This pseudo projection returns its WGS84 input unchanged like the
+         * IdentityProjection, but the coordinates stay in the fixed point
+         * integer format used by osmium::Location. Geometry implementations
+         * with overloads taking an osmium::Location (WKT and GeoJSON) write
+         * them out without ever converting to double, which is faster and
+         * gives exact, reproducible output. Other implementations get
+         * the location converted to Coordinates implicitly.
+         */
+        class FixedPointProjection {
+
+        public:
+
+            /**
+             * @throws osmium::invalid_location if the location is invalid.
+             */
+            osmium::Location operator()(osmium::Location location) const {
+                if (!location.valid()) {
+                    throw osmium::invalid_location{"invalid location"};
+                }
+                return location;
+            }
+
+            int epsg() const noexcept {
+                return 4326;
+            }
+
+            std::string proj_string() const {
+                return "+proj=longlat +datum=WGS84 +no_defs";
+            }
+
+        }; // class FixedPointProjection
+
+        namespace detail {
+
+            /**
+             * Checks whether a projection can transform a whole array of
+             * locations in one call, ie. if it has an operator() taking
+             * (const Location* begin, const Location* end, Coordinates* out).
+             */
+            template <typename TProjection>
+            struct has_array_projection {
+
+                template <typename T>
+                static std::true_type test(decltype(std::declval<const T&>()(static_cast<const osmium::Location*>(nullptr),
+                                                                             static_cast<const osmium::Location*>(nullptr),
+                                                                             static_cast<Coordinates*>(nullptr)))*);
+
+                template <typename T>
+                static std::false_type test(...);
+
+                using type = decltype(test<TProjection>(nullptr));
+
+            }; // struct has_array_projection
+
+            /**
+             * Append a fixed point coordinate as used in osmium::Location
+             * to a string, rounded to the given number of digits after the
+             * decimal point (half away from zero). Trailing zeros are
+             * removed. No floating point arithmetic is used.
+             */
+            inline void append_fixed_point(std::string& str, int32_t value, int precision) {
+                if (precision < 7) {
+                    int64_t factor = 1;
+                    for (int i = std::max(precision, 0); i < 7; ++i) {
+                        factor *= 10;
+                    }
+                    const int64_t half = value < 0 ? -factor / 2 : factor / 2;
+                    value = static_cast<int32_t>((value + half) / factor * factor);
+                }
+                osmium::detail::append_location_coordinate_to_string(std::back_inserter(str), value);
+            }
+
+        } // namespace detail
+
         /**
          * Geometry factory.
+         *
+         * If the projection can transform arrays of locations (see
+         * MercatorProjection for an example), all locations of a way or
+         * ring are first collected and then projected in one call.
          */
         template <typename TGeomImpl, typename TProjection = IdentityProjection>
         class GeometryFactory {
 
+            // Coordinates as returned by the projection, usually
+            // Coordinates, but osmium::Location for FixedPointProjection.
+            using coordinates_type = typename std::decay<decltype(std::declval<const TProjection&>()(std::declval<osmium::Location>()))>::type;
+
             /**
-             * Add all points of an outer or inner ring to a multipolygon.
+             * Project the locations of the node refs in [it, end) and
+             * call func with the resulting coordinates. If unique is set,
+             * consecutive nodes with the same location are only used once.
+             *
+             * @returns The number of points func was called with.
              */
-            void add_points(const osmium::NodeRefList& nodes) {
+            template <typename TIter, typename TFunc>
+            size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::false_type /*has_array_projection*/) {
+                size_t num_points = 0;
                 osmium::Location last_location;
-                for (const osmium::NodeRef& node_ref : nodes) {
-                    if (last_location != node_ref.location()) {
-                        last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
+                for (; it != end; ++it) {
+                    if (!unique || last_location != it->location()) {
+                        last_location = it->location();
+                        std::forward<TFunc>(func)(m_projection(last_location));
+                        ++num_points;
                     }
                 }
+                return num_points;
+            }
+
+            template <typename TIter, typename TFunc>
+            size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::true_type /*has_array_projection*/) {
+                m_locations.clear();
+                osmium::Location last_location;
+                for (; it != end; ++it) {
+                    if (!unique || last_location != it->location()) {
+                        last_location = it->location();
+                        m_locations.push_back(last_location);
+                    }
+                }
+
+                m_coordinates.resize(m_locations.size());
+                m_projection(m_locations.data(), m_locations.data() + m_locations.size(), m_coordinates.data());
+
+                for (const auto& coordinates : m_coordinates) {
+                    std::forward<TFunc>(func)(coordinates);
+                }
+                return m_coordinates.size();
+            }
+
+            template <typename TIter, typename TFunc>
+            size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func) {
+                return add_locations(it, end, unique, std::forward<TFunc>(func), typename detail::has_array_projection<TProjection>::type{});
+            }
+
+            /**
+             * Add all points of an outer or inner ring to a multipolygon.
+             */
+            void add_points(const osmium::NodeRefList& nodes) {
+                add_locations(nodes.cbegin(), nodes.cend(), true, [this](const coordinates_type& xy) {
+                    m_impl.multipolygon_add_location(xy);
+                });
             }
 
             TProjection m_projection;
             TGeomImpl m_impl;
 
+            // Buffers reused for projecting whole arrays of locations.
+            std::vector<osmium::Location> m_locations;
+            std::vector<Coordinates> m_coordinates;
+
         public:
 
             GeometryFactory<TGeomImpl, TProjection>() :
@@ -237,25 +371,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_linestring(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const coordinates_type& xy) {
+                    m_impl.linestring_add_location(xy);
+                });
             }
 
             template <typename TIter>
             size_t fill_linestring_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const coordinates_type& xy) {
+                    m_impl.linestring_add_location(xy);
+                });
             }
 
             linestring_type linestring_finish(size_t num_points) {
@@ -310,25 +435,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_polygon(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.polygon_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const coordinates_type& xy) {
+                    m_impl.polygon_add_location(xy);
+                });
             }
 
             template <typename TIter>
             size_t fill_polygon_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.polygon_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const coordinates_type& xy) {
+                    m_impl.polygon_add_location(xy);
+                });
             }
 
             polygon_type polygon_finish(size_t num_points) {
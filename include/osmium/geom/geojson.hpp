@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/osm/location.hpp>
 
 #include <cassert>
 #include <cstddef>
@@ -47,135 +48,294 @@ namespace osmium {
 
         namespace detail {
 
-            class GeoJSONFactoryImpl {
+            /**
+             * Common code for the GeoJSON factory implementations. The
+             * derived class has to implement the start_output() function
+             * returning the string the geometry is written to. The
+             * implementations only differ in who owns that string.
+             */
+            template <typename TDerived>
+            class GeoJSONFactoryImplBase {
 
-                std::string m_str;
                 int m_precision;
 
-            public:
+                std::string& start_output() {
+                    return static_cast<TDerived*>(this)->start_output();
+                }
 
-                using point_type        = std::string;
-                using linestring_type   = std::string;
-                using polygon_type      = std::string;
-                using multipolygon_type = std::string;
-                using ring_type         = std::string;
+                std::string& output() {
+                    return static_cast<TDerived*>(this)->output();
+                }
 
-                explicit GeoJSONFactoryImpl(int /*srid*/, int precision = 7) :
-                    m_precision(precision) {
+                static void append_location(std::string& str, const osmium::Location& location, int precision) {
+                    str += '[';
+                    detail::append_fixed_point(str, location.x(), precision);
+                    str += ',';
+                    detail::append_fixed_point(str, location.y(), precision);
+                    str += ']';
                 }
 
-                /* Point */
+                void add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(output(), '[', ',', ']', m_precision);
+                    output() += ',';
+                }
+
+                // Used with the FixedPointProjection
+                void add_location(const osmium::Location& location) {
+                    append_location(output(), location, m_precision);
+                    output() += ',';
+                }
+
+            protected:
+
+                explicit GeoJSONFactoryImplBase(int precision) :
+                    m_precision(precision) {
+                }
 
                 // { "type": "Point", "coordinates": [100.0, 0.0] }
-                point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str{"{\"type\":\"Point\",\"coordinates\":"};
+                void append_point(std::string& str, const osmium::geom::Coordinates& xy) const {
+                    str += "{\"type\":\"Point\",\"coordinates\":";
                     xy.append_to_string(str, '[', ',', ']', m_precision);
-                    str += "}";
-                    return str;
+                    str += '}';
+                }
+
+                void append_point(std::string& str, const osmium::Location& location) const {
+                    str += "{\"type\":\"Point\",\"coordinates\":";
+                    append_location(str, location, m_precision);
+                    str += '}';
+                }
+
+                void finish_linestring() {
+                    assert(!output().empty());
+                    output().back() = ']';
+                    output() += '}';
+                }
+
+                void finish_polygon() {
+                    assert(!output().empty());
+                    output().back() = ']';
+                    output() += "]}";
+                }
+
+                void finish_multipolygon() {
+                    assert(!output().empty());
+                    output().back() = ']';
+                    output() += '}';
                 }
 
+            public:
+
                 /* LineString */
 
                 // { "type": "LineString", "coordinates": [ [100.0, 0.0], [101.0, 1.0] ] }
                 void linestring_start() {
-                    m_str = "{\"type\":\"LineString\",\"coordinates\":[";
+                    start_output() += "{\"type\":\"LineString\",\"coordinates\":[";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                linestring_type linestring_finish(size_t /*num_points*/) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                void linestring_add_location(const osmium::Location& location) {
+                    add_location(location);
                 }
 
                 /* Polygon */
+
                 void polygon_start() {
-                    m_str = "{\"type\":\"Polygon\",\"coordinates\":[[";
+                    start_output() += "{\"type\":\"Polygon\",\"coordinates\":[[";
                 }
 
                 void polygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                polygon_type polygon_finish(size_t /*num_points*/) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ']';
-                    str += "]}";
-                    return str;
+                void polygon_add_location(const osmium::Location& location) {
+                    add_location(location);
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "{\"type\":\"MultiPolygon\",\"coordinates\":[";
+                    start_output() += "{\"type\":\"MultiPolygon\",\"coordinates\":[";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '[';
+                    output() += '[';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "],";
+                    output() += "],";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '[';
+                    output() += '[';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!output().empty());
+                    output().back() = ']';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",[";
+                    output() += ",[";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!output().empty());
+                    output().back() = ']';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
+                void multipolygon_add_location(const osmium::Location& location) {
+                    add_location(location);
+                }
+
+            }; // class GeoJSONFactoryImplBase
+
+            class GeoJSONFactoryImpl : public GeoJSONFactoryImplBase<GeoJSONFactoryImpl> {
+
+                friend class GeoJSONFactoryImplBase<GeoJSONFactoryImpl>;
+
+                std::string m_str;
+
+                std::string& start_output() {
+                    m_str.clear();
+                    return m_str;
+                }
+
+                std::string& output() noexcept {
+                    return m_str;
+                }
+
+                std::string release() {
                     std::string str;
 
                     using std::swap;
                     swap(str, m_str);
 
-                    str.back() = ']';
-                    str += "}";
                     return str;
                 }
 
+            public:
+
+                using point_type        = std::string;
+                using linestring_type   = std::string;
+                using polygon_type      = std::string;
+                using multipolygon_type = std::string;
+                using ring_type         = std::string;
+
+                explicit GeoJSONFactoryImpl(int /*srid*/, int precision = 7) :
+                    GeoJSONFactoryImplBase<GeoJSONFactoryImpl>(precision) {
+                }
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    std::string str;
+                    append_point(str, xy);
+                    return str;
+                }
+
+                // Used with the FixedPointProjection
+                point_type make_point(const osmium::Location& location) const {
+                    std::string str;
+                    append_point(str, location);
+                    return str;
+                }
+
+                linestring_type linestring_finish(size_t /*num_points*/) {
+                    finish_linestring();
+                    return release();
+                }
+
+                polygon_type polygon_finish(size_t /*num_points*/) {
+                    finish_polygon();
+                    return release();
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    finish_multipolygon();
+                    return release();
+                }
+
             }; // class GeoJSONFactoryImpl
 
+            /**
+             * GeoJSON factory implementation appending all geometries to a
+             * string owned by the caller instead of returning a new string
+             * for each geometry. This way a whole FeatureCollection can be
+             * written into one string without copying each geometry.
+             *
+             * If creating a geometry fails with an exception, part of the
+             * geometry might already have been written. Remember the size
+             * of the string before creating the geometry and resize the
+             * string to it in that case.
+             */
+            class GeoJSONAppendFactoryImpl : public GeoJSONFactoryImplBase<GeoJSONAppendFactoryImpl> {
+
+                friend class GeoJSONFactoryImplBase<GeoJSONAppendFactoryImpl>;
+
+                std::string* m_out;
+
+                std::string& start_output() noexcept {
+                    return *m_out;
+                }
+
+                std::string& output() noexcept {
+                    return *m_out;
+                }
+
+            public:
+
+                using point_type        = void;
+                using linestring_type   = void;
+                using polygon_type      = void;
+                using multipolygon_type = void;
+                using ring_type         = void;
+
+                GeoJSONAppendFactoryImpl(int /*srid*/, std::string& out, int precision = 7) :
+                    GeoJSONFactoryImplBase<GeoJSONAppendFactoryImpl>(precision),
+                    m_out(&out) {
+                }
+
+                void make_point(const osmium::geom::Coordinates& xy) const {
+                    append_point(*m_out, xy);
+                }
+
+                // Used with the FixedPointProjection
+                void make_point(const osmium::Location& location) const {
+                    append_point(*m_out, location);
+                }
+
+                void linestring_finish(size_t /*num_points*/) {
+                    finish_linestring();
+                }
+
+                void polygon_finish(size_t /*num_points*/) {
+                    finish_polygon();
+                }
+
+                void multipolygon_finish() {
+                    finish_multipolygon();
+                }
+
+            }; // class GeoJSONAppendFactoryImpl
+
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
         using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl, TProjection>;
 
+        /**
+         * GeoJSON factory appending the geometries to a caller-owned
+         * string. Construct with the string and optionally the precision.
+         * The create_*() functions return nothing.
+         */
+        template <typename TProjection = IdentityProjection>
+        using GeoJSONAppendFactory = GeometryFactory<osmium::geom::detail::GeoJSONAppendFactoryImpl, TProjection>;
+
     } // namespace geom
 
 } // namespace osmium
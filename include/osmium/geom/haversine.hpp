@@ -35,10 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/util.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
 #include <osmium/osm/way.hpp>
 
 #include <cmath>
+#include <cstddef>
 #include <iterator>
 
 namespace osmium {
@@ -48,6 +52,9 @@ namespace osmium {
         /**
          * @brief Functions to calculate arc distance on Earth using the haversine formula.
          *
+         * The area functions in this namespace use the same spherical
+         * model of the Earth.
+         *
          * See https://en.wikipedia.org/wiki/Haversine_formula
          *
          * Implementation derived from
@@ -72,19 +79,215 @@ namespace osmium {
                 return 2.0 * EARTH_RADIUS_IN_METERS * asin(sqrt(lath + tmp * lonh));
             }
 
+            namespace detail {
+
+                inline osmium::Location location_of(const osmium::Location& location) noexcept {
+                    return location;
+                }
+
+                inline osmium::Location location_of(const osmium::NodeRef& node_ref) noexcept {
+                    return node_ref.location();
+                }
+
+                // Polynomial approximation of cos(x) for |x| <= PI/2 (Taylor
+                // series up to x^14), absolute error below 1e-10.
+                inline constexpr double cos_approx(double x) noexcept {
+                    return 1.0 + x * x * (-1.0 / 2 + x * x * (1.0 / 24 + x * x * (-1.0 / 720 + x * x * (1.0 / 40320 +
+                           x * x * (-1.0 / 3628800 + x * x * (1.0 / 479001600 + x * x * (-1.0 / 87178291200.0)))))));
+                }
+
+                // Polynomial approximation of sin(x) for |x| <= PI/2 (Taylor
+                // series up to x^15), absolute error below 1e-11.
+                inline constexpr double sin_approx(double x) noexcept {
+                    return x * (1.0 + x * x * (-1.0 / 6 + x * x * (1.0 / 120 + x * x * (-1.0 / 5040 + x * x * (1.0 / 362880 +
+                           x * x * (-1.0 / 39916800 + x * x * (1.0 / 6227020800.0 + x * x * (-1.0 / 1307674368000.0))))))));
+                }
+
+                // Computes the same result as calling distance() for each
+                // pair of locations, but only needs one cos() per location.
+                template <typename TIter>
+                double distance(TIter it, TIter end) {
+                    if (it == end) {
+                        return 0.0;
+                    }
+
+                    osmium::geom::Coordinates prev{location_of(*it)};
+                    double prev_cos = cos(deg_to_rad(prev.y));
+
+                    double sum_length = 0;
+                    for (++it; it != end; ++it) {
+                        const osmium::geom::Coordinates c{location_of(*it)};
+                        const double c_cos = cos(deg_to_rad(c.y));
+
+                        double lonh = sin(deg_to_rad(prev.x - c.x) * 0.5);
+                        lonh *= lonh;
+                        double lath = sin(deg_to_rad(prev.y - c.y) * 0.5);
+                        lath *= lath;
+                        const double tmp = prev_cos * c_cos;
+                        sum_length += 2.0 * EARTH_RADIUS_IN_METERS * asin(sqrt(lath + tmp * lonh));
+
+                        prev = c;
+                        prev_cos = c_cos;
+                    }
+
+                    return sum_length;
+                }
+
+                template <typename TIter>
+                double approximate_distance(TIter it, TIter end) {
+                    if (it == end) {
+                        return 0.0;
+                    }
+
+                    osmium::Location prev{location_of(*it)};
+                    bool valid = prev.valid();
+                    double prev_lat = deg_to_rad(prev.lat_without_check());
+                    double prev_cos = cos_approx(prev_lat);
+
+                    double sum = 0;
+                    for (++it; it != end; ++it) {
+                        const osmium::Location location{location_of(*it)};
+                        valid &= location.valid();
+
+                        const double lat = deg_to_rad(location.lat_without_check());
+                        const double lat_cos = cos_approx(lat);
+                        const double dx = deg_to_rad(location.lon_without_check() - prev.lon_without_check()) * (prev_cos + lat_cos) * 0.5;
+                        const double dy = lat - prev_lat;
+                        sum += std::sqrt(dx * dx + dy * dy);
+
+                        prev = location;
+                        prev_lat = lat;
+                        prev_cos = lat_cos;
+                    }
+
+                    if (!valid) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+
+                    return EARTH_RADIUS_IN_METERS * sum;
+                }
+
+                template <typename TIter>
+                double area(TIter it, TIter end) {
+                    if (it == end) {
+                        return 0.0;
+                    }
+
+                    osmium::Location prev{location_of(*it)};
+                    bool valid = prev.valid();
+                    double prev_sin = sin_approx(deg_to_rad(prev.lat_without_check()));
+
+                    double sum = 0;
+                    for (++it; it != end; ++it) {
+                        const osmium::Location location{location_of(*it)};
+                        valid &= location.valid();
+
+                        const double lat_sin = sin_approx(deg_to_rad(location.lat_without_check()));
+                        sum += deg_to_rad(location.lon_without_check() - prev.lon_without_check()) * (prev_sin + lat_sin);
+
+                        prev = location;
+                        prev_sin = lat_sin;
+                    }
+
+                    if (!valid) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+
+                    return -sum * EARTH_RADIUS_IN_METERS * EARTH_RADIUS_IN_METERS / 2;
+                }
+
+            } // namespace detail
+
             /**
              * Calculate length of way.
              */
             inline double distance(const osmium::WayNodeList& wnl) {
-                double sum_length = 0;
+                return detail::distance(wnl.cbegin(), wnl.cend());
+            }
 
-                for (auto it = wnl.begin(); it != wnl.end(); ++it) {
-                    if (std::next(it) != wnl.end()) {
-                        sum_length += distance(it->location(), std::next(it)->location());
+            /**
+             * Calculate length of the line through count locations.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double distance(const osmium::Location* locations, std::size_t count) {
+                return detail::distance(locations, locations + count);
+            }
+
+            /**
+             * Calculate the approximate length of a way. Instead of the
+             * haversine formula this uses the equirectangular approximation
+             * for each segment which needs no trigonometric functions from
+             * the math library and is several times faster.
+             *
+             * Between 80 degrees south and north the relative error compared
+             * to distance() for each segment is below 1e-7 for segments up to
+             * 1 km long, below 1e-5 up to 10 km and below 0.1% up to 100 km.
+             * It gets larger closer to the poles, for 10 km segments up to
+             * 0.04% at 89 degrees. Segments in OSM are usually short.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double approximate_distance(const osmium::WayNodeList& wnl) {
+                return detail::approximate_distance(wnl.cbegin(), wnl.cend());
+            }
+
+            /**
+             * Calculate the approximate length of the line through count
+             * locations. See approximate_distance(const WayNodeList&) for
+             * details.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double approximate_distance(const osmium::Location* locations, std::size_t count) {
+                return detail::approximate_distance(locations, locations + count);
+            }
+
+            /**
+             * Calculate the area of a ring on the sphere in square meters
+             * using the formula from Chamberlain and Duquette, "Some
+             * Algorithms for Polygons on a Sphere". The result is positive
+             * for counterclockwise and negative for clockwise rings. The
+             * ring must be closed (first and last location the same).
+             *
+             * No trigonometric functions from the math library are called,
+             * sin() is computed with a polynomial approximation which is
+             * accurate to better than 1e-11.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double area(const osmium::Location* locations, std::size_t count) {
+                return detail::area(locations, locations + count);
+            }
+
+            /**
+             * Calculate the area of a ring on the sphere in square meters.
+             * See area(const osmium::Location*, std::size_t) for details.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double area(const osmium::NodeRefList& ring) {
+                return detail::area(ring.cbegin(), ring.cend());
+            }
+
+            /**
+             * Calculate the area of an osmium::Area on the sphere in square
+             * meters. This is the sum of the areas of the outer rings minus
+             * the areas of the inner rings. The orientation of the rings
+             * doesn't matter.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            inline double area(const osmium::Area& osm_area) {
+                double sum = 0;
+                for (const auto& item : osm_area) {
+                    if (item.type() == osmium::item_type::outer_ring) {
+                        sum += std::abs(haversine::area(static_cast<const osmium::OuterRing&>(item)));
+                    } else if (item.type() == osmium::item_type::inner_ring) {
+                        sum -= std::abs(haversine::area(static_cast<const osmium::InnerRing&>(item)));
                     }
                 }
-
-                return sum_length;
+                return sum;
             }
 
         } // namespace haversine
@@ -38,6 +38,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/location.hpp>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace osmium {
@@ -66,11 +68,8 @@ namespace osmium {
             // This is a much faster implementation than the canonical
             // implementation using the tan() function. For details
             // see https://github.com/osmcode/mercator-projection .
-            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
-                if (lat < -78.0 || lat > 78.0) {
-                    return lat_to_y_with_tan(lat);
-                }
-
+            // Only precise enough for latitudes between -78 and +78.
+            constexpr inline double lat_to_y_approx(double lat) noexcept {
                 return earth_radius_for_epsg3857 *
                     ((((((((((-3.1112583378460085319e-23  * lat +
                                2.0465852743943268009e-19) * lat +
@@ -94,6 +93,14 @@ namespace osmium {
                               -3.4554675198786337842e-4)  * lat +
                               -5.4367203601085991108e-4)  * lat + 1.0);
             }
+
+            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
+                if (lat < -78.0 || lat > 78.0) {
+                    return lat_to_y_with_tan(lat);
+                }
+
+                return lat_to_y_approx(lat);
+            }
 #endif
 
             constexpr inline double x_to_lon(double x) {
@@ -124,6 +131,61 @@ namespace osmium {
             return Coordinates{detail::lon_to_x(c.x), detail::lat_to_y(c.y)};
         }
 
+        /**
+         * Convert an array of locations from WGS84 lon/lat to web mercator.
+         * This gives the same results as converting the locations one by
+         * one, but the loop is written without branches in its body so
+         * that the compiler can vectorize it. The few latitudes outside
+         * the range of the fast approximation are fixed up afterwards.
+         *
+         * @param locations Pointer to the first of the locations.
+         * @param count Number of locations.
+         * @param out Pointer to array of at least count coordinates where
+         *            the results are written to.
+         * @throws osmium::invalid_location if any of the locations is
+         *         invalid. The contents of out are undefined in this case.
+         * @pre Coordinates must be in valid range, longitude between
+         *      -180 and +180 degree, latitude between -MERCATOR_MAX_LAT
+         *      and MERCATOR_MAX_LAT.
+         */
+        inline void lonlat_to_mercator(const osmium::Location* locations, std::size_t count, Coordinates* out) {
+            constexpr const int32_t max_lon = 180 * osmium::detail::coordinate_precision;
+            constexpr const int32_t max_lat = 90 * osmium::detail::coordinate_precision;
+#ifndef OSMIUM_USE_SLOW_MERCATOR_PROJECTION
+            constexpr const int32_t max_approx = 78 * osmium::detail::coordinate_precision;
+#endif
+
+            // Bitwise operators instead of && and || keep the loop body
+            // free of branches.
+            int invalid = 0;
+            int fixup = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                const int32_t x = locations[i].x();
+                const int32_t y = locations[i].y();
+                invalid |= static_cast<int>(x < -max_lon) | static_cast<int>(x > max_lon) | static_cast<int>(y < -max_lat) | static_cast<int>(y > max_lat);
+                out[i].x = detail::lon_to_x(locations[i].lon_without_check());
+#ifdef OSMIUM_USE_SLOW_MERCATOR_PROJECTION
+                out[i].y = detail::lat_to_y_with_tan(locations[i].lat_without_check());
+#else
+                fixup |= static_cast<int>(y < -max_approx) | static_cast<int>(y > max_approx);
+                out[i].y = detail::lat_to_y_approx(locations[i].lat_without_check());
+#endif
+            }
+
+            if (invalid) {
+                throw osmium::invalid_location{"invalid location"};
+            }
+
+            if (fixup) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    const double lat = locations[i].lat_without_check();
+                    if (lat < -78.0 || lat > 78.0) {
+                        out[i].y = detail::lat_to_y_with_tan(lat);
+                    }
+                }
+            }
+        }
+
         /**
          * Convert the coordinates from web mercator to WGS84 lon/lat.
          *
@@ -161,6 +223,18 @@ namespace osmium {
                 return Coordinates{detail::lon_to_x(location.lon()), detail::lat_to_y(location.lat())};
             }
 
+            /**
+             * Do coordinate transformation for all locations in the range
+             * [begin, end) and write the results to out. See
+             * lonlat_to_mercator() for details.
+             *
+             * @throws osmium::invalid_location if any of the locations is
+             *         invalid.
+             */
+            void operator()(const osmium::Location* begin, const osmium::Location* end, Coordinates* out) const {
+                lonlat_to_mercator(begin, static_cast<std::size_t>(end - begin), out);
+            }
+
             int epsg() const noexcept {
                 return 3857;
             }
@@ -0,0 +1,509 @@
+#ifndef OSMIUM_GEOM_MVT_HPP
+#define OSMIUM_GEOM_MVT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Commands used in Mapbox Vector Tile geometries.
+             */
+            enum mvt_command : uint32_t {
+                mvt_move_to    = 1,
+                mvt_line_to    = 2,
+                mvt_close_path = 7
+            }; // enum mvt_command
+
+            inline constexpr uint32_t mvt_command_integer(mvt_command command, uint32_t count) noexcept {
+                return (static_cast<uint32_t>(command) & 0x7u) | (count << 3u);
+            }
+
+            inline constexpr uint32_t mvt_zigzag(int32_t value) noexcept {
+                return (static_cast<uint32_t>(value) << 1u) ^ static_cast<uint32_t>(value >> 31);
+            }
+
+            /// A point in the (integer) coordinate system of a tile.
+            struct tile_point {
+                int64_t x;
+                int64_t y;
+            }; // struct tile_point
+
+            inline bool operator==(const tile_point& lhs, const tile_point& rhs) noexcept {
+                return lhs.x == rhs.x && lhs.y == rhs.y;
+            }
+
+            inline bool operator!=(const tile_point& lhs, const tile_point& rhs) noexcept {
+                return !(lhs == rhs);
+            }
+
+            /**
+             * Geometry implementation for the GeometryFactory creating
+             * geometries encoded as in Mapbox Vector Tiles (commands with
+             * zigzag-encoded deltas) for a single tile. Geometries are
+             * clipped to the tile extent plus a buffer. Polygon rings are
+             * oriented as the MVT spec requires (outer rings have positive
+             * area in tile coordinates).
+             *
+             * All geometry types are vectors of uint32_t. They can be
+             * written as the "geometry" field of a vector tile feature,
+             * for instance with protozero::pbf_writer::add_packed_uint32().
+             * If nothing of the geometry is inside the clipping area, the
+             * vector is empty.
+             */
+            class MVTFactoryImpl {
+
+                std::vector<uint32_t> m_geometry;
+
+                // Points of the current linestring or ring
+                std::vector<tile_point> m_points;
+
+                // Temporary storage for clipping
+                std::vector<tile_point> m_clipped;
+                std::vector<tile_point> m_temp;
+
+                double m_scale;
+                int64_t m_offset_x;
+                int64_t m_offset_y;
+                int64_t m_min;
+                int64_t m_max;
+
+                int32_t m_cursor_x = 0;
+                int32_t m_cursor_y = 0;
+
+                bool m_skip_inner_rings = false;
+
+                tile_point to_tile(const osmium::geom::Coordinates& xy) const {
+                    return tile_point{
+                        static_cast<int64_t>(std::llround((xy.x + max_coordinate_epsg3857) * m_scale)) - m_offset_x,
+                        static_cast<int64_t>(std::llround((max_coordinate_epsg3857 - xy.y) * m_scale)) - m_offset_y
+                    };
+                }
+
+                bool inside(const tile_point& point) const noexcept {
+                    return point.x >= m_min && point.x <= m_max &&
+                           point.y >= m_min && point.y <= m_max;
+                }
+
+                bool all_inside(const std::vector<tile_point>& points) const noexcept {
+                    return std::all_of(points.cbegin(), points.cend(), [this](const tile_point& point) {
+                        return inside(point);
+                    });
+                }
+
+                int64_t clamp_to_box(double value) const noexcept {
+                    return clamp<int64_t>(static_cast<int64_t>(std::llround(value)), m_min, m_max);
+                }
+
+                void reset() {
+                    m_geometry.clear();
+                    m_points.clear();
+                    m_cursor_x = 0;
+                    m_cursor_y = 0;
+                }
+
+                void add_point(const osmium::geom::Coordinates& xy) {
+                    const tile_point point{to_tile(xy)};
+                    if (m_points.empty() || m_points.back() != point) {
+                        m_points.push_back(point);
+                    }
+                }
+
+                void add_delta(const tile_point& point) {
+                    const auto x = static_cast<int32_t>(point.x);
+                    const auto y = static_cast<int32_t>(point.y);
+                    m_geometry.push_back(mvt_zigzag(x - m_cursor_x));
+                    m_geometry.push_back(mvt_zigzag(y - m_cursor_y));
+                    m_cursor_x = x;
+                    m_cursor_y = y;
+                }
+
+                // Encode points as one MoveTo and one LineTo command and
+                // add a ClosePath command for rings.
+                void encode(const std::vector<tile_point>& points, bool ring) {
+                    assert(points.size() >= 2);
+                    m_geometry.push_back(mvt_command_integer(mvt_move_to, 1));
+                    add_delta(points.front());
+                    m_geometry.push_back(mvt_command_integer(mvt_line_to, static_cast<uint32_t>(points.size() - 1)));
+                    for (auto it = std::next(points.cbegin()); it != points.cend(); ++it) {
+                        add_delta(*it);
+                    }
+                    if (ring) {
+                        m_geometry.push_back(mvt_command_integer(mvt_close_path, 1));
+                    }
+                }
+
+                /**
+                 * Clip the segment from a to b to the clipping box using
+                 * the Liang-Barsky algorithm. Returns false if the segment
+                 * is completely outside.
+                 */
+                bool clip_segment(tile_point& a, tile_point& b) const {
+                    const int64_t dx = b.x - a.x;
+                    const int64_t dy = b.y - a.y;
+                    const int64_t p[4] = {-dx, dx, -dy, dy};
+                    const int64_t q[4] = {a.x - m_min, m_max - a.x, a.y - m_min, m_max - a.y};
+
+                    double t0 = 0.0;
+                    double t1 = 1.0;
+                    for (int i = 0; i < 4; ++i) {
+                        if (p[i] == 0) {
+                            if (q[i] < 0) {
+                                return false;
+                            }
+                        } else {
+                            const double r = static_cast<double>(q[i]) / static_cast<double>(p[i]);
+                            if (p[i] < 0) {
+                                if (r > t1) {
+                                    return false;
+                                }
+                                t0 = std::max(t0, r);
+                            } else {
+                                if (r < t0) {
+                                    return false;
+                                }
+                                t1 = std::min(t1, r);
+                            }
+                        }
+                    }
+
+                    const tile_point start{a};
+                    if (t0 > 0.0) {
+                        a = tile_point{clamp_to_box(static_cast<double>(start.x) + t0 * static_cast<double>(dx)),
+                                       clamp_to_box(static_cast<double>(start.y) + t0 * static_cast<double>(dy))};
+                    }
+                    if (t1 < 1.0) {
+                        b = tile_point{clamp_to_box(static_cast<double>(start.x) + t1 * static_cast<double>(dx)),
+                                       clamp_to_box(static_cast<double>(start.y) + t1 * static_cast<double>(dy))};
+                    }
+                    return true;
+                }
+
+                void flush_part() {
+                    if (m_clipped.size() >= 2) {
+                        encode(m_clipped, false);
+                    }
+                    m_clipped.clear();
+                }
+
+                void finish_linestring() {
+                    if (m_points.size() < 2) {
+                        return;
+                    }
+
+                    if (all_inside(m_points)) {
+                        encode(m_points, false);
+                        return;
+                    }
+
+                    m_clipped.clear();
+                    for (std::size_t i = 1; i < m_points.size(); ++i) {
+                        tile_point a{m_points[i - 1]};
+                        tile_point b{m_points[i]};
+                        if (!clip_segment(a, b)) {
+                            flush_part();
+                            continue;
+                        }
+                        if (m_clipped.empty() || m_clipped.back() != a) {
+                            flush_part();
+                            m_clipped.push_back(a);
+                        }
+                        if (m_clipped.back() != b) {
+                            m_clipped.push_back(b);
+                        }
+                    }
+                    flush_part();
+                }
+
+                /**
+                 * One step of the Sutherland-Hodgman algorithm: Clip ring
+                 * in "in" against one edge of the clipping box.
+                 */
+                template <typename TInside, typename TIntersect>
+                static void clip_ring_at_edge(const std::vector<tile_point>& in, std::vector<tile_point>& out, TInside&& is_inside, TIntersect&& intersect) {
+                    out.clear();
+                    if (in.empty()) {
+                        return;
+                    }
+
+                    tile_point prev{in.back()};
+                    bool prev_inside = is_inside(prev);
+                    for (const auto& point : in) {
+                        const bool point_inside = is_inside(point);
+                        if (point_inside != prev_inside) {
+                            out.push_back(intersect(prev, point));
+                        }
+                        if (point_inside) {
+                            out.push_back(point);
+                        }
+                        prev = point;
+                        prev_inside = point_inside;
+                    }
+                }
+
+                tile_point intersect_vertical(const tile_point& a, const tile_point& b, int64_t x) const {
+                    const double t = static_cast<double>(x - a.x) / static_cast<double>(b.x - a.x);
+                    return tile_point{x, clamp_to_box(static_cast<double>(a.y) + t * static_cast<double>(b.y - a.y))};
+                }
+
+                tile_point intersect_horizontal(const tile_point& a, const tile_point& b, int64_t y) const {
+                    const double t = static_cast<double>(y - a.y) / static_cast<double>(b.y - a.y);
+                    return tile_point{clamp_to_box(static_cast<double>(a.x) + t * static_cast<double>(b.x - a.x)), y};
+                }
+
+                void clip_ring() {
+                    const int64_t min = m_min;
+                    const int64_t max = m_max;
+                    clip_ring_at_edge(m_points, m_temp, [min](const tile_point& p) { return p.x >= min; },
+                                      [this, min](const tile_point& a, const tile_point& b) { return intersect_vertical(a, b, min); });
+                    clip_ring_at_edge(m_temp, m_clipped, [max](const tile_point& p) { return p.x <= max; },
+                                      [this, max](const tile_point& a, const tile_point& b) { return intersect_vertical(a, b, max); });
+                    clip_ring_at_edge(m_clipped, m_temp, [min](const tile_point& p) { return p.y >= min; },
+                                      [this, min](const tile_point& a, const tile_point& b) { return intersect_horizontal(a, b, min); });
+                    clip_ring_at_edge(m_temp, m_clipped, [max](const tile_point& p) { return p.y <= max; },
+                                      [this, max](const tile_point& a, const tile_point& b) { return intersect_horizontal(a, b, max); });
+
+                    // remove consecutive duplicate points created by clipping
+                    m_clipped.erase(std::unique(m_clipped.begin(), m_clipped.end()), m_clipped.end());
+                    while (m_clipped.size() > 1 && m_clipped.front() == m_clipped.back()) {
+                        m_clipped.pop_back();
+                    }
+                }
+
+                // Twice the area of the ring with the sign as used in the
+                // MVT spec.
+                static int64_t ring_area(const std::vector<tile_point>& points) noexcept {
+                    int64_t area = 0;
+                    tile_point prev{points.back()};
+                    for (const auto& point : points) {
+                        area += prev.x * point.y - point.x * prev.y;
+                        prev = point;
+                    }
+                    return area;
+                }
+
+                /**
+                 * Clip, orient, and encode the ring in m_points.
+                 *
+                 * @returns false if nothing of the ring is left.
+                 */
+                bool finish_ring(bool outer) {
+                    // the ring is stored without the closing point
+                    while (m_points.size() > 1 && m_points.front() == m_points.back()) {
+                        m_points.pop_back();
+                    }
+
+                    if (all_inside(m_points)) {
+                        using std::swap;
+                        swap(m_points, m_clipped);
+                    } else {
+                        clip_ring();
+                    }
+
+                    if (m_clipped.size() < 3) {
+                        return false;
+                    }
+
+                    const auto area = ring_area(m_clipped);
+                    if (area == 0) {
+                        return false;
+                    }
+                    if ((area > 0) != outer) {
+                        std::reverse(m_clipped.begin(), m_clipped.end());
+                    }
+
+                    encode(m_clipped, true);
+                    return true;
+                }
+
+                std::vector<uint32_t> result() {
+                    std::vector<uint32_t> geometry;
+
+                    using std::swap;
+                    swap(geometry, m_geometry);
+
+                    return geometry;
+                }
+
+            public:
+
+                using point_type        = std::vector<uint32_t>;
+                using linestring_type   = std::vector<uint32_t>;
+                using polygon_type      = std::vector<uint32_t>;
+                using multipolygon_type = std::vector<uint32_t>;
+                using ring_type         = std::vector<uint32_t>;
+
+                /**
+                 * @param srid Must be 3857, use the MercatorProjection.
+                 * @param tile The tile the geometries are created for.
+                 * @param extent Number of units in each direction of the
+                 *               tile.
+                 * @param buffer Number of units around the tile extent
+                 *               which are kept when clipping.
+                 * @throws std::invalid_argument If the srid is not 3857 or
+                 *                               the extent is 0.
+                 */
+                explicit MVTFactoryImpl(int srid, const osmium::geom::Tile& tile, uint32_t extent = 4096, uint32_t buffer = 64) :
+                    m_scale(static_cast<double>(extent) / tile_extent_in_zoom(tile.z)),
+                    m_offset_x(static_cast<int64_t>(tile.x) * extent),
+                    m_offset_y(static_cast<int64_t>(tile.y) * extent),
+                    m_min(-static_cast<int64_t>(buffer)),
+                    m_max(static_cast<int64_t>(extent) + buffer) {
+                    if (srid != 3857) {
+                        throw std::invalid_argument{"MVT factory needs Mercator projection"};
+                    }
+                    if (extent == 0) {
+                        throw std::invalid_argument{"MVT extent must be larger than 0"};
+                    }
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    const tile_point point{to_tile(xy)};
+                    if (!inside(point)) {
+                        return {};
+                    }
+                    return {mvt_command_integer(mvt_move_to, 1),
+                            mvt_zigzag(static_cast<int32_t>(point.x)),
+                            mvt_zigzag(static_cast<int32_t>(point.y))};
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    reset();
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    add_point(xy);
+                }
+
+                linestring_type linestring_finish(size_t /*num_points*/) {
+                    finish_linestring();
+                    return result();
+                }
+
+                /* Polygon */
+
+                void polygon_start() {
+                    reset();
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    add_point(xy);
+                }
+
+                polygon_type polygon_finish(size_t /*num_points*/) {
+                    finish_ring(true);
+                    return result();
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    reset();
+                }
+
+                void multipolygon_polygon_start() {
+                }
+
+                void multipolygon_polygon_finish() {
+                }
+
+                void multipolygon_outer_ring_start() {
+                    m_points.clear();
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    // inner rings of an outer ring outside the tile are dropped
+                    m_skip_inner_rings = !finish_ring(true);
+                }
+
+                void multipolygon_inner_ring_start() {
+                    m_points.clear();
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    if (!m_skip_inner_rings) {
+                        finish_ring(false);
+                    }
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    add_point(xy);
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    return result();
+                }
+
+            }; // class MVTFactoryImpl
+
+        } // namespace detail
+
+        /**
+         * Geometry factory creating Mapbox Vector Tile geometries for one
+         * tile. Create it with the tile and optionally the extent (default
+         * 4096) and buffer (default 64):
+         *
+         * @code
+         * osmium::geom::MVTFactory<> factory{osmium::geom::Tile{14, x, y}};
+         * @endcode
+         */
+        template <typename TProjection = MercatorProjection>
+        using MVTFactory = GeometryFactory<osmium::geom::detail::MVTFactoryImpl, TProjection>;
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_MVT_HPP
@@ -33,8 +33,13 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/osm/area.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <cstdint>
 
 namespace osmium {
 
@@ -60,6 +65,54 @@ namespace osmium {
                     (rhs.bottom_left().y() <= lhs.top_right().y()));
         }
 
+        /**
+         * Check whether a location is inside an area. Uses the even-odd
+         * rule on all (outer and inner) rings, so it doesn't matter which
+         * outer ring an inner ring belongs to. Calculations are done in
+         * integers, so the result is exact, but for locations exactly on
+         * the boundary of the area it is unspecified.
+         *
+         * All locations in the area and the location must be valid.
+         */
+        inline bool within(const osmium::Location& location, const osmium::Area& area) noexcept {
+            const int64_t x = location.x();
+            const int64_t y = location.y();
+            bool inside = false;
+
+            for (const auto& item : area) {
+                if (item.type() != osmium::item_type::outer_ring &&
+                    item.type() != osmium::item_type::inner_ring) {
+                    continue;
+                }
+                const auto& ring = static_cast<const osmium::NodeRefList&>(item);
+                if (ring.empty()) {
+                    continue;
+                }
+                // Rings in areas are closed, first and last node are the same.
+                auto it = ring.cbegin();
+                int64_t ax = it->location().x();
+                int64_t ay = it->location().y();
+                for (++it; it != ring.cend(); ++it) {
+                    const int64_t bx = it->location().x();
+                    const int64_t by = it->location().y();
+                    if ((ay > y) != (by > y)) {
+                        // Does the edge cross the horizontal ray going
+                        // from the location to the right? The products
+                        // fit into 64 bits for all valid coordinates.
+                        const int64_t lhs = (x - ax) * (by - ay);
+                        const int64_t rhs = (y - ay) * (bx - ax);
+                        if (by > ay ? lhs < rhs : lhs > rhs) {
+                            inside = !inside;
+                        }
+                    }
+                    ax = bx;
+                    ay = by;
+                }
+            }
+
+            return inside;
+        }
+
     } // namespace geom
 
 } // namespace osmium
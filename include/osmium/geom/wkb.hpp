@@ -63,16 +63,21 @@ namespace osmium {
                 str.append(reinterpret_cast<const char*>(&data), sizeof(T));
             }
 
-            inline std::string convert_to_hex(const std::string& str) {
+            inline void append_hex(std::string& out, const std::string& str) {
                 static const char* lookup_hex = "0123456789ABCDEF";
-                std::string out;
-                out.reserve(str.size() * 2);
+                const auto size = out.size();
+                out.resize(size + str.size() * 2);
 
+                char* p = &out[size];
                 for (char c : str) {
-                    out += lookup_hex[(static_cast<unsigned int>(c) >> 4u) & 0xfu];
-                    out += lookup_hex[ static_cast<unsigned int>(c)        & 0xfu];
+                    *p++ = lookup_hex[(static_cast<unsigned int>(c) >> 4u) & 0xfu];
+                    *p++ = lookup_hex[ static_cast<unsigned int>(c)        & 0xfu];
                 }
+            }
 
+            inline std::string convert_to_hex(const std::string& str) {
+                std::string out;
+                append_hex(out, str);
                 return out;
             }
 
@@ -162,11 +167,18 @@ namespace osmium {
 
                 /* Point */
 
+                /**
+                 * Append binary WKB for a point to the string.
+                 */
+                void append_point(const osmium::geom::Coordinates& xy, std::string& out) const {
+                    header(out, wkbPoint, false);
+                    str_push(out, xy.x);
+                    str_push(out, xy.y);
+                }
+
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
                     std::string data;
-                    header(data, wkbPoint, false);
-                    str_push(data, xy.x);
-                    str_push(data, xy.y);
+                    append_point(xy, data);
 
                     if (m_out_type == out_type::hex) {
                         return convert_to_hex(data);
@@ -187,6 +199,17 @@ namespace osmium {
                     str_push(m_data, xy.y);
                 }
 
+                /**
+                 * Finish the linestring and return a reference to the
+                 * binary WKB. It is valid until the next geometry is
+                 * started. This reuses the internal buffer instead of
+                 * creating a new string for each geometry.
+                 */
+                const std::string& linestring_finish_ref(std::size_t num_points) {
+                    set_size(m_linestring_size_offset, num_points);
+                    return m_data;
+                }
+
                 linestring_type linestring_finish(std::size_t num_points) {
                     set_size(m_linestring_size_offset, num_points);
                     std::string data;
@@ -247,6 +270,17 @@ namespace osmium {
                     ++m_points;
                 }
 
+                /**
+                 * Finish the multipolygon and return a reference to the
+                 * binary WKB. It is valid until the next geometry is
+                 * started. This reuses the internal buffer instead of
+                 * creating a new string for each geometry.
+                 */
+                const std::string& multipolygon_finish_ref() {
+                    set_size(m_multipolygon_size_offset, m_polygons);
+                    return m_data;
+                }
+
                 multipolygon_type multipolygon_finish() {
                     set_size(m_multipolygon_size_offset, m_polygons);
                     std::string data;
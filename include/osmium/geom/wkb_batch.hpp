@@ -0,0 +1,496 @@
+#ifndef OSMIUM_GEOM_WKB_BATCH_HPP
+#define OSMIUM_GEOM_WKB_BATCH_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * A batch of WKB (or EWKB) geometries stored back to back in one
+         * string, together with their offsets and the IDs of the objects
+         * they were created from. This is created by the WKBBatchFactory.
+         *
+         * If the batch was created with out_type::hex, the data contains
+         * the hex encoded geometries, ready to be written out, for
+         * instance for a PostgreSQL COPY.
+         */
+        class WKBBatch {
+
+            std::string m_data;
+            std::vector<std::size_t> m_offsets{0};
+            std::vector<osmium::object_id_type> m_ids;
+            std::size_t m_errors = 0;
+
+        public:
+
+            /// The number of geometries in the batch.
+            std::size_t size() const noexcept {
+                return m_ids.size();
+            }
+
+            bool empty() const noexcept {
+                return m_ids.empty();
+            }
+
+            /// The data of all geometries.
+            const std::string& data() const noexcept {
+                return m_data;
+            }
+
+            /**
+             * The offsets of the geometries in the data. There is one
+             * more entry than there are geometries, the last one is the
+             * size of the data.
+             */
+            const std::vector<std::size_t>& offsets() const noexcept {
+                return m_offsets;
+            }
+
+            /// The IDs of the objects the geometries were created from.
+            const std::vector<osmium::object_id_type>& ids() const noexcept {
+                return m_ids;
+            }
+
+            /**
+             * Get a pointer to the data of geometry n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            const char* geometry_data(std::size_t n) const noexcept {
+                assert(n < size());
+                return m_data.data() + m_offsets[n];
+            }
+
+            /**
+             * Get the size of the data of geometry n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            std::size_t geometry_size(std::size_t n) const noexcept {
+                assert(n < size());
+                return m_offsets[n + 1] - m_offsets[n];
+            }
+
+            /**
+             * Get a copy of geometry n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            std::string geometry(std::size_t n) const {
+                return std::string(geometry_data(n), geometry_size(n));
+            }
+
+            /**
+             * The number of objects for which no geometry could be
+             * created, because they had invalid geometries or locations.
+             */
+            std::size_t errors() const noexcept {
+                return m_errors;
+            }
+
+            /**
+             * Add a geometry.
+             *
+             * @param id The ID of the object.
+             * @param wkb The geometry in binary WKB format.
+             * @param otype Store the geometry in binary or hex format.
+             */
+            void add(osmium::object_id_type id, const std::string& wkb, out_type otype) {
+                if (otype == out_type::hex) {
+                    detail::append_hex(m_data, wkb);
+                } else {
+                    m_data.append(wkb);
+                }
+                m_offsets.push_back(m_data.size());
+                m_ids.push_back(id);
+            }
+
+            /**
+             * Reserve space for the specified number of geometries with
+             * the specified number of bytes overall.
+             */
+            void reserve(std::size_t num_geometries, std::size_t num_bytes) {
+                m_data.reserve(num_bytes);
+                m_offsets.reserve(num_geometries + 1);
+                m_ids.reserve(num_geometries);
+            }
+
+            /// Count an object for which no geometry could be created.
+            void add_error() noexcept {
+                ++m_errors;
+            }
+
+            /**
+             * Append all geometries from another batch to this one.
+             */
+            void append(const WKBBatch& other) {
+                const auto offset = m_data.size();
+                m_data.append(other.m_data);
+                for (auto it = std::next(other.m_offsets.cbegin()); it != other.m_offsets.cend(); ++it) {
+                    m_offsets.push_back(offset + *it);
+                }
+                m_ids.insert(m_ids.end(), other.m_ids.cbegin(), other.m_ids.cend());
+                m_errors += other.m_errors;
+            }
+
+            /// Remove all geometries from this batch.
+            void clear() {
+                m_data.clear();
+                m_offsets.resize(1);
+                m_ids.clear();
+                m_errors = 0;
+            }
+
+        }; // class WKBBatch
+
+        namespace detail {
+
+            /**
+             * Implementation for the GeometryFactory returning references
+             * to the binary WKB in an internal buffer instead of new
+             * strings. Used by the WKBBatchFactory.
+             */
+            class WKBBatchImpl {
+
+                WKBFactoryImpl m_impl;
+                mutable std::string m_point;
+
+            public:
+
+                using point_type        = const std::string&;
+                using linestring_type   = const std::string&;
+                using polygon_type      = const std::string&;
+                using multipolygon_type = const std::string&;
+                using ring_type         = const std::string&;
+
+                explicit WKBBatchImpl(int srid, wkb_type wtype = wkb_type::wkb) :
+                    m_impl(srid, wtype, out_type::binary) {
+                }
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    m_point.clear();
+                    m_impl.append_point(xy, m_point);
+                    return m_point;
+                }
+
+                void linestring_start() {
+                    m_impl.linestring_start();
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    m_impl.linestring_add_location(xy);
+                }
+
+                linestring_type linestring_finish(std::size_t num_points) {
+                    return m_impl.linestring_finish_ref(num_points);
+                }
+
+                void multipolygon_start() {
+                    m_impl.multipolygon_start();
+                }
+
+                void multipolygon_polygon_start() {
+                    m_impl.multipolygon_polygon_start();
+                }
+
+                void multipolygon_polygon_finish() {
+                    m_impl.multipolygon_polygon_finish();
+                }
+
+                void multipolygon_outer_ring_start() {
+                    m_impl.multipolygon_outer_ring_start();
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    m_impl.multipolygon_outer_ring_finish();
+                }
+
+                void multipolygon_inner_ring_start() {
+                    m_impl.multipolygon_inner_ring_start();
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    m_impl.multipolygon_inner_ring_finish();
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    m_impl.multipolygon_add_location(xy);
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    return m_impl.multipolygon_finish_ref();
+                }
+
+            }; // class WKBBatchImpl
+
+            enum class wkb_batch_geometry {
+                point,
+                linestring,
+                multipolygon
+            };
+
+            /**
+             * Creates the geometries for a range of objects. Run directly
+             * or in a worker thread.
+             */
+            template <typename TProjection>
+            class wkb_batch_task {
+
+                TProjection m_projection;
+                const osmium::OSMObject* const* m_begin;
+                const osmium::OSMObject* const* m_end;
+                wkb_batch_geometry m_geometry;
+                wkb_type m_wkb_type;
+                out_type m_out_type;
+                use_nodes m_use_nodes;
+                direction m_direction;
+
+            public:
+
+                wkb_batch_task(const TProjection& projection,
+                               const osmium::OSMObject* const* begin,
+                               const osmium::OSMObject* const* end,
+                               wkb_batch_geometry geometry,
+                               wkb_type wtype,
+                               out_type otype,
+                               use_nodes un,
+                               direction dir) :
+                    m_projection(projection),
+                    m_begin(begin),
+                    m_end(end),
+                    m_geometry(geometry),
+                    m_wkb_type(wtype),
+                    m_out_type(otype),
+                    m_use_nodes(un),
+                    m_direction(dir) {
+                }
+
+                // Upper bound for the size of the binary WKB of the
+                // object: 8 bytes for each coordinate and 9 bytes for
+                // each header (byte order, type, SRID) and count.
+                std::size_t max_wkb_size(const osmium::OSMObject& object) const noexcept {
+                    switch (m_geometry) {
+                        case wkb_batch_geometry::point:
+                            break;
+                        case wkb_batch_geometry::linestring:
+                            return 13 + static_cast<const osmium::Way&>(object).nodes().size() * 16;
+                        case wkb_batch_geometry::multipolygon: {
+                            std::size_t size = 13;
+                            for (const auto& item : static_cast<const osmium::Area&>(object)) {
+                                if (item.type() == osmium::item_type::outer_ring || item.type() == osmium::item_type::inner_ring) {
+                                    size += 13 + 4 + static_cast<const osmium::NodeRefList&>(item).size() * 16;
+                                }
+                            }
+                            return size;
+                        }
+                    }
+                    return 25;
+                }
+
+                WKBBatch operator()() {
+                    GeometryFactory<WKBBatchImpl, TProjection> factory{std::move(m_projection), m_wkb_type};
+                    WKBBatch batch;
+
+                    std::size_t size = 0;
+                    for (auto it = m_begin; it != m_end; ++it) {
+                        size += max_wkb_size(**it);
+                    }
+                    batch.reserve(static_cast<std::size_t>(m_end - m_begin), m_out_type == out_type::hex ? size * 2 : size);
+
+                    for (auto it = m_begin; it != m_end; ++it) {
+                        const osmium::OSMObject& object = **it;
+                        try {
+                            switch (m_geometry) {
+                                case wkb_batch_geometry::point:
+                                    batch.add(object.id(), factory.create_point(static_cast<const osmium::Node&>(object)), m_out_type);
+                                    break;
+                                case wkb_batch_geometry::linestring:
+                                    batch.add(object.id(), factory.create_linestring(static_cast<const osmium::Way&>(object), m_use_nodes, m_direction), m_out_type);
+                                    break;
+                                case wkb_batch_geometry::multipolygon:
+                                    batch.add(object.id(), factory.create_multipolygon(static_cast<const osmium::Area&>(object)), m_out_type);
+                                    break;
+                            }
+                        } catch (const osmium::geometry_error&) {
+                            batch.add_error();
+                        } catch (const osmium::invalid_location&) {
+                            batch.add_error();
+                        }
+                    }
+
+                    return batch;
+                }
+
+            }; // class wkb_batch_task
+
+        } // namespace detail
+
+        /**
+         * Creates WKB (or EWKB) geometries for all nodes, ways, or areas
+         * in a buffer at once and returns them packed into a WKBBatch.
+         * The geometry data of all objects is written into one string
+         * instead of creating a string for each object.
+         *
+         * If a thread pool is set, the objects are split into chunks
+         * which are converted in the worker threads. The result is the
+         * same as without a pool.
+         *
+         * Objects for which no geometry can be created (because they have
+         * invalid locations or not enough points) are skipped and counted
+         * in WKBBatch::errors().
+         *
+         * @code
+         * osmium::geom::WKBBatchFactory<> factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+         * factory.set_thread_pool(&pool);
+         * const auto batch = factory.create_linestrings(buffer);
+         * @endcode
+         */
+        template <typename TProjection = IdentityProjection>
+        class WKBBatchFactory {
+
+            TProjection m_projection;
+            wkb_type m_wkb_type;
+            out_type m_out_type;
+            osmium::thread::Pool* m_pool = nullptr;
+            std::size_t m_chunk_size = default_chunk_size;
+
+            WKBBatch create(const osmium::memory::Buffer& buffer, osmium::item_type type, detail::wkb_batch_geometry geometry, use_nodes un, direction dir) const {
+                std::vector<const osmium::OSMObject*> objects;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == type) {
+                        objects.push_back(&object);
+                    }
+                }
+
+                const auto* begin = objects.data();
+                const auto* end = begin + objects.size();
+
+                if (!m_pool || objects.size() <= m_chunk_size) {
+                    return detail::wkb_batch_task<TProjection>{m_projection, begin, end, geometry, m_wkb_type, m_out_type, un, dir}();
+                }
+
+                std::vector<std::future<WKBBatch>> futures;
+                for (auto it = begin; it != end;) {
+                    const auto chunk_end = (static_cast<std::size_t>(end - it) > m_chunk_size) ? it + m_chunk_size : end;
+                    futures.push_back(m_pool->submit(detail::wkb_batch_task<TProjection>{m_projection, it, chunk_end, geometry, m_wkb_type, m_out_type, un, dir}));
+                    it = chunk_end;
+                }
+
+                WKBBatch batch;
+                for (auto& future : futures) {
+                    batch.append(future.get());
+                }
+                return batch;
+            }
+
+        public:
+
+            enum : std::size_t {
+                /// Default number of objects converted in one task.
+                default_chunk_size = 10000
+            };
+
+            explicit WKBBatchFactory(wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary, TProjection projection = TProjection{}) :
+                m_projection(std::move(projection)),
+                m_wkb_type(wtype),
+                m_out_type(otype) {
+            }
+
+            /**
+             * Create geometries in the worker threads of the given
+             * thread pool.
+             *
+             * @param pool The thread pool to use. Set to nullptr to go back
+             *             to creating geometries in the calling thread.
+             * @param chunk_size Number of objects converted in one task.
+             */
+            void set_thread_pool(osmium::thread::Pool* pool, std::size_t chunk_size = default_chunk_size) noexcept {
+                m_pool = pool;
+                m_chunk_size = chunk_size > 0 ? chunk_size : 1;
+            }
+
+            int epsg() const noexcept {
+                return m_projection.epsg();
+            }
+
+            /**
+             * Create points for all nodes in the buffer.
+             */
+            WKBBatch create_points(const osmium::memory::Buffer& buffer) const {
+                return create(buffer, osmium::item_type::node, detail::wkb_batch_geometry::point, use_nodes::unique, direction::forward);
+            }
+
+            /**
+             * Create linestrings for all ways in the buffer.
+             */
+            WKBBatch create_linestrings(const osmium::memory::Buffer& buffer, use_nodes un = use_nodes::unique, direction dir = direction::forward) const {
+                return create(buffer, osmium::item_type::way, detail::wkb_batch_geometry::linestring, un, dir);
+            }
+
+            /**
+             * Create multipolygons for all areas in the buffer.
+             */
+            WKBBatch create_multipolygons(const osmium::memory::Buffer& buffer) const {
+                return create(buffer, osmium::item_type::area, detail::wkb_batch_geometry::multipolygon, use_nodes::unique, direction::forward);
+            }
+
+        }; // class WKBBatchFactory
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_WKB_BATCH_HPP
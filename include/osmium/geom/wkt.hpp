@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/osm/location.hpp>
 
 #include <cassert>
 #include <cstddef>
@@ -52,142 +53,300 @@ namespace osmium {
 
         namespace detail {
 
-            class WKTFactoryImpl {
+            /**
+             * Common code for the WKT factory implementations. The derived
+             * class has to implement the start_output() function returning
+             * the string the geometry is written to. The implementations
+             * only differ in who owns that string.
+             */
+            template <typename TDerived>
+            class WKTFactoryImplBase {
 
                 std::string m_srid_prefix;
-                std::string m_str;
                 int m_precision;
-                wkt_type m_wkt_type;
 
-            public:
+                std::string& start_output() {
+                    return static_cast<TDerived*>(this)->start_output();
+                }
 
-                using point_type        = std::string;
-                using linestring_type   = std::string;
-                using polygon_type      = std::string;
-                using multipolygon_type = std::string;
-                using ring_type         = std::string;
+                std::string& output() {
+                    return static_cast<TDerived*>(this)->output();
+                }
 
-                explicit WKTFactoryImpl(int srid, int precision = 7, wkt_type wtype = wkt_type::wkt) :
-                    m_precision(precision),
-                    m_wkt_type(wtype) {
-                    if (m_wkt_type == wkt_type::ewkt) {
+                void add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(output(), ' ', m_precision);
+                    output() += ',';
+                }
+
+                // Used with the FixedPointProjection
+                void add_location(const osmium::Location& location) {
+                    std::string& str = output();
+                    detail::append_fixed_point(str, location.x(), m_precision);
+                    str += ' ';
+                    detail::append_fixed_point(str, location.y(), m_precision);
+                    str += ',';
+                }
+
+            protected:
+
+                WKTFactoryImplBase(int srid, int precision, wkt_type wtype) :
+                    m_precision(precision) {
+                    if (wtype == wkt_type::ewkt) {
                         m_srid_prefix = "SRID=";
                         m_srid_prefix += std::to_string(srid);
                         m_srid_prefix += ';';
                     }
                 }
 
-                /* Point */
-
-                point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str{m_srid_prefix};
+                void append_point(std::string& str, const osmium::geom::Coordinates& xy) const {
+                    str += m_srid_prefix;
                     str += "POINT";
                     xy.append_to_string(str, '(', ' ', ')', m_precision);
-                    return str;
                 }
 
+                void append_point(std::string& str, const osmium::Location& location) const {
+                    str += m_srid_prefix;
+                    str += "POINT(";
+                    detail::append_fixed_point(str, location.x(), m_precision);
+                    str += ' ';
+                    detail::append_fixed_point(str, location.y(), m_precision);
+                    str += ')';
+                }
+
+                void finish_linestring() {
+                    assert(!output().empty());
+                    output().back() = ')';
+                }
+
+                void finish_polygon() {
+                    assert(!output().empty());
+                    output().back() = ')';
+                    output() += ')';
+                }
+
+                void finish_multipolygon() {
+                    assert(!output().empty());
+                    output().back() = ')';
+                }
+
+            public:
+
                 /* LineString */
 
                 void linestring_start() {
-                    m_str = m_srid_prefix;
-                    m_str += "LINESTRING(";
+                    std::string& str = start_output();
+                    str += m_srid_prefix;
+                    str += "LINESTRING(";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                linestring_type linestring_finish(size_t /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ')';
-                    return str;
+                void linestring_add_location(const osmium::Location& location) {
+                    add_location(location);
                 }
 
                 /* Polygon */
+
                 void polygon_start() {
-                    m_str = m_srid_prefix;
-                    m_str += "POLYGON((";
+                    std::string& str = start_output();
+                    str += m_srid_prefix;
+                    str += "POLYGON((";
                 }
 
                 void polygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                polygon_type polygon_finish(size_t /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ')';
-                    str += ")";
-                    return str;
+                void polygon_add_location(const osmium::Location& location) {
+                    add_location(location);
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = m_srid_prefix;
-                    m_str += "MULTIPOLYGON(";
+                    std::string& str = start_output();
+                    str += m_srid_prefix;
+                    str += "MULTIPOLYGON(";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '(';
+                    output() += '(';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "),";
+                    output() += "),";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '(';
+                    output() += '(';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(!output().empty());
+                    output().back() = ')';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",(";
+                    output() += ",(";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(!output().empty());
+                    output().back() = ')';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ', m_precision);
-                    m_str += ',';
+                    add_location(xy);
                 }
 
-                multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
+                void multipolygon_add_location(const osmium::Location& location) {
+                    add_location(location);
+                }
+
+            }; // class WKTFactoryImplBase
+
+            class WKTFactoryImpl : public WKTFactoryImplBase<WKTFactoryImpl> {
+
+                friend class WKTFactoryImplBase<WKTFactoryImpl>;
+
+                std::string m_str;
+
+                std::string& start_output() {
+                    m_str.clear();
+                    return m_str;
+                }
+
+                std::string& output() noexcept {
+                    return m_str;
+                }
+
+                std::string release() {
                     std::string str;
 
                     using std::swap;
                     swap(str, m_str);
 
-                    str.back() = ')';
                     return str;
                 }
 
+            public:
+
+                using point_type        = std::string;
+                using linestring_type   = std::string;
+                using polygon_type      = std::string;
+                using multipolygon_type = std::string;
+                using ring_type         = std::string;
+
+                explicit WKTFactoryImpl(int srid, int precision = 7, wkt_type wtype = wkt_type::wkt) :
+                    WKTFactoryImplBase<WKTFactoryImpl>(srid, precision, wtype) {
+                }
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    std::string str;
+                    append_point(str, xy);
+                    return str;
+                }
+
+                // Used with the FixedPointProjection
+                point_type make_point(const osmium::Location& location) const {
+                    std::string str;
+                    append_point(str, location);
+                    return str;
+                }
+
+                linestring_type linestring_finish(size_t /* num_points */) {
+                    finish_linestring();
+                    return release();
+                }
+
+                polygon_type polygon_finish(size_t /* num_points */) {
+                    finish_polygon();
+                    return release();
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    finish_multipolygon();
+                    return release();
+                }
+
             }; // class WKTFactoryImpl
 
+            /**
+             * WKT factory implementation appending all geometries to a
+             * string owned by the caller instead of returning a new string
+             * for each geometry. Reserve enough space in the string and
+             * clear it after it has been written out to avoid allocations.
+             *
+             * If creating a geometry fails with an exception, part of the
+             * geometry might already have been written. Remember the size
+             * of the string before creating the geometry and resize the
+             * string to it in that case.
+             */
+            class WKTAppendFactoryImpl : public WKTFactoryImplBase<WKTAppendFactoryImpl> {
+
+                friend class WKTFactoryImplBase<WKTAppendFactoryImpl>;
+
+                std::string* m_out;
+
+                std::string& start_output() noexcept {
+                    return *m_out;
+                }
+
+                std::string& output() noexcept {
+                    return *m_out;
+                }
+
+            public:
+
+                using point_type        = void;
+                using linestring_type   = void;
+                using polygon_type      = void;
+                using multipolygon_type = void;
+                using ring_type         = void;
+
+                WKTAppendFactoryImpl(int srid, std::string& out, int precision = 7, wkt_type wtype = wkt_type::wkt) :
+                    WKTFactoryImplBase<WKTAppendFactoryImpl>(srid, precision, wtype),
+                    m_out(&out) {
+                }
+
+                void make_point(const osmium::geom::Coordinates& xy) const {
+                    append_point(*m_out, xy);
+                }
+
+                // Used with the FixedPointProjection
+                void make_point(const osmium::Location& location) const {
+                    append_point(*m_out, location);
+                }
+
+                void linestring_finish(size_t /* num_points */) {
+                    finish_linestring();
+                }
+
+                void polygon_finish(size_t /* num_points */) {
+                    finish_polygon();
+                }
+
+                void multipolygon_finish() {
+                    finish_multipolygon();
+                }
+
+            }; // class WKTAppendFactoryImpl
+
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
         using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl, TProjection>;
 
+        /**
+         * WKT factory appending the geometries to a caller-owned string.
+         * Construct with the string and optionally the precision and
+         * wkt_type. The create_*() functions return nothing.
+         */
+        template <typename TProjection = IdentityProjection>
+        using WKTAppendFactory = GeometryFactory<osmium::geom::detail::WKTAppendFactoryImpl, TProjection>;
+
     } // namespace geom
 
 } // namespace osmium
@@ -0,0 +1,84 @@
+#ifndef OSMIUM_INDEX_DETAIL_BITS_HPP
+#define OSMIUM_INDEX_DETAIL_BITS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Count the number of bits set in the value.
+             */
+            inline unsigned int popcount(uint64_t value) noexcept {
+#ifdef __GNUC__
+                return static_cast<unsigned int>(__builtin_popcountll(value));
+#else
+                unsigned int count = 0;
+                while (value != 0) {
+                    value &= value - 1;
+                    ++count;
+                }
+                return count;
+#endif
+            }
+
+            /**
+             * Count the number of trailing zero bits in the value.
+             *
+             * @pre @code value != 0 @endcode
+             */
+            inline unsigned int count_trailing_zeros(uint64_t value) noexcept {
+#ifdef __GNUC__
+                return static_cast<unsigned int>(__builtin_ctzll(value));
+#else
+                unsigned int count = 0;
+                while ((value & 1u) == 0) {
+                    value >>= 1u;
+                    ++count;
+                }
+                return count;
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_BITS_HPP
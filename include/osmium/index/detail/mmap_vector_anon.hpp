@@ -54,6 +54,15 @@ namespace osmium {
                 mmap_vector_base<T>() {
             }
 
+            /**
+             * Create vector with anonymous mapping using the given
+             * options. Use this to request huge pages or NUMA
+             * interleaving for large vectors.
+             */
+            explicit mmap_vector_anon(const osmium::anonymous_mapping_options& options) :
+                mmap_vector_base<T>(mmap_vector_size_increment, options) {
+            }
+
         }; // class mmap_vector_anon
 
     } // namespace detail
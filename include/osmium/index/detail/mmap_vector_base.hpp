@@ -78,6 +78,11 @@ namespace osmium {
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
+            mmap_vector_base(const std::size_t capacity, const osmium::anonymous_mapping_options& options) :
+                m_mapping(capacity, options) {
+                std::fill_n(data(), capacity, osmium::index::empty_value<T>());
+            }
+
             using value_type      = T;
             using pointer         = value_type*;
             using const_pointer   = const value_type*;
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <algorithm>
 #include <cstddef>
@@ -69,6 +70,15 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                /**
+                 * Construct map with options for the anonymous memory
+                 * mapping. Only available if the vector type supports this,
+                 * ie. for the DenseMmapArray.
+                 */
+                explicit VectorBasedDenseMap(const osmium::anonymous_mapping_options& options) :
+                    m_vector(options) {
+                }
+
                 void reserve(const std::size_t size) final {
                     m_vector.reserve(size);
                 }
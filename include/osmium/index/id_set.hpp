@@ -33,16 +33,20 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/util/iterator.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -110,6 +114,9 @@ namespace osmium {
         template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
         class IdSetDense;
 
+        template <typename T>
+        class IdSetSmall;
+
         /**
          * Const_iterator for iterating over a IdSetDense.
          */
@@ -126,7 +133,7 @@ namespace osmium {
             T m_last;
 
             void next() noexcept {
-                while (m_value != m_last && !m_set->get(m_value)) {
+                while (m_value < m_last && !m_set->get(m_value)) {
                     const T cid = id_set::chunk_id(m_value);
                     assert(cid < m_set->m_data.size());
                     if (!m_set->m_data[cid]) {
@@ -141,12 +148,18 @@ namespace osmium {
                         }
                     }
                 }
+                // We might have skipped past the end of a range which
+                // doesn't end on a chunk or byte boundary.
+                if (m_value > m_last) {
+                    m_value = m_last;
+                }
             }
 
         public:
 
             using iterator_category = std::forward_iterator_tag;
             using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
             using pointer           = value_type*;
             using reference         = value_type&;
 
@@ -239,6 +252,43 @@ namespace osmium {
                 return chunk[offset(id)];
             }
 
+            static std::size_t count_chunk(const unsigned char* chunk) noexcept {
+                std::size_t count = 0;
+                std::size_t i = 0;
+                for (; i + sizeof(uint64_t) <= chunk_size; i += sizeof(uint64_t)) {
+                    uint64_t word;
+                    std::memcpy(&word, chunk + i, sizeof(word));
+                    count += detail::popcount(word);
+                }
+                for (; i < chunk_size; ++i) {
+                    count += detail::popcount(chunk[i]);
+                }
+                return count;
+            }
+
+            // Combine all chunks of this set with the corresponding chunks
+            // of the other set using the function. Chunks that become empty
+            // are released. Chunks only in the other set are ignored.
+            template <typename TFunc>
+            void combine_chunks(const IdSetDense& other, TFunc&& func) {
+                for (std::size_t cid = 0; cid < m_data.size(); ++cid) {
+                    auto& chunk = m_data[cid];
+                    if (!chunk) {
+                        continue;
+                    }
+                    const unsigned char* other_chunk = cid < other.m_data.size() ? other.m_data[cid].get() : nullptr;
+                    const auto count_before = count_chunk(chunk.get());
+                    if (!func(chunk.get(), other_chunk)) {
+                        continue;
+                    }
+                    const auto count_after = count_chunk(chunk.get());
+                    m_size -= static_cast<T>(count_before - count_after);
+                    if (count_after == 0) {
+                        chunk.reset();
+                    }
+                }
+            }
+
         public:
 
             using const_iterator = IdSetDenseIterator<T, chunk_bits>;
@@ -336,6 +386,143 @@ namespace osmium {
                 return {this, last(), last()};
             }
 
+            /**
+             * Get iterator range for all Ids in the set from first
+             * (inclusive) to last (exclusive).
+             */
+            iterator_range<const_iterator> range(T first, T last) const {
+                last = std::min(last, this->last());
+                first = std::min(first, last);
+                return iterator_range<const_iterator>{std::make_pair(const_iterator{this, first, last},
+                                                                     const_iterator{this, last, last})};
+            }
+
+            /**
+             * Split the set into (at most) the given number of ranges
+             * containing roughly the same number of allocated chunks.
+             * The ranges are in order, do not overlap, and together
+             * contain all Ids in the set. Each range can be iterated over
+             * in a different thread as long as the set is not changed.
+             *
+             * @param num_ranges The number of ranges wanted.
+             * @pre @code num_ranges > 0 @endcode
+             */
+            std::vector<iterator_range<const_iterator>> split(std::size_t num_ranges) const {
+                assert(num_ranges > 0);
+                std::vector<iterator_range<const_iterator>> ranges;
+
+                const std::size_t num_chunks = static_cast<std::size_t>(std::count_if(m_data.cbegin(), m_data.cend(), [](const std::unique_ptr<unsigned char[]>& chunk) {
+                    return chunk != nullptr;
+                }));
+                if (num_chunks == 0) {
+                    return ranges;
+                }
+                num_ranges = std::min(num_ranges, num_chunks);
+
+                T first = 0;
+                std::size_t seen_chunks = 0;
+                for (std::size_t cid = 0; cid < m_data.size(); ++cid) {
+                    if (!m_data[cid]) {
+                        continue;
+                    }
+                    ++seen_chunks;
+                    if (seen_chunks * num_ranges >= (ranges.size() + 1) * num_chunks) {
+                        const T last = static_cast<T>(cid + 1) * chunk_size * 8;
+                        ranges.push_back(range(first, last));
+                        first = last;
+                    }
+                }
+
+                assert(ranges.size() == num_ranges);
+                return ranges;
+            }
+
+            /**
+             * Add all Ids in the other set to this set. This works on whole
+             * chunks at a time and is much faster than adding the Ids one
+             * by one.
+             */
+            void merge(const IdSetDense& other) {
+                if (other.m_data.size() > m_data.size()) {
+                    m_data.resize(other.m_data.size());
+                }
+                for (std::size_t cid = 0; cid < other.m_data.size(); ++cid) {
+                    const unsigned char* other_chunk = other.m_data[cid].get();
+                    if (!other_chunk) {
+                        continue;
+                    }
+                    auto& chunk = m_data[cid];
+                    if (!chunk) {
+                        chunk.reset(new unsigned char[chunk_size]);
+                        std::memcpy(chunk.get(), other_chunk, chunk_size);
+                        m_size += static_cast<T>(count_chunk(chunk.get()));
+                        continue;
+                    }
+                    const auto count_before = count_chunk(chunk.get());
+                    for (std::size_t i = 0; i < chunk_size; ++i) {
+                        chunk[i] |= other_chunk[i];
+                    }
+                    m_size += static_cast<T>(count_chunk(chunk.get()) - count_before);
+                }
+            }
+
+            /**
+             * Add all Ids in the other set to this set.
+             */
+            void merge(const IdSetSmall<T>& other) {
+                for (const auto id : other) {
+                    set(id);
+                }
+            }
+
+            /**
+             * Remove all Ids from this set that are not in the other set.
+             * Chunks that become empty are released.
+             */
+            void intersect(const IdSetDense& other) {
+                combine_chunks(other, [](unsigned char* chunk, const unsigned char* other_chunk) -> bool {
+                    if (other_chunk) {
+                        for (std::size_t i = 0; i < chunk_size; ++i) {
+                            chunk[i] &= other_chunk[i];
+                        }
+                    } else {
+                        std::memset(chunk, 0, chunk_size);
+                    }
+                    return true;
+                });
+            }
+
+            /**
+             * Remove all Ids in the other set from this set. Chunks that
+             * become empty are released.
+             */
+            void subtract(const IdSetDense& other) {
+                combine_chunks(other, [](unsigned char* chunk, const unsigned char* other_chunk) -> bool {
+                    if (!other_chunk) {
+                        return false;
+                    }
+                    for (std::size_t i = 0; i < chunk_size; ++i) {
+                        chunk[i] &= static_cast<unsigned char>(~other_chunk[i]);
+                    }
+                    return true;
+                });
+            }
+
+            /**
+             * Count the Ids in the set using the bits actually set. This
+             * is always the same as size() but much slower, it can be
+             * used to check consistency.
+             */
+            std::size_t count() const noexcept {
+                std::size_t result = 0;
+                for (const auto& chunk : m_data) {
+                    if (chunk) {
+                        result += count_chunk(chunk.get());
+                    }
+                }
+                return result;
+            }
+
         }; // class IdSetDense
 
         /**
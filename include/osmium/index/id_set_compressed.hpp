@@ -0,0 +1,1009 @@
+#ifndef OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+#define OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/bits.hpp>
+#include <osmium/index/id_set.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * A container for the lower 16 bits of all Ids in an
+             * IdSetCompressed sharing the same upper bits. Depending on
+             * the number and distribution of Ids, the data is stored as
+             * sorted array, as bitmap, or as list of runs of consecutive
+             * Ids. This is the same scheme used by "roaring bitmaps".
+             */
+            class id_set_container {
+
+            public:
+
+                enum class container_type : uint8_t {
+                    array  = 0,
+                    bitmap = 1,
+                    run    = 2
+                };
+
+                enum : uint32_t {
+                    // Array containers are converted into bitmap
+                    // containers if they contain more values than this.
+                    // At this point both need the same amount of memory.
+                    max_array_size = 4096u,
+                    bitmap_words   = 1024u,
+                    num_values     = 1u << 16u
+                };
+
+            private:
+
+                // Array containers: sorted values. Run containers: pairs
+                // of first and last value in each run.
+                std::vector<uint16_t> m_values;
+
+                // Bitmap containers: bitmap with one bit per value.
+                std::vector<uint64_t> m_bitmap;
+
+                uint32_t m_cardinality = 0;
+
+                container_type m_type = container_type::array;
+
+                bool bitmap_get(const uint32_t value) const noexcept {
+                    return ((m_bitmap[value >> 6u] >> (value & 63u)) & 1u) != 0;
+                }
+
+                void bitmap_set(const uint32_t value) noexcept {
+                    m_bitmap[value >> 6u] |= 1ull << (value & 63u);
+                }
+
+                void bitmap_unset(const uint32_t value) noexcept {
+                    m_bitmap[value >> 6u] &= ~(1ull << (value & 63u));
+                }
+
+                std::size_t num_runs() const noexcept {
+                    return m_values.size() / 2;
+                }
+
+                uint32_t run_first(const std::size_t n) const noexcept {
+                    return m_values[n * 2];
+                }
+
+                uint32_t run_last(const std::size_t n) const noexcept {
+                    return m_values[n * 2 + 1];
+                }
+
+                void convert_to_array() {
+                    std::vector<uint16_t> values;
+                    values.reserve(m_cardinality);
+                    for_each([&values](const uint32_t value) {
+                        values.push_back(static_cast<uint16_t>(value));
+                    });
+                    m_values.swap(values);
+                    m_bitmap.clear();
+                    m_bitmap.shrink_to_fit();
+                    m_type = container_type::array;
+                }
+
+                void convert_to_bitmap() {
+                    std::vector<uint64_t> bitmap(bitmap_words, 0);
+                    for_each([&bitmap](const uint32_t value) {
+                        bitmap[value >> 6u] |= 1ull << (value & 63u);
+                    });
+                    m_bitmap.swap(bitmap);
+                    m_values.clear();
+                    m_values.shrink_to_fit();
+                    m_type = container_type::bitmap;
+                }
+
+                void convert_to_run() {
+                    std::vector<uint16_t> runs;
+                    uint32_t last = num_values;
+                    for_each([&runs, &last](const uint32_t value) {
+                        if (last == num_values || value != last + 1) {
+                            runs.push_back(static_cast<uint16_t>(value));
+                            runs.push_back(static_cast<uint16_t>(value));
+                        } else {
+                            runs.back() = static_cast<uint16_t>(value);
+                        }
+                        last = value;
+                    });
+                    m_values.swap(runs);
+                    m_bitmap.clear();
+                    m_bitmap.shrink_to_fit();
+                    m_type = container_type::run;
+                }
+
+                // Convert a run container into an array or bitmap container
+                // depending on the number of values. Run containers are
+                // only created by optimize() and never modified in place.
+                void convert_from_run() {
+                    assert(m_type == container_type::run);
+                    if (m_cardinality <= max_array_size) {
+                        convert_to_array();
+                    } else {
+                        convert_to_bitmap();
+                    }
+                }
+
+                // Recalculate the cardinality of a bitmap container and
+                // convert it into an array container if it has become small.
+                void normalize_bitmap() {
+                    assert(m_type == container_type::bitmap);
+                    m_cardinality = 0;
+                    for (const auto word : m_bitmap) {
+                        m_cardinality += popcount(word);
+                    }
+                    if (m_cardinality <= max_array_size) {
+                        convert_to_array();
+                    }
+                }
+
+                void set_array(std::vector<uint16_t>& values) {
+                    m_values.swap(values);
+                    m_cardinality = static_cast<uint32_t>(m_values.size());
+                    m_bitmap.clear();
+                    m_bitmap.shrink_to_fit();
+                    m_type = container_type::array;
+                    if (m_cardinality > max_array_size) {
+                        convert_to_bitmap();
+                    }
+                }
+
+                std::size_t count_runs() const {
+                    std::size_t count = 0;
+                    uint32_t last = num_values;
+                    for_each([&count, &last](const uint32_t value) {
+                        if (last == num_values || value != last + 1) {
+                            ++count;
+                        }
+                        last = value;
+                    });
+                    return count;
+                }
+
+                static const id_set_container& without_runs(const id_set_container& container, id_set_container& tmp) {
+                    if (container.m_type != container_type::run) {
+                        return container;
+                    }
+                    tmp = container;
+                    tmp.convert_from_run();
+                    return tmp;
+                }
+
+            public:
+
+                container_type type() const noexcept {
+                    return m_type;
+                }
+
+                uint32_t cardinality() const noexcept {
+                    return m_cardinality;
+                }
+
+                bool empty() const noexcept {
+                    return m_cardinality == 0;
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return sizeof(id_set_container) +
+                           m_values.capacity() * sizeof(uint16_t) +
+                           m_bitmap.capacity() * sizeof(uint64_t);
+                }
+
+                /**
+                 * Call func with each value in the container in order.
+                 */
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    switch (m_type) {
+                        case container_type::array:
+                            for (const auto value : m_values) {
+                                func(static_cast<uint32_t>(value));
+                            }
+                            break;
+                        case container_type::bitmap:
+                            for (uint32_t word = 0; word < m_bitmap.size(); ++word) {
+                                uint64_t bits = m_bitmap[word];
+                                while (bits != 0) {
+                                    func((word << 6u) + count_trailing_zeros(bits));
+                                    bits &= bits - 1;
+                                }
+                            }
+                            break;
+                        case container_type::run:
+                            for (std::size_t n = 0; n < num_runs(); ++n) {
+                                for (uint32_t value = run_first(n); value <= run_last(n); ++value) {
+                                    func(value);
+                                }
+                            }
+                            break;
+                    }
+                }
+
+                bool contains(const uint32_t value) const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            return std::binary_search(m_values.cbegin(), m_values.cend(), static_cast<uint16_t>(value));
+                        case container_type::bitmap:
+                            return bitmap_get(value);
+                        case container_type::run:
+                            break;
+                    }
+                    std::size_t first = 0;
+                    std::size_t last = num_runs();
+                    while (first < last) {
+                        const std::size_t middle = first + (last - first) / 2;
+                        if (run_last(middle) < value) {
+                            first = middle + 1;
+                        } else {
+                            last = middle;
+                        }
+                    }
+                    return first < num_runs() && run_first(first) <= value;
+                }
+
+                /**
+                 * Add value to the container.
+                 *
+                 * @returns true if the value was added, false if it was
+                 *          already in the container.
+                 */
+                bool add(const uint32_t value) {
+                    if (m_type == container_type::run) {
+                        if (contains(value)) {
+                            return false;
+                        }
+                        convert_from_run();
+                    }
+
+                    if (m_type == container_type::array) {
+                        // Fast path for values added in order
+                        if (m_values.empty() || m_values.back() < value) {
+                            if (m_values.size() < max_array_size) {
+                                m_values.push_back(static_cast<uint16_t>(value));
+                                ++m_cardinality;
+                                return true;
+                            }
+                        } else {
+                            const auto it = std::lower_bound(m_values.begin(), m_values.end(), static_cast<uint16_t>(value));
+                            if (*it == value) {
+                                return false;
+                            }
+                            if (m_values.size() < max_array_size) {
+                                m_values.insert(it, static_cast<uint16_t>(value));
+                                ++m_cardinality;
+                                return true;
+                            }
+                        }
+                        convert_to_bitmap();
+                    }
+
+                    if (bitmap_get(value)) {
+                        return false;
+                    }
+                    bitmap_set(value);
+                    ++m_cardinality;
+                    return true;
+                }
+
+                /**
+                 * Remove value from the container.
+                 *
+                 * @returns true if the value was removed, false if it was
+                 *          not in the container.
+                 */
+                bool remove(const uint32_t value) {
+                    if (!contains(value)) {
+                        return false;
+                    }
+
+                    if (m_type == container_type::run) {
+                        convert_from_run();
+                    }
+
+                    --m_cardinality;
+                    if (m_type == container_type::array) {
+                        m_values.erase(std::lower_bound(m_values.begin(), m_values.end(), static_cast<uint16_t>(value)));
+                    } else {
+                        bitmap_unset(value);
+                        if (m_cardinality <= max_array_size) {
+                            convert_to_array();
+                        }
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Find the first value in the container which is not
+                 * smaller than the given value.
+                 *
+                 * @param value Start searching here.
+                 * @param pos Position hint used by array and run
+                 *            containers. Must be 0 on the first call and
+                 *            is updated on every call. Values must not
+                 *            decrease between calls with the same hint.
+                 * @returns The value found or num_values if there is none.
+                 */
+                uint32_t next(const uint32_t value, std::size_t& pos) const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            while (pos < m_values.size() && m_values[pos] < value) {
+                                ++pos;
+                            }
+                            return pos < m_values.size() ? m_values[pos] : static_cast<uint32_t>(num_values);
+                        case container_type::bitmap: {
+                                if (value >= num_values) {
+                                    return num_values;
+                                }
+                                uint32_t word = value >> 6u;
+                                uint64_t bits = m_bitmap[word] & (~0ull << (value & 63u));
+                                while (bits == 0) {
+                                    if (++word == bitmap_words) {
+                                        return num_values;
+                                    }
+                                    bits = m_bitmap[word];
+                                }
+                                return (word << 6u) + count_trailing_zeros(bits);
+                            }
+                        case container_type::run:
+                            break;
+                    }
+                    while (pos < num_runs() && run_last(pos) < value) {
+                        ++pos;
+                    }
+                    if (pos == num_runs()) {
+                        return num_values;
+                    }
+                    return std::max(value, run_first(pos));
+                }
+
+                /**
+                 * Add all values in the other container to this one.
+                 */
+                void unite(const id_set_container& other) {
+                    id_set_container tmp;
+                    const id_set_container& rhs = without_runs(other, tmp);
+                    if (m_type == container_type::run) {
+                        convert_from_run();
+                    }
+
+                    if (m_type == container_type::array && rhs.m_type == container_type::array) {
+                        std::vector<uint16_t> result;
+                        result.reserve(m_values.size() + rhs.m_values.size());
+                        std::set_union(m_values.cbegin(), m_values.cend(),
+                                       rhs.m_values.cbegin(), rhs.m_values.cend(),
+                                       std::back_inserter(result));
+                        set_array(result);
+                        return;
+                    }
+
+                    if (m_type == container_type::array) {
+                        convert_to_bitmap();
+                    }
+
+                    if (rhs.m_type == container_type::array) {
+                        for (const auto value : rhs.m_values) {
+                            bitmap_set(value);
+                        }
+                    } else {
+                        for (std::size_t i = 0; i < bitmap_words; ++i) {
+                            m_bitmap[i] |= rhs.m_bitmap[i];
+                        }
+                    }
+                    normalize_bitmap();
+                }
+
+                /**
+                 * Remove all values from this container that are not in
+                 * the other container.
+                 */
+                void intersect(const id_set_container& other) {
+                    id_set_container tmp;
+                    const id_set_container& rhs = without_runs(other, tmp);
+                    if (m_type == container_type::run) {
+                        convert_from_run();
+                    }
+
+                    std::vector<uint16_t> result;
+                    if (m_type == container_type::array) {
+                        if (rhs.m_type == container_type::array) {
+                            std::set_intersection(m_values.cbegin(), m_values.cend(),
+                                                  rhs.m_values.cbegin(), rhs.m_values.cend(),
+                                                  std::back_inserter(result));
+                        } else {
+                            std::copy_if(m_values.cbegin(), m_values.cend(), std::back_inserter(result), [&rhs](const uint16_t value) {
+                                return rhs.bitmap_get(value);
+                            });
+                        }
+                        set_array(result);
+                        return;
+                    }
+
+                    if (rhs.m_type == container_type::array) {
+                        std::copy_if(rhs.m_values.cbegin(), rhs.m_values.cend(), std::back_inserter(result), [this](const uint16_t value) {
+                            return bitmap_get(value);
+                        });
+                        set_array(result);
+                        return;
+                    }
+
+                    for (std::size_t i = 0; i < bitmap_words; ++i) {
+                        m_bitmap[i] &= rhs.m_bitmap[i];
+                    }
+                    normalize_bitmap();
+                }
+
+                /**
+                 * Remove all values in the other container from this
+                 * container.
+                 */
+                void subtract(const id_set_container& other) {
+                    id_set_container tmp;
+                    const id_set_container& rhs = without_runs(other, tmp);
+                    if (m_type == container_type::run) {
+                        convert_from_run();
+                    }
+
+                    if (m_type == container_type::array) {
+                        std::vector<uint16_t> result;
+                        if (rhs.m_type == container_type::array) {
+                            std::set_difference(m_values.cbegin(), m_values.cend(),
+                                                rhs.m_values.cbegin(), rhs.m_values.cend(),
+                                                std::back_inserter(result));
+                        } else {
+                            std::copy_if(m_values.cbegin(), m_values.cend(), std::back_inserter(result), [&rhs](const uint16_t value) {
+                                return !rhs.bitmap_get(value);
+                            });
+                        }
+                        set_array(result);
+                        return;
+                    }
+
+                    if (rhs.m_type == container_type::array) {
+                        for (const auto value : rhs.m_values) {
+                            bitmap_unset(value);
+                        }
+                    } else {
+                        for (std::size_t i = 0; i < bitmap_words; ++i) {
+                            m_bitmap[i] &= ~rhs.m_bitmap[i];
+                        }
+                    }
+                    normalize_bitmap();
+                }
+
+                /**
+                 * Choose the representation needing the least memory for
+                 * the current content and release unused memory.
+                 */
+                void optimize() {
+                    const std::size_t run_bytes = count_runs() * 2 * sizeof(uint16_t);
+                    const std::size_t other_bytes = m_cardinality <= max_array_size
+                                                    ? m_cardinality * sizeof(uint16_t)
+                                                    : bitmap_words * sizeof(uint64_t);
+                    if (run_bytes < other_bytes) {
+                        if (m_type != container_type::run) {
+                            convert_to_run();
+                        }
+                    } else if (m_type == container_type::run) {
+                        convert_from_run();
+                    }
+                    m_values.shrink_to_fit();
+                }
+
+                void serialize(std::string& out) const {
+                    const auto type = static_cast<uint8_t>(m_type);
+                    const auto size = static_cast<uint32_t>(m_type == container_type::bitmap ? m_bitmap.size() : m_values.size());
+                    out.append(reinterpret_cast<const char*>(&type), sizeof(type));
+                    out.append(reinterpret_cast<const char*>(&m_cardinality), sizeof(m_cardinality));
+                    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+                    if (m_type == container_type::bitmap) {
+                        out.append(reinterpret_cast<const char*>(m_bitmap.data()), m_bitmap.size() * sizeof(uint64_t));
+                    } else {
+                        out.append(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(uint16_t));
+                    }
+                }
+
+                /**
+                 * Read container from serialized data.
+                 *
+                 * @returns Pointer to first byte after the container data.
+                 * @throws std::runtime_error If the data is invalid.
+                 */
+                const char* deserialize(const char* data, const char* end) {
+                    uint8_t type = 0;
+                    uint32_t size = 0;
+                    if (end - data < static_cast<std::ptrdiff_t>(sizeof(type) + sizeof(m_cardinality) + sizeof(size))) {
+                        throw std::runtime_error{"IdSetCompressed: truncated data"};
+                    }
+                    std::memcpy(&type, data, sizeof(type));
+                    data += sizeof(type);
+                    std::memcpy(&m_cardinality, data, sizeof(m_cardinality));
+                    data += sizeof(m_cardinality);
+                    std::memcpy(&size, data, sizeof(size));
+                    data += sizeof(size);
+
+                    if (type > static_cast<uint8_t>(container_type::run)) {
+                        throw std::runtime_error{"IdSetCompressed: invalid container type"};
+                    }
+                    m_type = static_cast<container_type>(type);
+
+                    const std::size_t bytes = size * (m_type == container_type::bitmap ? sizeof(uint64_t) : sizeof(uint16_t));
+                    if (static_cast<std::size_t>(end - data) < bytes) {
+                        throw std::runtime_error{"IdSetCompressed: truncated data"};
+                    }
+                    if ((m_type == container_type::bitmap && size != bitmap_words) ||
+                        (m_type == container_type::array && size != m_cardinality) ||
+                        (m_type == container_type::run && size % 2 != 0)) {
+                        throw std::runtime_error{"IdSetCompressed: invalid container size"};
+                    }
+
+                    m_values.clear();
+                    m_bitmap.clear();
+                    if (m_type == container_type::bitmap) {
+                        m_bitmap.resize(size);
+                        std::memcpy(m_bitmap.data(), data, bytes);
+                    } else {
+                        m_values.resize(size);
+                        std::memcpy(m_values.data(), data, bytes);
+                    }
+
+                    return data + bytes;
+                }
+
+            }; // class id_set_container
+
+        } // namespace detail
+
+        template <typename T>
+        class IdSetCompressed;
+
+        /**
+         * Const_iterator for iterating over a IdSetCompressed.
+         */
+        template <typename T>
+        class IdSetCompressedIterator {
+
+            using id_set = IdSetCompressed<T>;
+
+            const id_set* m_set;
+            std::size_t m_container;
+            std::size_t m_pos = 0;
+            uint32_t m_low = 0;
+
+            void next() noexcept {
+                while (m_container < m_set->m_keys.size()) {
+                    m_low = m_set->m_containers[m_container].next(m_low, m_pos);
+                    if (m_low < detail::id_set_container::num_values) {
+                        return;
+                    }
+                    ++m_container;
+                    m_pos = 0;
+                    m_low = 0;
+                }
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            IdSetCompressedIterator(const id_set* set, std::size_t container) noexcept :
+                m_set(set),
+                m_container(container) {
+                next();
+            }
+
+            IdSetCompressedIterator& operator++() noexcept {
+                if (m_container < m_set->m_keys.size()) {
+                    ++m_low;
+                    next();
+                }
+                return *this;
+            }
+
+            IdSetCompressedIterator operator++(int) noexcept {
+                IdSetCompressedIterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const IdSetCompressedIterator& rhs) const noexcept {
+                return m_set == rhs.m_set && m_container == rhs.m_container && m_low == rhs.m_low;
+            }
+
+            bool operator!=(const IdSetCompressedIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            T operator*() const noexcept {
+                assert(m_container < m_set->m_keys.size());
+                return (m_set->m_keys[m_container] << 16u) | m_low;
+            }
+
+        }; // class IdSetCompressedIterator
+
+        /**
+         * A compressed set of Ids of the given type. Ids are grouped by
+         * their upper bits into containers for 2^16 Ids each. Depending
+         * on the Ids in it, each container is stored as sorted array,
+         * as bitmap, or (after calling optimize()) as list of runs. This
+         * needs much less memory than the IdSetDense for sparse Id sets
+         * while still being fast for large sets. Ids should be added in
+         * order if possible, this is much faster than random inserts.
+         *
+         * Sets can be combined with merge(), intersect(), and subtract(),
+         * these work on whole containers at once.
+         *
+         * The set can be serialized into a string (for instance to write
+         * it to disk) and read back from it. The serialization format
+         * uses native byte order.
+         */
+        template <typename T>
+        class IdSetCompressed : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class IdSetCompressedIterator<T>;
+
+            using container = detail::id_set_container;
+
+            // Upper bits of the Ids, sorted
+            std::vector<T> m_keys;
+
+            // Containers with the lower bits of the Ids, same order as keys
+            std::vector<container> m_containers;
+
+            std::size_t m_size = 0;
+
+            static T key(T id) noexcept {
+                return id >> 16u;
+            }
+
+            static uint32_t low(T id) noexcept {
+                return static_cast<uint32_t>(id & 0xffffu);
+            }
+
+            std::size_t find_container(T key) const noexcept {
+                const auto it = std::lower_bound(m_keys.cbegin(), m_keys.cend(), key);
+                return static_cast<std::size_t>(std::distance(m_keys.cbegin(), it));
+            }
+
+            container& get_container(T key) {
+                if (!m_keys.empty() && m_keys.back() == key) {
+                    return m_containers.back();
+                }
+                if (m_keys.empty() || m_keys.back() < key) {
+                    m_keys.push_back(key);
+                    m_containers.emplace_back();
+                    return m_containers.back();
+                }
+                const auto n = find_container(key);
+                if (m_keys[n] != key) {
+                    m_keys.insert(m_keys.begin() + n, key);
+                    m_containers.insert(m_containers.begin() + n, container{});
+                }
+                return m_containers[n];
+            }
+
+            void recalculate_size() noexcept {
+                m_size = 0;
+                for (const auto& c : m_containers) {
+                    m_size += c.cardinality();
+                }
+            }
+
+            void remove_empty_containers() {
+                std::size_t out = 0;
+                for (std::size_t in = 0; in < m_keys.size(); ++in) {
+                    if (!m_containers[in].empty()) {
+                        if (in != out) {
+                            m_keys[out] = m_keys[in];
+                            m_containers[out] = std::move(m_containers[in]);
+                        }
+                        ++out;
+                    }
+                }
+                m_keys.resize(out);
+                m_containers.resize(out);
+            }
+
+        public:
+
+            using const_iterator = IdSetCompressedIterator<T>;
+
+            IdSetCompressed() = default;
+
+            /**
+             * Add the Id to the set if it is not already in there.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             */
+            bool check_and_set(T id) {
+                if (get_container(key(id)).add(low(id))) {
+                    ++m_size;
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             */
+            void set(T id) final {
+                (void)check_and_set(id);
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to remove.
+             */
+            void unset(T id) {
+                const auto n = find_container(key(id));
+                if (n == m_keys.size() || m_keys[n] != key(id)) {
+                    return;
+                }
+                if (m_containers[n].remove(low(id))) {
+                    --m_size;
+                    if (m_containers[n].empty()) {
+                        m_keys.erase(m_keys.begin() + n);
+                        m_containers.erase(m_containers.begin() + n);
+                    }
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const auto n = find_container(key(id));
+                if (n == m_keys.size() || m_keys[n] != key(id)) {
+                    return false;
+                }
+                return m_containers[n].contains(low(id));
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Clear the set.
+             */
+            void clear() final {
+                m_keys.clear();
+                m_containers.clear();
+                m_size = 0;
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_keys.capacity() * sizeof(T) +
+                                     (m_containers.capacity() - m_containers.size()) * sizeof(container);
+                for (const auto& c : m_containers) {
+                    memory += c.used_memory();
+                }
+                return memory;
+            }
+
+            /**
+             * Add all Ids in the other set to this set.
+             */
+            void merge(const IdSetCompressed& other) {
+                std::vector<T> keys;
+                std::vector<container> containers;
+                keys.reserve(m_keys.size() + other.m_keys.size());
+                containers.reserve(m_keys.size() + other.m_keys.size());
+
+                std::size_t i = 0;
+                std::size_t j = 0;
+                while (i < m_keys.size() || j < other.m_keys.size()) {
+                    if (j == other.m_keys.size() || (i < m_keys.size() && m_keys[i] < other.m_keys[j])) {
+                        keys.push_back(m_keys[i]);
+                        containers.push_back(std::move(m_containers[i]));
+                        ++i;
+                    } else if (i == m_keys.size() || other.m_keys[j] < m_keys[i]) {
+                        keys.push_back(other.m_keys[j]);
+                        containers.push_back(other.m_containers[j]);
+                        ++j;
+                    } else {
+                        keys.push_back(m_keys[i]);
+                        containers.push_back(std::move(m_containers[i]));
+                        containers.back().unite(other.m_containers[j]);
+                        ++i;
+                        ++j;
+                    }
+                }
+
+                m_keys.swap(keys);
+                m_containers.swap(containers);
+                recalculate_size();
+            }
+
+            /**
+             * Remove all Ids from this set that are not in the other set.
+             */
+            void intersect(const IdSetCompressed& other) {
+                std::size_t j = 0;
+                for (std::size_t i = 0; i < m_keys.size(); ++i) {
+                    while (j < other.m_keys.size() && other.m_keys[j] < m_keys[i]) {
+                        ++j;
+                    }
+                    if (j < other.m_keys.size() && other.m_keys[j] == m_keys[i]) {
+                        m_containers[i].intersect(other.m_containers[j]);
+                    } else {
+                        m_containers[i] = container{};
+                    }
+                }
+                remove_empty_containers();
+                recalculate_size();
+            }
+
+            /**
+             * Remove all Ids in the other set from this set.
+             */
+            void subtract(const IdSetCompressed& other) {
+                std::size_t j = 0;
+                for (std::size_t i = 0; i < m_keys.size(); ++i) {
+                    while (j < other.m_keys.size() && other.m_keys[j] < m_keys[i]) {
+                        ++j;
+                    }
+                    if (j < other.m_keys.size() && other.m_keys[j] == m_keys[i]) {
+                        m_containers[i].subtract(other.m_containers[j]);
+                    }
+                }
+                remove_empty_containers();
+                recalculate_size();
+            }
+
+            /**
+             * Convert all containers into the representation needing the
+             * least memory. Call this after the set has been filled. Runs
+             * of consecutive Ids will be stored very efficiently after
+             * this.
+             */
+            void optimize() {
+                for (auto& c : m_containers) {
+                    c.optimize();
+                }
+                m_keys.shrink_to_fit();
+                m_containers.shrink_to_fit();
+            }
+
+            /**
+             * Append serialized version of this set to the string.
+             */
+            void serialize(std::string& out) const {
+                const uint64_t num_containers = m_keys.size();
+                out.append(reinterpret_cast<const char*>(&num_containers), sizeof(num_containers));
+                for (std::size_t n = 0; n < m_keys.size(); ++n) {
+                    const uint64_t k = m_keys[n];
+                    out.append(reinterpret_cast<const char*>(&k), sizeof(k));
+                    m_containers[n].serialize(out);
+                }
+            }
+
+            /**
+             * Replace the contents of this set with the set serialized
+             * into the given data by serialize().
+             *
+             * @returns Pointer to the first byte after the serialized set.
+             * @throws std::runtime_error If the data is invalid.
+             */
+            const char* deserialize(const char* data, const std::size_t size) {
+                clear();
+                const char* end = data + size;
+
+                uint64_t num_containers = 0;
+                if (size < sizeof(num_containers)) {
+                    throw std::runtime_error{"IdSetCompressed: truncated data"};
+                }
+                std::memcpy(&num_containers, data, sizeof(num_containers));
+                data += sizeof(num_containers);
+
+                for (uint64_t n = 0; n < num_containers; ++n) {
+                    uint64_t k = 0;
+                    if (end - data < static_cast<std::ptrdiff_t>(sizeof(k))) {
+                        clear();
+                        throw std::runtime_error{"IdSetCompressed: truncated data"};
+                    }
+                    std::memcpy(&k, data, sizeof(k));
+                    data += sizeof(k);
+                    if ((!m_keys.empty() && k <= m_keys.back()) || k > (std::numeric_limits<T>::max() >> 16u)) {
+                        clear();
+                        throw std::runtime_error{"IdSetCompressed: invalid key"};
+                    }
+                    m_keys.push_back(static_cast<T>(k));
+                    m_containers.emplace_back();
+                    try {
+                        data = m_containers.back().deserialize(data, end);
+                    } catch (...) {
+                        clear();
+                        throw;
+                    }
+                }
+
+                recalculate_size();
+                return data;
+            }
+
+            const_iterator begin() const {
+                return {this, 0};
+            }
+
+            const_iterator end() const {
+                return {this, m_keys.size()};
+            }
+
+        }; // class IdSetCompressed
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
@@ -37,6 +37,10 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/detail/mmap_vector_anon.hpp> // IWYU pragma: keep
 #include <osmium/index/detail/vector_map.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <string>
+#include <vector>
 
 #define OSMIUM_HAS_INDEX_MAP_DENSE_MMAP_ARRAY
 
@@ -49,6 +53,31 @@ namespace osmium {
             template <typename TId, typename TValue>
             using DenseMmapArray = VectorBasedDenseMap<osmium::detail::mmap_vector_anon<TValue>, TId, TValue>;
 
+            /**
+             * Create DenseMmapArray from the map factory. The config can
+             * contain the options "huge_pages", "populate", and
+             * "numa_interleave" after the map type name, for instance
+             * "dense_mmap_array,huge_pages,numa_interleave".
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, DenseMmapArray> {
+                DenseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    osmium::anonymous_mapping_options options;
+                    for (std::size_t i = 1; i < config.size(); ++i) {
+                        if (config[i] == "huge_pages") {
+                            options.huge_pages = true;
+                        } else if (config[i] == "populate") {
+                            options.populate = true;
+                        } else if (config[i] == "numa_interleave") {
+                            options.numa_interleave = true;
+                        } else {
+                            throw map_factory_error{"Unknown option '" + config[i] + "' for dense_mmap_array"};
+                        }
+                    }
+                    return new DenseMmapArray<TId, TValue>{options};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
@@ -0,0 +1,234 @@
+#ifndef OSMIUM_INDEX_MAP_FLEX_FILE_HPP
+#define OSMIUM_INDEX_MAP_FLEX_FILE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#define OSMIUM_HAS_INDEX_MAP_FLEX_FILE
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Read-only index on a file written by FlexMem::dump_as_flex().
+             * The file is mmapped, so opening it is cheap, no matter how
+             * large it is, and several processes can share the same file.
+             *
+             * Depending on whether the FlexMem index was in sparse or dense
+             * mode when it was written, lookups are done with a binary
+             * search on the sparse entries or directly in the dense blocks.
+             *
+             * Usage:
+             * @code
+             * FlexMem<unsigned_object_id_type, Location> index;
+             * // ... fill index ...
+             * index.dump_as_flex(fd);
+             *
+             * // later, maybe in another program:
+             * FlexFile<unsigned_object_id_type, Location> file_index{fd};
+             * auto location = file_index.get(id);
+             * @endcode
+             */
+            template <typename TId, typename TValue>
+            class FlexFile : public osmium::index::map::Map<TId, TValue> {
+
+                using header_type = osmium::index::detail::flex_file_header;
+                using entry = osmium::index::detail::flex_entry<TValue>;
+
+                enum {
+                    bits = FlexMem<TId, TValue>::block_bits
+                };
+
+                enum : uint64_t {
+                    block_size = 1ull << bits
+                };
+
+                osmium::MemoryMapping m_mapping;
+
+                const header_type* m_header = nullptr;
+                const entry* m_sparse_entries = nullptr;
+                const uint64_t* m_block_numbers = nullptr;
+                const TValue* m_dense_blocks = nullptr;
+
+                static std::size_t checked_file_size(const int fd) {
+                    const auto size = osmium::file_size(fd);
+                    if (size < sizeof(header_type)) {
+                        throw std::runtime_error{"FlexFile index file is too small"};
+                    }
+                    return size;
+                }
+
+                void check_and_setup() {
+                    const char* data = m_mapping.get_addr<const char>();
+                    m_header = reinterpret_cast<const header_type*>(data);
+
+                    if (std::memcmp(m_header->magic, osmium::index::detail::flex_file_magic, sizeof(m_header->magic)) != 0) {
+                        throw std::runtime_error{"Not a FlexFile index file"};
+                    }
+                    if (m_header->version != osmium::index::detail::flex_file_version) {
+                        throw std::runtime_error{"Unsupported FlexFile index file version " + std::to_string(m_header->version)};
+                    }
+                    if (m_header->value_size != sizeof(TValue)) {
+                        throw std::runtime_error{"FlexFile index file has wrong value size (must be " + std::to_string(sizeof(TValue)) + ")"};
+                    }
+
+                    const std::size_t sparse_offset = sizeof(header_type);
+                    const std::size_t blocks_offset = sparse_offset + m_header->num_sparse_entries * sizeof(entry);
+                    const std::size_t dense_offset = blocks_offset + m_header->num_blocks * sizeof(uint64_t);
+                    const std::size_t expected_size = dense_offset + m_header->num_used_blocks * block_size * sizeof(TValue);
+
+                    if (m_mapping.size() != expected_size) {
+                        throw std::runtime_error{"FlexFile index file has wrong size"};
+                    }
+
+                    m_sparse_entries = reinterpret_cast<const entry*>(data + sparse_offset);
+                    m_block_numbers = reinterpret_cast<const uint64_t*>(data + blocks_offset);
+                    m_dense_blocks = reinterpret_cast<const TValue*>(data + dense_offset);
+                }
+
+                TValue get_sparse(const uint64_t id) const noexcept {
+                    const entry* end = m_sparse_entries + m_header->num_sparse_entries;
+                    const auto it = std::lower_bound(m_sparse_entries, end,
+                                                     entry{id, osmium::index::empty_value<TValue>()});
+                    if (it == end || it->id != id) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return it->value;
+                }
+
+                TValue get_dense(const uint64_t id) const noexcept {
+                    const uint64_t block = id >> bits;
+                    if (block >= m_header->num_blocks) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const uint64_t num = m_block_numbers[block];
+                    if (num == osmium::index::detail::flex_empty_block) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return m_dense_blocks[num * block_size + (id & (block_size - 1))];
+                }
+
+            public:
+
+                /**
+                 * Open FlexFile index.
+                 *
+                 * @param fd File descriptor of a file written with
+                 *           FlexMem::dump_as_flex(). Only needs to be
+                 *           open for reading.
+                 * @throws std::runtime_error If the file is not a valid
+                 *         FlexFile index file.
+                 * @throws std::system_error If the mmap fails.
+                 */
+                explicit FlexFile(const int fd) :
+                    m_mapping(checked_file_size(fd), osmium::MemoryMapping::mapping_mode::readonly, fd) {
+                    check_and_setup();
+                }
+
+                bool is_dense() const noexcept {
+                    return m_header && m_header->dense;
+                }
+
+                std::size_t size() const noexcept final {
+                    if (!m_header) {
+                        return 0;
+                    }
+                    if (m_header->dense) {
+                        return m_header->num_blocks * block_size;
+                    }
+                    return m_header->num_sparse_entries;
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    return m_mapping ? m_mapping.size() : 0;
+                }
+
+                /**
+                 * A FlexFile index is read-only, this will always throw.
+                 *
+                 * @throws std::runtime_error
+                 */
+                void set(const TId /*id*/, const TValue /*value*/) final {
+                    throw std::runtime_error{"FlexFile index is read-only"};
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (!m_header) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    if (m_header->dense) {
+                        return get_dense(id);
+                    }
+                    return get_sparse(id);
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                void clear() final {
+                    m_mapping.unmap();
+                    m_header = nullptr;
+                    m_sparse_entries = nullptr;
+                    m_block_numbers = nullptr;
+                    m_dense_blocks = nullptr;
+                }
+
+            }; // class FlexFile
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_FLEX_FILE_HPP
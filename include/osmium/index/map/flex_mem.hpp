@@ -35,10 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <utility>
 #include <vector>
 
@@ -48,6 +51,56 @@ namespace osmium {
 
     namespace index {
 
+        namespace detail {
+
+            /**
+             * Header of the file format written by FlexMem::dump_as_flex()
+             * and read by the FlexFile index.
+             *
+             * The header is followed by `num_sparse_entries` sparse entries
+             * (id and value), then by `num_blocks` 64bit block numbers
+             * (one for each dense block, flex_empty_block for blocks that
+             * are not used), and then by `num_used_blocks` dense blocks.
+             * All data is written in native byte order.
+             */
+            struct flex_file_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t value_size;
+                uint64_t dense;
+                uint64_t num_sparse_entries;
+                uint64_t num_blocks;
+                uint64_t num_used_blocks;
+            }; // struct flex_file_header
+
+            constexpr const char flex_file_magic[8] = {'O', 'S', 'M', 'F', 'L', 'E', 'X', '\0'};
+
+            enum : uint32_t {
+                flex_file_version = 1
+            };
+
+            enum : uint64_t {
+                flex_empty_block = std::numeric_limits<uint64_t>::max()
+            };
+
+            // An entry in the sparse index of FlexMem and FlexFile
+            template <typename TValue>
+            struct flex_entry {
+                uint64_t id;
+                TValue value;
+
+                flex_entry(uint64_t i, TValue v) :
+                    id(i),
+                    value(std::move(v)) {
+                }
+
+                bool operator<(const flex_entry other) const noexcept {
+                    return id < other.id;
+                }
+            }; // struct flex_entry
+
+        } // namespace detail
+
         namespace map {
 
             /**
@@ -86,19 +139,7 @@ namespace osmium {
                 };
 
                 // An entry in the sparse index
-                struct entry {
-                    uint64_t id;
-                    TValue value;
-
-                    entry(uint64_t i, TValue v) :
-                        id(i),
-                        value(std::move(v)) {
-                    }
-
-                    bool operator<(const entry other) const noexcept {
-                        return id < other.id;
-                    }
-                };
+                using entry = osmium::index::detail::flex_entry<TValue>;
 
                 std::vector<entry> m_sparse_entries;
 
@@ -166,6 +207,10 @@ namespace osmium {
 
             public:
 
+                enum {
+                    block_bits = bits
+                };
+
                 /**
                  * Create FlexMem index.
                  *
@@ -253,6 +298,47 @@ namespace osmium {
                     m_dense = true;
                 }
 
+                /**
+                 * Write the index to a file in a format that can be read
+                 * with the FlexFile index. Sparse indexes are written as
+                 * sorted list, dense indexes as list of blocks, empty
+                 * blocks are left out. The FlexFile index can then mmap
+                 * this file and use it without having to rebuild the index.
+                 *
+                 * This will sort the index if it is in sparse mode.
+                 *
+                 * @param fd File descriptor open for writing.
+                 * @throws std::system_error If the write fails.
+                 */
+                void dump_as_flex(const int fd) {
+                    sort();
+
+                    osmium::index::detail::flex_file_header header;
+                    std::memcpy(header.magic, osmium::index::detail::flex_file_magic, sizeof(header.magic));
+                    header.version = osmium::index::detail::flex_file_version;
+                    header.value_size = sizeof(TValue);
+                    header.dense = m_dense ? 1 : 0;
+                    header.num_sparse_entries = m_sparse_entries.size();
+                    header.num_blocks = m_dense_blocks.size();
+
+                    std::vector<uint64_t> block_numbers;
+                    block_numbers.reserve(m_dense_blocks.size());
+                    uint64_t num_used_blocks = 0;
+                    for (const auto& block : m_dense_blocks) {
+                        block_numbers.push_back(block.empty() ? osmium::index::detail::flex_empty_block : num_used_blocks++);
+                    }
+                    header.num_used_blocks = num_used_blocks;
+
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_sparse_entries.data()), sizeof(entry) * m_sparse_entries.size());
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(block_numbers.data()), sizeof(uint64_t) * block_numbers.size());
+                    for (const auto& block : m_dense_blocks) {
+                        if (!block.empty()) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(block.data()), sizeof(TValue) * block_size);
+                        }
+                    }
+                }
+
                 std::pair<std::size_t, std::size_t> stats() const noexcept {
                     std::size_t used_blocks = 0;
                     std::size_t empty_blocks = 0;
@@ -0,0 +1,390 @@
+#ifndef OSMIUM_INDEX_MULTIMAP_SPARSE_EXTERNAL_ARRAY_HPP
+#define OSMIUM_INDEX_MULTIMAP_SPARSE_EXTERNAL_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/multimap.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace multimap {
+
+            /**
+             * Multimap for data that doesn't fit into memory. Data added
+             * with set() is collected in a buffer of limited size. When the
+             * buffer is full, it is sorted and written out as a "run" into
+             * a temporary file. When consolidate() is called, all runs are
+             * merged into one sorted file using a k-way merge and this file
+             * is mmapped. After that get_all() can be used like with the
+             * other multimap implementations.
+             *
+             * The merge reads the runs through small windows and writes
+             * the result in chunks, so it needs no more than the buffer
+             * size in memory. But the merged file is mmapped as a whole
+             * for lookups, so it takes as much address space as the data
+             * is large. (The operating system only keeps the pages in
+             * memory that are used, though.)
+             *
+             * Data added after consolidate() is not visible in get_all()
+             * until consolidate() is called again.
+             */
+            template <typename TId, typename TValue>
+            class SparseExternalArray : public Multimap<TId, TValue> {
+
+            public:
+
+                using element_type   = typename std::pair<TId, TValue>;
+                using iterator       = const element_type*;
+                using const_iterator = const element_type*;
+
+                enum : std::size_t {
+                    // Default size of the buffer in number of elements.
+                    default_buffer_size = 16ul * 1024ul * 1024ul
+                };
+
+            private:
+
+                // A sorted run of elements in a temporary file.
+                struct run {
+                    int fd;
+                    std::size_t size;
+                };
+
+                std::vector<element_type> m_buffer;
+
+                std::vector<run> m_runs;
+
+                // Mapping of the consolidated data, if there is any.
+                std::unique_ptr<osmium::TypedMemoryMapping<element_type>> m_mapping;
+
+                std::size_t m_max_buffer_size;
+
+                std::size_t m_size = 0;
+
+                std::size_t mapped_size() const noexcept {
+                    return m_mapping ? m_runs.front().size : 0;
+                }
+
+                void close_runs() {
+                    m_mapping.reset();
+                    for (const auto& r : m_runs) {
+                        osmium::io::detail::reliable_close(r.fd);
+                    }
+                    m_runs.clear();
+                }
+
+                void write_run(const element_type* data, const std::size_t size) {
+                    const int fd = osmium::detail::create_tmp_file();
+                    m_runs.push_back(run{fd, size});
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(data), size * sizeof(element_type));
+                }
+
+                void spill() {
+                    std::sort(m_buffer.begin(), m_buffer.end());
+                    write_run(m_buffer.data(), m_buffer.size());
+                    m_buffer.clear();
+                }
+
+                // Reads a run sequentially from its file through a window
+                // of limited size.
+                class run_reader {
+
+                    int m_fd;
+                    std::size_t m_remaining;
+                    std::vector<element_type> m_window;
+                    std::size_t m_pos = 0;
+
+                    void fill(std::size_t window_size) {
+                        const std::size_t count = std::min(window_size, m_remaining);
+                        m_window.resize(count);
+                        m_pos = 0;
+                        m_remaining -= count;
+
+                        char* data = reinterpret_cast<char*>(m_window.data());
+                        std::size_t size = count * sizeof(element_type);
+                        while (size > 0) {
+                            const auto chunk = static_cast<unsigned int>(std::min<std::size_t>(size, 1024UL * 1024UL * 1024UL));
+                            const auto nread = osmium::io::detail::reliable_read(m_fd, data, chunk);
+                            if (nread == 0) {
+                                throw std::runtime_error{"SparseExternalArray: temporary file is truncated"};
+                            }
+                            data += nread;
+                            size -= static_cast<std::size_t>(nread);
+                        }
+                    }
+
+                public:
+
+                    run_reader(const run& r, std::size_t window_size) :
+                        m_fd(r.fd),
+                        m_remaining(r.size) {
+#ifdef _WIN32
+                        if (_lseeki64(m_fd, 0, SEEK_SET) == -1) {
+#else
+                        if (::lseek(m_fd, 0, SEEK_SET) == -1) {
+#endif
+                            throw std::system_error{errno, std::system_category(), "Seek failed"};
+                        }
+                        fill(window_size);
+                    }
+
+                    const element_type& current() const noexcept {
+                        return m_window[m_pos];
+                    }
+
+                    // Move to the next element. Returns false at the end
+                    // of the run.
+                    bool next(std::size_t window_size) {
+                        if (++m_pos < m_window.size()) {
+                            return true;
+                        }
+                        if (m_remaining == 0) {
+                            return false;
+                        }
+                        fill(window_size);
+                        return true;
+                    }
+
+                }; // class run_reader
+
+                // Merge all runs into a single sorted run. The buffer size
+                // is shared between the windows of all runs and the output
+                // buffer.
+                void merge_runs() {
+                    const std::size_t window_size = std::max<std::size_t>(1, m_max_buffer_size / (m_runs.size() + 1));
+
+                    m_buffer.clear();
+                    m_buffer.shrink_to_fit();
+
+                    std::vector<run_reader> readers;
+                    readers.reserve(m_runs.size());
+                    for (const auto& r : m_runs) {
+                        if (r.size > 0) {
+                            readers.emplace_back(r, window_size);
+                        }
+                    }
+
+                    const auto greater = [&readers](std::size_t a, std::size_t b) {
+                        return readers[b].current() < readers[a].current();
+                    };
+                    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> queue{greater};
+                    for (std::size_t i = 0; i < readers.size(); ++i) {
+                        queue.push(i);
+                    }
+
+                    const int fd = osmium::detail::create_tmp_file();
+                    run merged{fd, 0};
+
+                    std::vector<element_type> output;
+                    output.reserve(window_size);
+                    const auto flush = [&]() {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(output.data()), output.size() * sizeof(element_type));
+                        merged.size += output.size();
+                        output.clear();
+                    };
+
+                    while (!queue.empty()) {
+                        const std::size_t i = queue.top();
+                        queue.pop();
+                        output.push_back(readers[i].current());
+                        if (readers[i].next(window_size)) {
+                            queue.push(i);
+                        }
+                        if (output.size() == window_size) {
+                            flush();
+                        }
+                    }
+                    flush();
+
+                    readers.clear();
+                    close_runs();
+                    m_runs.push_back(merged);
+                }
+
+            public:
+
+                /**
+                 * Construct SparseExternalArray multimap.
+                 *
+                 * @param max_buffer_size Maximum number of elements kept
+                 *                        in memory before they are written
+                 *                        to disk.
+                 */
+                explicit SparseExternalArray(const std::size_t max_buffer_size = default_buffer_size) :
+                    m_max_buffer_size(max_buffer_size) {
+                    assert(max_buffer_size > 0);
+                }
+
+                SparseExternalArray(const SparseExternalArray&) = delete;
+                SparseExternalArray& operator=(const SparseExternalArray&) = delete;
+
+                SparseExternalArray(SparseExternalArray&&) = delete;
+                SparseExternalArray& operator=(SparseExternalArray&&) = delete;
+
+                ~SparseExternalArray() noexcept override {
+                    try {
+                        close_runs();
+                    } catch (const std::system_error&) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void set(const TId id, const TValue value) final {
+                    m_buffer.emplace_back(id, value);
+                    ++m_size;
+                    if (m_buffer.size() >= m_max_buffer_size) {
+                        spill();
+                    }
+                }
+
+                void unsorted_set(const TId id, const TValue value) {
+                    set(id, value);
+                }
+
+                /**
+                 * Get all entries with the given id.
+                 *
+                 * @pre consolidate() (or sort()) must have been called.
+                 */
+                std::pair<const_iterator, const_iterator> get_all(const TId id) const {
+                    const element_type element {
+                        id,
+                        osmium::index::empty_value<TValue>()
+                    };
+                    return std::equal_range(cbegin(), cend(), element, [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                }
+
+                /**
+                 * The number of elements in all runs (the number of
+                 * elements that were set).
+                 */
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                /**
+                 * The number of runs currently stored on disk.
+                 */
+                std::size_t num_runs() const noexcept {
+                    return m_runs.size();
+                }
+
+                /**
+                 * The memory used by the buffer. The data on disk is not
+                 * counted.
+                 */
+                std::size_t used_memory() const final {
+                    return m_buffer.capacity() * sizeof(element_type);
+                }
+
+                void clear() final {
+                    close_runs();
+                    m_buffer.clear();
+                    m_buffer.shrink_to_fit();
+                    m_size = 0;
+                }
+
+                void sort() final {
+                    consolidate();
+                }
+
+                /**
+                 * Write the buffer to disk, merge all runs and mmap the
+                 * result.
+                 */
+                void consolidate() {
+                    if (!m_buffer.empty()) {
+                        spill();
+                    }
+                    m_mapping.reset();
+                    if (m_runs.size() > 1) {
+                        merge_runs();
+                    }
+                    m_buffer.clear();
+                    m_buffer.shrink_to_fit();
+                    if (!m_runs.empty() && m_runs.front().size > 0) {
+                        m_mapping.reset(new osmium::TypedMemoryMapping<element_type>{m_runs.front().size, osmium::MemoryMapping::mapping_mode::readonly, m_runs.front().fd});
+                    }
+                }
+
+                void dump_as_list(const int fd) final {
+                    consolidate();
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(cbegin()), mapped_size() * sizeof(element_type));
+                }
+
+                const_iterator cbegin() const noexcept {
+                    return m_mapping ? m_mapping->cbegin() : nullptr;
+                }
+
+                const_iterator cend() const noexcept {
+                    return m_mapping ? m_mapping->cbegin() + mapped_size() : nullptr;
+                }
+
+                const_iterator begin() const noexcept {
+                    return cbegin();
+                }
+
+                const_iterator end() const noexcept {
+                    return cend();
+                }
+
+            }; // class SparseExternalArray
+
+        } // namespace multimap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MULTIMAP_SPARSE_EXTERNAL_ARRAY_HPP
@@ -0,0 +1,650 @@
+#ifndef OSMIUM_INDEX_PACKED_RTREE_HPP
+#define OSMIUM_INDEX_PACKED_RTREE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/relations.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Entry in a PackedRTree: The bounding box of an object together
+         * with its type and ID.
+         */
+        class packed_rtree_entry {
+
+            osmium::Box m_box;
+            osmium::object_id_type m_id = 0;
+            uint32_t m_type = 0;
+            uint32_t m_padding = 0;
+
+        public:
+
+            packed_rtree_entry() = default;
+
+            packed_rtree_entry(const osmium::Box& box, osmium::item_type type, osmium::object_id_type id) noexcept :
+                m_box(box),
+                m_id(id),
+                m_type(static_cast<uint32_t>(type)) {
+            }
+
+            const osmium::Box& box() const noexcept {
+                return m_box;
+            }
+
+            osmium::item_type type() const noexcept {
+                return static_cast<osmium::item_type>(m_type);
+            }
+
+            osmium::object_id_type id() const noexcept {
+                return m_id;
+            }
+
+        }; // class packed_rtree_entry
+
+        namespace detail {
+
+            /**
+             * Header of the file format written by PackedRTreeBuilder::dump()
+             * and read by the PackedRTree.
+             *
+             * The header is followed by `num_levels` uint64_t with the end
+             * of each level in the node numbering, then the
+             * `num_entries` leaf entries sorted along the Hilbert curve,
+             * and then the bounding boxes of all inner nodes level by
+             * level. The root node is the last one.
+             */
+            struct packed_rtree_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t node_size;
+                uint64_t num_entries;
+                uint64_t num_levels;
+            }; // struct packed_rtree_header
+
+            constexpr const char packed_rtree_magic[8] = {'O', 'S', 'M', 'R', 'T', 'R', 'E', 'E'};
+
+            enum : uint32_t {
+                packed_rtree_version = 1
+            };
+
+            /**
+             * Position of the point (x, y) on the Hilbert curve filling
+             * the 2^16 x 2^16 grid.
+             *
+             * Branch-free algorithm from
+             * http://threadlocalmutex.com/?p=126 (public domain).
+             */
+            inline uint32_t hilbert_index(uint32_t x, uint32_t y) noexcept {
+                uint32_t a = x ^ y;
+                uint32_t b = 0xffffU ^ a;
+                uint32_t c = 0xffffU ^ (x | y);
+                uint32_t d = x & (y ^ 0xffffU);
+
+                uint32_t na = a | (b >> 1U);
+                uint32_t nb = (a >> 1U) ^ a;
+                uint32_t nc = ((c >> 1U) ^ (b & (d >> 1U))) ^ c;
+                uint32_t nd = ((a & (c >> 1U)) ^ (d >> 1U)) ^ d;
+
+                a = na;
+                b = nb;
+                c = nc;
+                d = nd;
+                na = (a & (a >> 2U)) ^ (b & (b >> 2U));
+                nb = (a & (b >> 2U)) ^ (b & ((a ^ b) >> 2U));
+                nc = c ^ ((a & (c >> 2U)) ^ (b & (d >> 2U)));
+                nd = d ^ ((b & (c >> 2U)) ^ ((a ^ b) & (d >> 2U)));
+
+                a = na;
+                b = nb;
+                c = nc;
+                d = nd;
+                na = (a & (a >> 4U)) ^ (b & (b >> 4U));
+                nb = (a & (b >> 4U)) ^ (b & ((a ^ b) >> 4U));
+                nc = c ^ ((a & (c >> 4U)) ^ (b & (d >> 4U)));
+                nd = d ^ ((b & (c >> 4U)) ^ ((a ^ b) & (d >> 4U)));
+
+                a = na;
+                b = nb;
+                c = nc ^ ((a & (nc >> 8U)) ^ (b & (nd >> 8U)));
+                d = nd ^ ((b & (nc >> 8U)) ^ ((a ^ b) & (nd >> 8U)));
+
+                a = c ^ (c >> 1U);
+                b = d ^ (d >> 1U);
+
+                uint32_t i0 = x ^ y;
+                uint32_t i1 = b | (0xffffU ^ (i0 | a));
+
+                const auto interleave = [](uint32_t v) noexcept {
+                    v = (v | (v << 8U)) & 0x00ff00ffU;
+                    v = (v | (v << 4U)) & 0x0f0f0f0fU;
+                    v = (v | (v << 2U)) & 0x33333333U;
+                    v = (v | (v << 1U)) & 0x55555555U;
+                    return v;
+                };
+
+                i0 = interleave(i0);
+                i1 = interleave(i1);
+
+                return (i1 << 1U) | i0;
+            }
+
+        } // namespace detail
+
+        /**
+         * Read-only spatial index on the bounding boxes of OSM objects.
+         * This is a packed Hilbert R-tree: The entries are sorted along the
+         * Hilbert curve and grouped into nodes of a fixed size, which are
+         * grouped again until there is only one root node. The tree is
+         * stored in one contiguous block of memory in the same format
+         * as in the file, so it can be mmapped from a file written with
+         * PackedRTreeBuilder::dump() without any further work.
+         *
+         * Usage:
+         * @code
+         * osmium::index::PackedRTreeBuilder builder;
+         * osmium::apply(reader, location_handler, builder);
+         * builder.dump(fd);
+         *
+         * // later, maybe in another program:
+         * osmium::index::PackedRTree index{fd};
+         * index.search(box, [](const osmium::index::packed_rtree_entry& entry) {
+         *     ...
+         * });
+         * @endcode
+         */
+        class PackedRTree {
+
+            using header_type = osmium::index::detail::packed_rtree_header;
+
+            osmium::MemoryMapping m_mapping;
+
+            const header_type* m_header = nullptr;
+            const uint64_t* m_level_bounds = nullptr;
+            const packed_rtree_entry* m_entries = nullptr;
+            const osmium::Box* m_boxes = nullptr;
+
+            static std::size_t checked_file_size(const int fd) {
+                const auto size = osmium::file_size(fd);
+                if (size < sizeof(header_type)) {
+                    throw std::runtime_error{"PackedRTree index file is too small"};
+                }
+                return size;
+            }
+
+            void check_and_setup() {
+                const char* data = m_mapping.get_addr<const char>();
+                m_header = reinterpret_cast<const header_type*>(data);
+
+                if (std::memcmp(m_header->magic, osmium::index::detail::packed_rtree_magic, sizeof(m_header->magic)) != 0) {
+                    throw std::runtime_error{"Not a PackedRTree index file"};
+                }
+                if (m_header->version != osmium::index::detail::packed_rtree_version) {
+                    throw std::runtime_error{"Unsupported PackedRTree index file version " + std::to_string(m_header->version)};
+                }
+                if (m_header->node_size < 2 || m_header->num_levels == 0 || m_header->num_levels > 64) {
+                    throw std::runtime_error{"Invalid PackedRTree index file header"};
+                }
+
+                const std::size_t bounds_offset = sizeof(header_type);
+                const std::size_t entries_offset = bounds_offset + m_header->num_levels * sizeof(uint64_t);
+                if (m_mapping.size() < entries_offset) {
+                    throw std::runtime_error{"PackedRTree index file has wrong size"};
+                }
+
+                // This also makes sure the calculations below can't overflow.
+                if (m_header->num_entries > (m_mapping.size() - entries_offset) / sizeof(packed_rtree_entry)) {
+                    throw std::runtime_error{"PackedRTree index file has wrong size"};
+                }
+
+                // The level bounds must match the layout the builder
+                // creates for this number of entries and node size.
+                m_level_bounds = reinterpret_cast<const uint64_t*>(data + bounds_offset);
+                uint64_t count = m_header->num_entries;
+                uint64_t total = count;
+                std::size_t level = 0;
+                while (true) {
+                    if (level >= m_header->num_levels || m_level_bounds[level] != total) {
+                        throw std::runtime_error{"Invalid PackedRTree index file level bounds"};
+                    }
+                    ++level;
+                    if (count <= 1) {
+                        break;
+                    }
+                    count = (count + m_header->node_size - 1) / m_header->node_size;
+                    total += count;
+                }
+                if (level != m_header->num_levels) {
+                    throw std::runtime_error{"Invalid PackedRTree index file level bounds"};
+                }
+
+                const std::size_t boxes_offset = entries_offset + m_header->num_entries * sizeof(packed_rtree_entry);
+                const std::size_t expected_size = boxes_offset + (total - m_header->num_entries) * sizeof(osmium::Box);
+                if (m_mapping.size() != expected_size) {
+                    throw std::runtime_error{"PackedRTree index file has wrong size"};
+                }
+
+                m_entries = reinterpret_cast<const packed_rtree_entry*>(data + entries_offset);
+                m_boxes = reinterpret_cast<const osmium::Box*>(data + boxes_offset);
+            }
+
+            const osmium::Box& node_box(const uint64_t node) const noexcept {
+                if (node < m_header->num_entries) {
+                    return m_entries[node].box();
+                }
+                return m_boxes[node - m_header->num_entries];
+            }
+
+            uint64_t level_begin(const std::size_t level) const noexcept {
+                return level == 0 ? 0 : m_level_bounds[level - 1];
+            }
+
+        public:
+
+            /**
+             * Open PackedRTree index file.
+             *
+             * @param fd File descriptor of a file written with
+             *           PackedRTreeBuilder::dump(). Only needs to be open
+             *           for reading.
+             * @throws std::runtime_error If the file is not a valid
+             *         PackedRTree index file.
+             * @throws std::system_error If the mmap fails.
+             */
+            explicit PackedRTree(const int fd) :
+                m_mapping(checked_file_size(fd), osmium::MemoryMapping::mapping_mode::readonly, fd) {
+                check_and_setup();
+            }
+
+            /**
+             * Create PackedRTree index from a memory mapping containing the
+             * data in the same format as the file. This is used by
+             * PackedRTreeBuilder::build().
+             *
+             * @throws std::runtime_error If the data is not a valid
+             *         PackedRTree index.
+             */
+            explicit PackedRTree(osmium::MemoryMapping&& mapping) :
+                m_mapping(std::move(mapping)) {
+                if (m_mapping.size() < sizeof(header_type)) {
+                    throw std::runtime_error{"PackedRTree index data is too small"};
+                }
+                check_and_setup();
+            }
+
+            /// The number of entries in the index.
+            std::size_t size() const noexcept {
+                return m_header ? static_cast<std::size_t>(m_header->num_entries) : 0;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            std::size_t used_memory() const noexcept {
+                return m_mapping ? m_mapping.size() : 0;
+            }
+
+            /**
+             * The bounding box of all entries in the index. Invalid if the
+             * index is empty.
+             */
+            osmium::Box envelope() const noexcept {
+                if (empty()) {
+                    return osmium::Box{};
+                }
+                return node_box(m_level_bounds[m_header->num_levels - 1] - 1);
+            }
+
+            /**
+             * Call func for all entries whose bounding box overlaps the
+             * given box (including touching it). The entries are visited
+             * in no particular order.
+             *
+             * @param box The bounding box to search for.
+             * @param func Function called with a const packed_rtree_entry&.
+             */
+            template <typename TFunc>
+            void search(const osmium::Box& box, TFunc&& func) const {
+                if (empty() || !box.valid()) {
+                    return;
+                }
+
+                // (level, node) pairs still to be visited
+                std::vector<std::pair<std::size_t, uint64_t>> stack;
+
+                const std::size_t top_level = m_header->num_levels - 1;
+                const uint64_t root = m_level_bounds[top_level] - 1;
+                if (!osmium::geom::overlaps(node_box(root), box)) {
+                    return;
+                }
+                if (top_level == 0) {
+                    func(m_entries[root]);
+                    return;
+                }
+                stack.emplace_back(top_level, root);
+
+                while (!stack.empty()) {
+                    const std::size_t level = stack.back().first;
+                    const uint64_t node = stack.back().second;
+                    stack.pop_back();
+
+                    const uint64_t first = level_begin(level - 1) + (node - level_begin(level)) * m_header->node_size;
+                    const uint64_t last = std::min(first + m_header->node_size, m_level_bounds[level - 1]);
+
+                    if (level == 1) {
+                        for (uint64_t child = first; child < last; ++child) {
+                            if (osmium::geom::overlaps(m_entries[child].box(), box)) {
+                                func(m_entries[child]);
+                            }
+                        }
+                    } else {
+                        for (uint64_t child = first; child < last; ++child) {
+                            if (osmium::geom::overlaps(m_boxes[child - m_header->num_entries], box)) {
+                                stack.emplace_back(level - 1, child);
+                            }
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Get all entries whose bounding box overlaps the given box
+             * (including touching it).
+             */
+            std::vector<packed_rtree_entry> search(const osmium::Box& box) const {
+                std::vector<packed_rtree_entry> result;
+                search(box, [&result](const packed_rtree_entry& entry) {
+                    result.push_back(entry);
+                });
+                return result;
+            }
+
+            /**
+             * Call func for all entries whose bounding box contains the
+             * given location. Used for instance to find candidate areas for
+             * a point-in-polygon test with osmium::geom::within().
+             */
+            template <typename TFunc>
+            void search(const osmium::Location& location, TFunc&& func) const {
+                search(osmium::Box{location, location}, std::forward<TFunc>(func));
+            }
+
+        }; // class PackedRTree
+
+        /**
+         * Collects bounding boxes of OSM objects and builds a PackedRTree
+         * from them. This is a handler, so it can be used with
+         * osmium::apply() in the same pass that reads the data. Way
+         * envelopes need the node locations, so put a location handler
+         * before it.
+         *
+         * Nodes, ways, and areas are added, depending on the entity
+         * bits given in the constructor. Objects without valid locations
+         * are ignored. Other objects can be added with add().
+         *
+         * The builder needs 32 bytes per entry.
+         */
+        class PackedRTreeBuilder : public osmium::handler::Handler {
+
+            std::vector<packed_rtree_entry> m_entries;
+            std::vector<uint64_t> m_level_bounds;
+            std::vector<osmium::Box> m_boxes;
+            osmium::osm_entity_bits::type m_entities;
+            uint32_t m_node_size;
+
+            // Sort the entries along the Hilbert curve and calculate the
+            // bounding boxes of all inner nodes.
+            void prepare() {
+                osmium::Box extent;
+                for (const auto& entry : m_entries) {
+                    extent.extend(entry.box());
+                }
+
+                if (!m_entries.empty()) {
+                    const int64_t min_x = extent.bottom_left().x();
+                    const int64_t min_y = extent.bottom_left().y();
+                    const int64_t width = std::max(int64_t{1}, int64_t{extent.top_right().x()} - min_x);
+                    const int64_t height = std::max(int64_t{1}, int64_t{extent.top_right().y()} - min_y);
+
+                    std::vector<std::pair<uint32_t, std::size_t>> order;
+                    order.reserve(m_entries.size());
+                    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+                        const auto& box = m_entries[i].box();
+                        // doubled center to stay in integers
+                        const int64_t cx = int64_t{box.bottom_left().x()} + box.top_right().x() - 2 * min_x;
+                        const int64_t cy = int64_t{box.bottom_left().y()} + box.top_right().y() - 2 * min_y;
+                        const auto x = static_cast<uint32_t>(cx * 0xffff / (2 * width));
+                        const auto y = static_cast<uint32_t>(cy * 0xffff / (2 * height));
+                        order.emplace_back(osmium::index::detail::hilbert_index(x, y), i);
+                    }
+                    std::sort(order.begin(), order.end());
+
+                    std::vector<packed_rtree_entry> sorted;
+                    sorted.reserve(m_entries.size());
+                    for (const auto& o : order) {
+                        sorted.push_back(m_entries[o.second]);
+                    }
+                    using std::swap;
+                    swap(sorted, m_entries);
+                }
+
+                m_level_bounds.clear();
+                m_boxes.clear();
+
+                uint64_t count = m_entries.size();
+                uint64_t total = count;
+                m_level_bounds.push_back(total);
+                while (count > 1) {
+                    count = (count + m_node_size - 1) / m_node_size;
+                    total += count;
+                    m_level_bounds.push_back(total);
+                }
+
+                m_boxes.resize(total - m_entries.size());
+
+                const auto node_box = [this](uint64_t node) -> const osmium::Box& {
+                    if (node < m_entries.size()) {
+                        return m_entries[node].box();
+                    }
+                    return m_boxes[node - m_entries.size()];
+                };
+
+                for (std::size_t level = 1; level < m_level_bounds.size(); ++level) {
+                    const uint64_t child_begin = level == 1 ? 0 : m_level_bounds[level - 2];
+                    const uint64_t child_end = m_level_bounds[level - 1];
+                    uint64_t node = child_end;
+                    for (uint64_t child = child_begin; child < child_end; child += m_node_size, ++node) {
+                        osmium::Box box;
+                        const uint64_t last = std::min(child + m_node_size, child_end);
+                        for (uint64_t c = child; c < last; ++c) {
+                            box.extend(node_box(c));
+                        }
+                        m_boxes[node - m_entries.size()] = box;
+                    }
+                }
+            }
+
+            osmium::index::detail::packed_rtree_header header() const noexcept {
+                osmium::index::detail::packed_rtree_header header;
+                std::memcpy(header.magic, osmium::index::detail::packed_rtree_magic, sizeof(header.magic));
+                header.version = osmium::index::detail::packed_rtree_version;
+                header.node_size = m_node_size;
+                header.num_entries = m_entries.size();
+                header.num_levels = m_level_bounds.size();
+                return header;
+            }
+
+            std::size_t data_size() const noexcept {
+                return sizeof(osmium::index::detail::packed_rtree_header) +
+                       sizeof(uint64_t) * m_level_bounds.size() +
+                       sizeof(packed_rtree_entry) * m_entries.size() +
+                       sizeof(osmium::Box) * m_boxes.size();
+            }
+
+        public:
+
+            /**
+             * Create builder.
+             *
+             * @param entities Which kinds of objects should be added by
+             *                 the handler functions.
+             * @param node_size The number of children of each node in the
+             *                  tree.
+             * @throws std::invalid_argument if node_size < 2
+             */
+            explicit PackedRTreeBuilder(osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::node | osmium::osm_entity_bits::way | osmium::osm_entity_bits::area,
+                                        uint32_t node_size = 16) :
+                m_entities(entities),
+                m_node_size(node_size) {
+                if (node_size < 2) {
+                    throw std::invalid_argument{"PackedRTree node size must be at least 2"};
+                }
+            }
+
+            /// The number of entries added so far.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            void reserve(std::size_t size) {
+                m_entries.reserve(size);
+            }
+
+            /**
+             * Add an entry. Invalid boxes are ignored.
+             */
+            void add(const osmium::Box& box, osmium::item_type type, osmium::object_id_type id) {
+                if (box.valid()) {
+                    m_entries.emplace_back(box, type, id);
+                }
+            }
+
+            void node(const osmium::Node& node) {
+                if (m_entities & osmium::osm_entity_bits::node) {
+                    add(osmium::Box{node.location(), node.location()}, osmium::item_type::node, node.id());
+                }
+            }
+
+            void way(const osmium::Way& way) {
+                if (m_entities & osmium::osm_entity_bits::way) {
+                    add(way.envelope(), osmium::item_type::way, way.id());
+                }
+            }
+
+            void area(const osmium::Area& area) {
+                if (m_entities & osmium::osm_entity_bits::area) {
+                    add(area.envelope(), osmium::item_type::area, area.id());
+                }
+            }
+
+            /**
+             * Build the index in (anonymous) memory. The builder can be
+             * used to add more entries after this, but the entries are
+             * reordered.
+             *
+             * @throws std::system_error If the memory mapping fails.
+             */
+            PackedRTree build() {
+                prepare();
+
+                osmium::MemoryMapping mapping{data_size(), osmium::MemoryMapping::mapping_mode::write_private};
+                char* data = mapping.get_addr<char>();
+
+                const auto h = header();
+                std::memcpy(data, &h, sizeof(h));
+                data += sizeof(h);
+                std::memcpy(data, m_level_bounds.data(), sizeof(uint64_t) * m_level_bounds.size());
+                data += sizeof(uint64_t) * m_level_bounds.size();
+                if (!m_entries.empty()) {
+                    std::memcpy(data, m_entries.data(), sizeof(packed_rtree_entry) * m_entries.size());
+                    data += sizeof(packed_rtree_entry) * m_entries.size();
+                }
+                if (!m_boxes.empty()) {
+                    std::memcpy(data, m_boxes.data(), sizeof(osmium::Box) * m_boxes.size());
+                }
+
+                return PackedRTree{std::move(mapping)};
+            }
+
+            /**
+             * Write the index to a file which can be opened with the
+             * PackedRTree. The builder can be used to add more entries
+             * after this, but the entries are reordered.
+             *
+             * @throws std::system_error If the file could not be written.
+             */
+            void dump(const int fd) {
+                prepare();
+
+                const auto h = header();
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&h), sizeof(h));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_level_bounds.data()), sizeof(uint64_t) * m_level_bounds.size());
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_entries.data()), sizeof(packed_rtree_entry) * m_entries.size());
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_boxes.data()), sizeof(osmium::Box) * m_boxes.size());
+            }
+
+        }; // class PackedRTreeBuilder
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_PACKED_RTREE_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/id_set.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
@@ -43,9 +44,13 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -137,6 +142,119 @@ namespace osmium {
 
             std::vector<element> m_elements{};
 
+            enum : std::size_t {
+                empty_slot = std::numeric_limits<std::size_t>::max()
+            };
+
+            // Optional data structures to speed up lookups. They are only
+            // allocated if enabled, so they don't cost anything otherwise.
+            struct lookup_index {
+
+                // Open addressing hash table mapping member IDs to the
+                // position of the first element with this ID in m_elements.
+                // Empty slots have position empty_slot.
+                std::vector<std::pair<osmium::object_id_type, std::size_t>> hash{};
+                std::size_t hash_mask = 0;
+                bool use_hash = false;
+
+                // Bitmap of all positive member IDs used to reject objects
+                // that aren't members without any search.
+                osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids{};
+                bool use_ids = false;
+
+            }; // struct lookup_index
+
+            std::unique_ptr<lookup_index> m_lookup_index{};
+
+            static std::size_t hash_id(osmium::object_id_type id) noexcept {
+                uint64_t h = static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ULL;
+                h ^= h >> 32U;
+                return static_cast<std::size_t>(h);
+            }
+
+            lookup_index& get_lookup_index() {
+                if (!m_lookup_index) {
+                    m_lookup_index.reset(new lookup_index{});
+                }
+                return *m_lookup_index;
+            }
+
+            void build_hash_index() {
+                auto& index = *m_lookup_index;
+
+                std::size_t num_ids = 0;
+                for (std::size_t i = 0; i < m_elements.size(); ++i) {
+                    if (i == 0 || m_elements[i].member_id != m_elements[i - 1].member_id) {
+                        ++num_ids;
+                    }
+                }
+
+                // Keep the load factor at or below 0.5.
+                std::size_t size = 16;
+                while (size < num_ids * 2) {
+                    size *= 2;
+                }
+                index.hash.assign(size, std::make_pair(osmium::object_id_type{0}, std::size_t{empty_slot}));
+                index.hash_mask = size - 1;
+
+                for (std::size_t i = 0; i < m_elements.size(); ++i) {
+                    const auto id = m_elements[i].member_id;
+                    if (i > 0 && id == m_elements[i - 1].member_id) {
+                        continue;
+                    }
+                    std::size_t slot = hash_id(id) & index.hash_mask;
+                    while (index.hash[slot].second != empty_slot) {
+                        slot = (slot + 1) & index.hash_mask;
+                    }
+                    index.hash[slot] = std::make_pair(id, i);
+                }
+            }
+
+            void build_id_filter() {
+                auto& index = *m_lookup_index;
+                for (const auto& elem : m_elements) {
+                    if (elem.member_id > 0) {
+                        index.ids.set(static_cast<osmium::unsigned_object_id_type>(elem.member_id));
+                    }
+                }
+            }
+
+            // Find the elements with the specified id using the lookup
+            // index. Returns false if the index can't help and the normal
+            // search has to be used.
+            template <typename TIterator>
+            bool find_in_lookup_index(TIterator begin, TIterator end, osmium::object_id_type id, iterator_range<TIterator>& range) const noexcept {
+                const auto& index = *m_lookup_index;
+
+                if (index.use_ids && id > 0 && !index.ids.get(static_cast<osmium::unsigned_object_id_type>(id))) {
+                    range = make_range(std::make_pair(end, end));
+                    return true;
+                }
+
+                if (!index.use_hash) {
+                    return false;
+                }
+
+                std::size_t slot = hash_id(id) & index.hash_mask;
+                while (index.hash[slot].second != empty_slot && index.hash[slot].first != id) {
+                    slot = (slot + 1) & index.hash_mask;
+                }
+
+                const auto pos = index.hash[slot].second;
+                if (pos == empty_slot) {
+                    range = make_range(std::make_pair(end, end));
+                    return true;
+                }
+
+                auto first = begin + static_cast<std::ptrdiff_t>(pos);
+                auto last = first;
+                while (last != end && last->member_id == id) {
+                    ++last;
+                }
+                range = make_range(std::make_pair(first, last));
+                return true;
+            }
+
         protected:
 
             osmium::ItemStash& m_stash;
@@ -152,10 +270,18 @@ namespace osmium {
             using const_iterator = std::vector<element>::const_iterator;
 
             iterator_range<iterator> find(osmium::object_id_type id) {
+                auto range = make_range(std::make_pair(m_elements.end(), m_elements.end()));
+                if (m_lookup_index && find_in_lookup_index(m_elements.begin(), m_elements.end(), id, range)) {
+                    return range;
+                }
                 return make_range(std::equal_range(m_elements.begin(), m_elements.end(), element{id}, compare_member_id{}));
             }
 
             iterator_range<const_iterator> find(osmium::object_id_type id) const {
+                auto range = make_range(std::make_pair(m_elements.cend(), m_elements.cend()));
+                if (m_lookup_index && find_in_lookup_index(m_elements.cbegin(), m_elements.cend(), id, range)) {
+                    return range;
+                }
                 return make_range(std::equal_range(m_elements.cbegin(), m_elements.cend(), element{id}, compare_member_id{}));
             }
 
@@ -186,7 +312,43 @@ namespace osmium {
              */
             std::size_t used_memory() const noexcept {
                 return sizeof(element) * m_elements.capacity() +
-                       sizeof(MembersDatabaseCommon);
+                       sizeof(MembersDatabaseCommon) +
+                       (m_lookup_index ? sizeof(lookup_index) +
+                                         sizeof(std::pair<osmium::object_id_type, std::size_t>) * m_lookup_index->hash.capacity() +
+                                         m_lookup_index->ids.used_memory()
+                                       : 0);
+            }
+
+            /**
+             * Use a hash table to look up members instead of a binary search
+             * in the sorted list of members. This makes checking whether an
+             * object is a member (which is done for every object in the
+             * second pass) a constant time operation. This helps most if
+             * objects are looked up in random order, with sorted input the
+             * binary search is fairly cache friendly. The hash table needs
+             * 32 to 64 bytes per distinct member ID.
+             *
+             * Must be called before prepare_for_lookup().
+             */
+            void enable_hash_index() {
+                assert(m_init_phase && "Call MembersDatabase::enable_hash_index() before prepare_for_lookup().");
+                get_lookup_index().use_hash = true;
+            }
+
+            /**
+             * Keep a bitmap of all member IDs and check it before looking up
+             * members. Objects that aren't members (the vast majority of
+             * objects in the second pass) are then rejected after checking a
+             * single bit. With sorted input those checks are also very cache
+             * friendly. The bitmap needs one bit per ID for all ID ranges
+             * containing members (see IdSetDense), so this works best if the
+             * member IDs are dense. It can be combined with the hash index.
+             *
+             * Must be called before prepare_for_lookup().
+             */
+            void enable_id_filter() {
+                assert(m_init_phase && "Call MembersDatabase::enable_id_filter() before prepare_for_lookup().");
+                get_lookup_index().use_ids = true;
             }
 
             /**
@@ -259,6 +421,14 @@ namespace osmium {
             void prepare_for_lookup() {
                 assert(m_init_phase && "Can not call MembersDatabase::prepare_for_lookup() twice.");
                 std::sort(m_elements.begin(), m_elements.end());
+                if (m_lookup_index) {
+                    if (m_lookup_index->use_hash) {
+                        build_hash_index();
+                    }
+                    if (m_lookup_index->use_ids) {
+                        build_id_filter();
+                    }
+                }
 #ifndef NDEBUG
                 m_init_phase = false;
 #endif
@@ -277,7 +447,7 @@ namespace osmium {
 
                 // If this is the last time this object was needed, remove it
                 // from the stash.
-                if (count_not_removed(range) == 1) {
+                if (count_not_removed(range) == 1 && range.begin()->object_handle.valid()) {
                     m_stash.remove_item(range.begin()->object_handle);
                 }
 
@@ -295,7 +465,8 @@ namespace osmium {
              * with that id in the database.
              *
              * Complexity: Logarithmic in the number of members tracked (as
-             *             returned by size()).
+             *             returned by size()), constant if the hash index
+             *             is enabled or if the ID filter rejects the ID.
              */
             const osmium::OSMObject* get_object(osmium::object_id_type id) const {
                 assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling get_object().");
@@ -391,7 +562,8 @@ namespace osmium {
              * with that id in the database.
              *
              * Complexity: Logarithmic in the number of members tracked (as
-             *             returned by size()).
+             *             returned by size()), constant if the hash index
+             *             is enabled or if the ID filter rejects the ID.
              */
             const TObject* get(osmium::object_id_type id) const {
                 assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling get().");
@@ -38,6 +38,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/callback_buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -227,6 +228,39 @@ namespace osmium {
                 return member_relations_database().get(id);
             }
 
+            /**
+             * Move objects in the internal stash into a temporary file when
+             * the stash takes up more than max_memory bytes. The file is
+             * mapped into memory so that objects stay accessible, but the
+             * operating system can page them out. See
+             * ItemStash::enable_spilling() for details.
+             */
+            void enable_stash_spilling(std::size_t max_memory) noexcept {
+                m_stash.enable_spilling(max_memory);
+            }
+
+            /**
+             * Use hash tables to look up members in the second pass instead
+             * of binary searches. See MembersDatabaseCommon::enable_hash_index()
+             * for details. Must be called before prepare_for_lookup().
+             */
+            void enable_member_hash_index() {
+                m_member_nodes_db.enable_hash_index();
+                m_member_ways_db.enable_hash_index();
+                m_member_relations_db.enable_hash_index();
+            }
+
+            /**
+             * Check a bitmap of member IDs before looking up members in the
+             * second pass. See MembersDatabaseCommon::enable_id_filter() for
+             * details. Must be called before prepare_for_lookup().
+             */
+            void enable_member_id_filter() {
+                m_member_nodes_db.enable_id_filter();
+                m_member_ways_db.enable_id_filter();
+                m_member_relations_db.enable_id_filter();
+            }
+
             /**
              * Sort the members databases to prepare them for reading. Usually
              * this is called between the first and second pass reading through
@@ -306,6 +340,28 @@ namespace osmium {
 
             SecondPassHandler<RelationsManager> m_handler_pass2;
 
+            // After the input has passed the member with this type and id,
+            // the relation at position pos in the relations database can
+            // not be completed any more.
+            struct deadline {
+                osmium::item_type type;
+                osmium::object_id_type id;
+                std::size_t pos;
+            };
+
+            // Deadlines sorted in reverse, the next one is at the back.
+            std::vector<deadline> m_deadlines;
+
+            bool m_early_release = false;
+            bool m_deadlines_ready = false;
+
+            static bool before(osmium::item_type type1, osmium::object_id_type id1, osmium::item_type type2, osmium::object_id_type id2) noexcept {
+                if (type1 != type2) {
+                    return type1 < type2;
+                }
+                return osmium::id_order{}(id1, id2);
+            }
+
             static bool wanted_type(osmium::item_type type) noexcept {
                 return (TNodes     && type == osmium::item_type::node) ||
                        (TWays      && type == osmium::item_type::way) ||
@@ -438,6 +494,43 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called before the output buffer is flushed,
+             * usually after each input buffer.
+             *
+             * Overwrite this method in a derived class if it produces some
+             * of its output asynchronously and wants to add what is ready
+             * so far to the output buffer. It should not wait for output
+             * still being produced.
+             */
+            void before_flush() const noexcept {
+            }
+
+            /**
+             * This method is called before the output buffer is read by the
+             * user.
+             *
+             * Overwrite this method in a derived class if it produces some
+             * of its output asynchronously and has to add all of it to the
+             * output buffer before the buffer is handed out.
+             */
+            void before_read() const noexcept {
+            }
+
+            /**
+             * This method is called for relations that can never be
+             * completed, because the input has passed the IDs of all their
+             * members without finding all of them. It is only called if
+             * enable_early_release() was called. The relation and the
+             * members found so far are removed from the databases after
+             * this call.
+             *
+             * Overwrite this method in a derived class if you are interested
+             * in this.
+             */
+            void incomplete_relation(const osmium::Relation& /*relation*/) const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
@@ -455,6 +548,61 @@ namespace osmium {
                 rel_handle.remove();
             }
 
+            void build_deadlines() {
+                relations_database().for_each_relation([this](const RelationHandle& rel_handle) {
+                    const osmium::RelationMember* last = nullptr;
+                    for (const auto& member : rel_handle->members()) {
+                        if (member.ref() != 0 &&
+                            (!last || before(last->type(), last->ref(), member.type(), member.ref()))) {
+                            last = &member;
+                        }
+                    }
+                    if (last) {
+                        m_deadlines.push_back(deadline{last->type(), last->ref(), rel_handle.pos()});
+                    }
+                });
+
+                std::sort(m_deadlines.begin(), m_deadlines.end(), [](const deadline& a, const deadline& b) {
+                    return before(b.type, b.id, a.type, a.id);
+                });
+
+                m_deadlines_ready = true;
+            }
+
+            // Release all relations that still miss members although the
+            // input has passed all their members.
+            void release_incomplete_relations(osmium::item_type type, osmium::object_id_type id) {
+                if (!m_early_release) {
+                    return;
+                }
+
+                if (!m_deadlines_ready) {
+                    build_deadlines();
+                }
+
+                while (!m_deadlines.empty() && before(m_deadlines.back().type, m_deadlines.back().id, type, id)) {
+                    auto rel_handle = relations_database()[m_deadlines.back().pos];
+                    m_deadlines.pop_back();
+
+                    // Relations already completed have been removed and
+                    // have no missing members.
+                    if (rel_handle.has_all_members()) {
+                        continue;
+                    }
+
+                    derived().incomplete_relation(*rel_handle);
+                    possibly_flush();
+
+                    for (const auto& member : rel_handle->members()) {
+                        if (member.ref() != 0) {
+                            member_database(member.type()).remove(member.ref(), rel_handle->id());
+                        }
+                    }
+
+                    rel_handle.remove();
+                }
+            }
+
         public:
 
             RelationsManager() :
@@ -471,6 +619,40 @@ namespace osmium {
                 return m_handler_pass2;
             }
 
+            /**
+             * Flush the output buffer. Calls before_flush() in the derived
+             * class first.
+             */
+            void flush_output() {
+                derived().before_flush();
+                RelationsManagerBase::flush_output();
+            }
+
+            /**
+             * Remove relations from memory as soon as it is clear that they
+             * can not be completed, because the input has passed the IDs of
+             * all their members. The incomplete_relation() function in the
+             * derived class is called for each of those relations. This
+             * keeps memory use bounded by the relations "in flight" instead
+             * of growing with all incomplete relations in the input.
+             *
+             * This only works if the input is sorted by type and ID. Call
+             * this before the second pass. Relations released this way are
+             * not reported by for_each_incomplete_relation().
+             */
+            void enable_early_release() noexcept {
+                m_early_release = true;
+            }
+
+            /**
+             * Return the contents of the output buffer. Calls before_read()
+             * in the derived class first.
+             */
+            osmium::memory::Buffer read() {
+                derived().before_read();
+                return RelationsManagerBase::read();
+            }
+
             /**
              * Add the specified relation to the list of relations we want to
              * build. This calls the new_relation() and new_member()
@@ -499,6 +681,7 @@ namespace osmium {
             }
 
             void handle_node(const osmium::Node& node) {
+                release_incomplete_relations(osmium::item_type::node, node.id());
                 if (TNodes) {
                     m_check_order_handler.node(node);
                     derived().before_node(node);
@@ -514,6 +697,7 @@ namespace osmium {
             }
 
             void handle_way(const osmium::Way& way) {
+                release_incomplete_relations(osmium::item_type::way, way.id());
                 if (TWays) {
                     m_check_order_handler.way(way);
                     derived().before_way(way);
@@ -529,6 +713,7 @@ namespace osmium {
             }
 
             void handle_relation(const osmium::Relation& relation) {
+                release_incomplete_relations(osmium::item_type::relation, relation.id());
                 if (TRelations) {
                     m_check_order_handler.relation(relation);
                     derived().before_relation(relation);
@@ -0,0 +1,559 @@
+#ifndef OSMIUM_STORAGE_CONCURRENT_ITEM_STASH_HPP
+#define OSMIUM_STORAGE_CONCURRENT_ITEM_STASH_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/thread/shared_mutex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Stores items and gives out handles to access them again, like the
+     * ItemStash. But instead of one large buffer this uses a number of
+     * segment buffers of (mostly) fixed size. Adding items never moves
+     * items already in the stash. Memory used by removed items is
+     * reclaimed incrementally one segment at a time by compact(): live
+     * items of the segment with the most garbage are copied into the
+     * current segment and the old segment is freed.
+     *
+     * One writer thread can use add_item(), remove_item(), compact(), and
+     * garbage_collect(), while any number of reader threads access items
+     * with get_item() or get<>(). Readers must hold a read_lock while they
+     * access items and as long as they use references to them. Handles
+     * must be handed from the writer to the readers through some kind of
+     * synchronization (a mutex, a queue, a future, ...). Compaction,
+     * starting a new segment, and growing the handle index (once every
+     * 65536 items) wait until no read locks are held. All other member
+     * functions must only be called from the writer thread.
+     */
+    class ConcurrentItemStash {
+
+    public:
+
+        /**
+         * This is the type of the handle returned by the add_item() call.
+         * It is used to access the item again with get_item() or get<>()
+         * or erase it with remove_item().
+         *
+         * There is one special handle, the invalid handle. It can be created
+         * by calling the default constructor. Valid handles can only be
+         * constructed by the ConcurrentItemStash class.
+         */
+        class handle_type {
+
+            friend class ConcurrentItemStash;
+
+            std::size_t value; // NOLINT(modernize-use-default-member-init)
+
+            explicit handle_type(std::size_t new_value) noexcept :
+                value(new_value) {
+                assert(new_value > 0);
+            }
+
+        public:
+
+            /// The default constructor creates an invalid handle.
+            handle_type() noexcept :
+                value(0) {
+            }
+
+            /// Is this a valid handle?
+            bool valid() const noexcept {
+                return value != 0;
+            }
+
+            /**
+             * Print the handle for debugging purposes. An invalid handle
+             * will be printed as the single letter '-'. A valid handle will
+             * be printed as a unique (for a ConcurrentItemStash object)
+             * number.
+             */
+            template <typename TChar, typename TTraits>
+            friend inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const ConcurrentItemStash::handle_type& handle) {
+                if (handle.valid()) {
+                    out << handle.value;
+                } else {
+                    out << '-';
+                }
+                return out;
+            }
+
+        }; // class handle_type
+
+        /**
+         * Lock held by reader threads while they access items. Get one by
+         * calling lock_for_reading().
+         */
+        using read_lock = osmium::thread::shared_lock<osmium::thread::shared_mutex>;
+
+        enum : std::size_t {
+            default_segment_size = 1024UL * 1024UL
+        };
+
+    private:
+
+        enum : std::size_t {
+            index_chunk_bits = 16U,
+            index_chunk_size = 1UL << index_chunk_bits
+        };
+
+        // An index entry contains the segment number in the upper and the
+        // offset in the segment in the lower 32 bits.
+        enum : uint64_t {
+            removed_entry = std::numeric_limits<uint64_t>::max(),
+            offset_mask = 0xffffffffULL
+        };
+
+        struct segment {
+
+            osmium::memory::Buffer buffer;
+
+            // The handle values of all items in the order they are in the
+            // buffer. Used to update the index when compacting.
+            std::vector<std::size_t> handles{};
+
+            std::size_t count_removed = 0;
+            std::size_t removed_bytes = 0;
+
+            explicit segment(std::size_t size) :
+                buffer(size, osmium::memory::Buffer::auto_grow::no) {
+            }
+
+            std::size_t available() const noexcept {
+                return buffer.capacity() - buffer.committed();
+            }
+
+        }; // struct segment
+
+        std::size_t m_segment_size;
+
+        std::vector<std::unique_ptr<segment>> m_segments{};
+
+        // Slots in m_segments not in use at the moment.
+        std::vector<std::size_t> m_free_slots{};
+
+        // Slot of the segment new items are added to.
+        std::size_t m_current = 0;
+
+        // One freed segment is kept around for reuse.
+        std::unique_ptr<segment> m_spare{};
+
+        // The index from handles to index entries. It is split into chunks
+        // which never move. New chunks are only added while readers are
+        // locked out.
+        std::vector<std::unique_ptr<uint64_t[]>> m_index{};
+        // Atomic, because readers check handles against it in debug builds.
+        std::atomic<std::size_t> m_index_size{0};
+
+        std::size_t m_count_items = 0;
+        std::size_t m_count_removed = 0;
+
+        mutable osmium::thread::shared_mutex m_mutex{};
+
+        // Set while the writer holds m_mutex exclusively.
+        bool m_locked = false;
+
+        class exclusive_lock {
+
+            ConcurrentItemStash& m_stash;
+            bool m_owns;
+
+        public:
+
+            explicit exclusive_lock(ConcurrentItemStash& stash) :
+                m_stash(stash),
+                m_owns(!stash.m_locked) {
+                if (m_owns) {
+                    m_stash.m_mutex.lock();
+                    m_stash.m_locked = true;
+                }
+            }
+
+            exclusive_lock(const exclusive_lock&) = delete;
+            exclusive_lock& operator=(const exclusive_lock&) = delete;
+
+            exclusive_lock(exclusive_lock&&) = delete;
+            exclusive_lock& operator=(exclusive_lock&&) = delete;
+
+            ~exclusive_lock() noexcept {
+                if (m_owns) {
+                    m_stash.m_locked = false;
+                    m_stash.m_mutex.unlock();
+                }
+            }
+
+        }; // class exclusive_lock
+
+        uint64_t& entry(handle_type handle) const noexcept {
+            assert(handle.valid() && "handle must be valid");
+            assert(handle.value <= m_index_size.load(std::memory_order_relaxed));
+            const std::size_t n = handle.value - 1;
+            return m_index[n >> index_chunk_bits][n & (index_chunk_size - 1)];
+        }
+
+        osmium::memory::Item& item_at(uint64_t entry) const noexcept {
+            assert(entry != removed_entry);
+            assert(m_segments[entry >> 32U]);
+            return m_segments[entry >> 32U]->buffer.get<osmium::memory::Item>(entry & offset_mask);
+        }
+
+        void start_segment(std::size_t min_size) {
+            std::unique_ptr<segment> seg;
+            if (m_spare && min_size <= m_spare->buffer.capacity()) {
+                seg = std::move(m_spare);
+                seg->buffer.clear();
+                seg->handles.clear();
+                seg->count_removed = 0;
+                seg->removed_bytes = 0;
+            } else {
+                seg.reset(new segment{std::max(m_segment_size, min_size)});
+            }
+
+            if (m_free_slots.empty()) {
+                // Readers access m_segments, so it can only be changed
+                // while they are locked out. This happens only once per
+                // segment.
+                const exclusive_lock lock{*this};
+                m_current = m_segments.size();
+                m_segments.push_back(std::move(seg));
+            } else {
+                m_current = m_free_slots.back();
+                m_free_slots.pop_back();
+                m_segments[m_current] = std::move(seg);
+            }
+        }
+
+        void free_segment(std::size_t slot) {
+            assert(slot != m_current);
+            const exclusive_lock lock{*this};
+            auto& seg = m_segments[slot];
+            m_count_removed -= seg->count_removed;
+            if (seg->buffer.capacity() == m_segment_size) {
+                m_spare = std::move(seg);
+            } else {
+                seg.reset();
+            }
+            m_free_slots.push_back(slot);
+        }
+
+        // Copy item into the current segment (starting a new one if needed)
+        // and return the new index entry for it.
+        uint64_t store(const osmium::memory::Item& item, std::size_t handle_value) {
+            if (m_segments.empty() || m_segments[m_current]->available() < item.padded_size()) {
+                start_segment(item.padded_size());
+            }
+            auto& seg = *m_segments[m_current];
+            const auto offset = seg.buffer.committed();
+            seg.buffer.add_item(item);
+            seg.buffer.commit();
+            seg.handles.push_back(handle_value);
+            return (static_cast<uint64_t>(m_current) << 32U) | offset;
+        }
+
+        // Find the segment (other than the current one) with the most
+        // garbage where at least half of the memory is used by removed
+        // items. Returns the number of segments if there is none.
+        std::size_t find_compaction_candidate() const noexcept {
+            std::size_t candidate = m_segments.size();
+            std::size_t max_removed = 0;
+            for (std::size_t slot = 0; slot < m_segments.size(); ++slot) {
+                const auto& seg = m_segments[slot];
+                if (slot == m_current || !seg || seg->removed_bytes == 0) {
+                    continue;
+                }
+                if (seg->removed_bytes * 2 >= seg->buffer.committed() && seg->removed_bytes > max_removed) {
+                    candidate = slot;
+                    max_removed = seg->removed_bytes;
+                }
+            }
+            return candidate;
+        }
+
+    public:
+
+        /**
+         * Create a ConcurrentItemStash.
+         *
+         * @param segment_size Size of each segment in bytes. Items larger
+         *                     than this get a segment of their own.
+         * @throws std::invalid_argument if segment_size is zero or too
+         *         large.
+         */
+        explicit ConcurrentItemStash(std::size_t segment_size = default_segment_size) :
+            m_segment_size(segment_size) {
+            if (segment_size == 0 || segment_size > std::numeric_limits<uint32_t>::max() / 2) {
+                throw std::invalid_argument{"ConcurrentItemStash: invalid segment size"};
+            }
+        }
+
+        ConcurrentItemStash(const ConcurrentItemStash&) = delete;
+        ConcurrentItemStash& operator=(const ConcurrentItemStash&) = delete;
+
+        ConcurrentItemStash(ConcurrentItemStash&&) = delete;
+        ConcurrentItemStash& operator=(ConcurrentItemStash&&) = delete;
+
+        ~ConcurrentItemStash() noexcept = default;
+
+        /**
+         * Get a lock for reading. Hold it while accessing items from a
+         * reader thread. Items will not be moved as long as any read lock
+         * is held.
+         */
+        read_lock lock_for_reading() const {
+            return read_lock{m_mutex};
+        }
+
+        /**
+         * Return an estimate of the number of bytes currently used by this
+         * stash.
+         *
+         * Complexity: Linear in the number of segments.
+         */
+        std::size_t used_memory() const noexcept {
+            std::size_t size = sizeof(ConcurrentItemStash) +
+                               m_segments.capacity() * sizeof(std::unique_ptr<segment>) +
+                               m_index.size() * index_chunk_size * sizeof(uint64_t);
+            for (const auto& seg : m_segments) {
+                if (seg) {
+                    size += sizeof(segment) + seg->buffer.capacity() + seg->handles.capacity() * sizeof(std::size_t);
+                }
+            }
+            if (m_spare) {
+                size += sizeof(segment) + m_spare->buffer.capacity() + m_spare->handles.capacity() * sizeof(std::size_t);
+            }
+            return size;
+        }
+
+        /**
+         * The number of items currently in the stash. This is the number
+         * added minus the number removed.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t size() const noexcept {
+            return m_count_items;
+        }
+
+        /**
+         * The number of removed items whose memory has not been reclaimed
+         * by compaction yet.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t count_removed() const noexcept {
+            return m_count_removed;
+        }
+
+        /**
+         * The number of segments currently in use.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t num_segments() const noexcept {
+            return m_segments.size() - m_free_slots.size();
+        }
+
+        /**
+         * Clear all items from the stash. All handles are invalidated.
+         * Waits until no read locks are held.
+         */
+        void clear() {
+            const exclusive_lock lock{*this};
+            m_segments.clear();
+            m_free_slots.clear();
+            m_current = 0;
+            m_index.clear();
+            m_index_size.store(0, std::memory_order_relaxed);
+            m_count_items = 0;
+            m_count_removed = 0;
+        }
+
+        /**
+         * Add an item to the stash. Items already in the stash are not
+         * moved, so references to them stay valid. If a new segment is
+         * needed, one step of compaction is done first (see compact()).
+         * Waits until no read locks are held if a new segment or index
+         * chunk is needed.
+         *
+         * Complexity: Amortized constant.
+         */
+        handle_type add_item(const osmium::memory::Item& item) {
+            if (!m_segments.empty() && m_segments[m_current]->available() < item.padded_size()) {
+                compact();
+            }
+
+            const std::size_t n = m_index_size.load(std::memory_order_relaxed);
+            if (n % index_chunk_size == 0) {
+                // Readers access m_index, so it can only be changed while
+                // they are locked out. This happens only once per chunk.
+                std::unique_ptr<uint64_t[]> chunk{new uint64_t[index_chunk_size]};
+                const exclusive_lock lock{*this};
+                m_index.push_back(std::move(chunk));
+            }
+
+            const std::size_t handle_value = n + 1;
+            m_index[n >> index_chunk_bits][n & (index_chunk_size - 1)] = store(item, handle_value);
+            m_index_size.store(handle_value, std::memory_order_relaxed);
+            ++m_count_items;
+
+            return handle_type{handle_value};
+        }
+
+        /**
+         * Get a reference to an item in the stash. The reference will be
+         * invalidated by compaction. Reader threads must hold a read_lock
+         * while calling this and using the reference.
+         *
+         * Complexity: Constant.
+         *
+         * @param handle A handle returned by add_item().
+         *
+         * @pre Handle must be a valid handle and referring to a non-removed
+         *      item.
+         */
+        osmium::memory::Item& get_item(handle_type handle) const {
+            return item_at(entry(handle));
+        }
+
+        /**
+         * Get a reference to an item in the stash, see get_item().
+         *
+         * @tparam T Type you want to the data to be interpreted as. You must
+         *         be sure that the item has the specified type, this will
+         *         not be checked!
+         */
+        template <typename T>
+        T& get(handle_type handle) const {
+            return static_cast<T&>(get_item(handle));
+        }
+
+        /**
+         * Remove an item from the stash. The handle becomes invalid. If all
+         * items in a segment (other than the current one) are removed, the
+         * segment is freed immediately.
+         *
+         * Complexity: Constant.
+         *
+         * @pre Handle must be a valid handle and referring to a non-removed
+         *      item.
+         */
+        void remove_item(handle_type handle) {
+            auto& e = entry(handle);
+            auto& item = item_at(e);
+            assert(!item.removed() && "can not call remove_item() on already removed item");
+            item.set_removed(true);
+
+            const std::size_t slot = e >> 32U;
+            e = removed_entry;
+
+            auto& seg = *m_segments[slot];
+            ++seg.count_removed;
+            seg.removed_bytes += item.padded_size();
+            --m_count_items;
+            ++m_count_removed;
+
+            if (slot != m_current && seg.count_removed == seg.handles.size()) {
+                free_segment(slot);
+            }
+        }
+
+        /**
+         * Do one step of compaction: Find the segment with the most
+         * garbage (at least half of its memory must be used by removed
+         * items), copy the items still in it into the current segment and
+         * free it. Handles stay valid, references to moved items don't.
+         *
+         * Waits until no read locks are held.
+         *
+         * Complexity: Linear in the number of segments and the size of the
+         *             compacted segment.
+         *
+         * @returns true if a segment was compacted, false if there was no
+         *          segment worth compacting.
+         */
+        bool compact() {
+            const std::size_t slot = find_compaction_candidate();
+            if (slot == m_segments.size()) {
+                return false;
+            }
+
+            const exclusive_lock lock{*this};
+
+            // The segment object stays in place, even if m_segments is
+            // reallocated while we add items to new segments.
+            const segment& seg = *m_segments[slot];
+            std::size_t offset = 0;
+            for (const auto handle_value : seg.handles) {
+                const auto& item = seg.buffer.get<osmium::memory::Item>(offset);
+                offset += item.padded_size();
+                if (!item.removed()) {
+                    entry(handle_type{handle_value}) = store(item, handle_value);
+                }
+            }
+            assert(offset == seg.buffer.committed());
+
+            free_segment(slot);
+
+            return true;
+        }
+
+        /**
+         * Compact all segments with enough garbage, see compact().
+         *
+         * Complexity: Linear in the number of segments times the number of
+         *             compacted segments.
+         */
+        void garbage_collect() {
+            while (compact()) {
+            }
+        }
+
+    }; // class ConcurrentItemStash
+
+} // namespace osmium
+
+#endif // OSMIUM_STORAGE_CONCURRENT_ITEM_STASH_HPP
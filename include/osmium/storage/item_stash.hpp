@@ -33,13 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <cassert>
 #include <cstdlib>
 #include <limits>
+#include <memory>
 #include <ostream>
+#include <utility>
 #include <vector>
 
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
@@ -53,6 +58,12 @@ namespace osmium {
      * Class for storing OSM data in memory. Any osmium::memory::Item can be
      * added to the stash and it will be copied into its internal Buffer. To
      * access the item again, an opaque handle is used.
+     *
+     * Optionally items can be "spilled" into a temporary file when the
+     * memory used for the stash reaches a limit (see enable_spilling()).
+     * The file is mapped into memory, so spilled items can be accessed as
+     * before, but they don't count against the resident memory of the
+     * program, the operating system can page them out as needed.
      */
     class ItemStash {
 
@@ -119,14 +130,29 @@ namespace osmium {
             initial_buffer_size = 1024ul * 1024ul
         };
 
-        enum {
+        enum : std::size_t {
             removed_item_offset = std::numeric_limits<std::size_t>::max()
         };
 
+        // Offsets of items in the spill file have this bit set.
+        enum : std::size_t {
+            spilled_flag = ~(std::numeric_limits<std::size_t>::max() >> 1U)
+        };
+
         osmium::memory::Buffer m_buffer;
         std::vector<std::size_t> m_index;
         std::size_t m_count_items = 0;
         std::size_t m_count_removed = 0;
+
+        // Spill file (if any) and mapping of its contents.
+        int m_spill_fd = -1;
+        std::size_t m_spill_size = 0;
+        std::size_t m_max_memory = 0;
+
+        // All index entries before this position refer to spilled or
+        // removed items.
+        std::size_t m_first_unspilled = 0;
+        std::unique_ptr<osmium::MemoryMapping> m_spill_mapping;
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
         int64_t m_gc_time = 0;
 #endif
@@ -134,12 +160,13 @@ namespace osmium {
         class cleanup_helper {
 
             std::vector<std::size_t>& m_index;
-            std::size_t m_pos = 0;
+            std::size_t m_pos;
 
         public:
 
-            explicit cleanup_helper(std::vector<std::size_t>& index) :
-                m_index(index) {
+            cleanup_helper(std::vector<std::size_t>& index, std::size_t start) :
+                m_index(index),
+                m_pos(start) {
             }
 
             void moving_in_buffer(std::size_t old_offset, std::size_t new_offset) {
@@ -158,7 +185,7 @@ namespace osmium {
             assert(handle.value <= m_index.size());
             auto& offset = m_index[handle.value - 1];
             assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
+            assert((offset & spilled_flag) || offset < m_buffer.committed());
             return offset;
         }
 
@@ -167,10 +194,68 @@ namespace osmium {
             assert(handle.value <= m_index.size());
             const auto& offset = m_index[handle.value - 1];
             assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
+            assert((offset & spilled_flag) || offset < m_buffer.committed());
             return offset;
         }
 
+        osmium::memory::Item& item_at(std::size_t offset) const {
+            if (offset & spilled_flag) {
+                offset &= ~spilled_flag;
+                assert(m_spill_mapping && offset < m_spill_size);
+                return *reinterpret_cast<osmium::memory::Item*>(m_spill_mapping->get_addr<unsigned char>() + offset);
+            }
+            return m_buffer.get<osmium::memory::Item>(offset);
+        }
+
+        bool should_spill() const noexcept {
+            return m_max_memory > 0 && m_buffer.committed() >= m_max_memory;
+        }
+
+        // Write all items in the buffer to the end of the spill file and
+        // clear the buffer. Items are written in the order they were added,
+        // so if they were added in ID order, the file consists of ID-ordered
+        // segments. Only the index entries added since the last spill are
+        // updated. The mapping is grown to the new file size, depending on
+        // the system this means the file is mapped again as a whole, which
+        // is cheap, because nothing is read until it is accessed.
+        void spill() {
+            garbage_collect();
+
+            if (m_spill_fd < 0) {
+                m_spill_fd = osmium::detail::create_tmp_file();
+            }
+            osmium::io::detail::reliable_write(m_spill_fd, reinterpret_cast<const char*>(m_buffer.data()), m_buffer.committed());
+
+            for (auto it = m_index.begin() + m_first_unspilled; it != m_index.end(); ++it) {
+                if (*it != removed_item_offset) {
+                    assert(!(*it & spilled_flag));
+                    *it = (m_spill_size + *it) | spilled_flag;
+                }
+            }
+            m_first_unspilled = m_index.size();
+
+            m_spill_size += m_buffer.committed();
+            m_buffer.clear();
+
+            if (m_spill_size == 0) {
+                return;
+            }
+            if (m_spill_mapping) {
+                m_spill_mapping->resize(m_spill_size);
+            } else {
+                m_spill_mapping.reset(new osmium::MemoryMapping{m_spill_size, osmium::MemoryMapping::mapping_mode::write_shared, m_spill_fd});
+            }
+        }
+
+        void close_spill_file() {
+            m_spill_mapping.reset();
+            if (m_spill_fd >= 0) {
+                osmium::io::detail::reliable_close(m_spill_fd);
+                m_spill_fd = -1;
+            }
+            m_spill_size = 0;
+        }
+
         // This function decides whether it makes sense to garbage collect the
         // database. The values here are the result of some experimentation
         // with real data. We need to balance the memory use with the time
@@ -199,6 +284,71 @@ namespace osmium {
             m_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
         }
 
+        ItemStash(const ItemStash&) = delete;
+        ItemStash& operator=(const ItemStash&) = delete;
+
+        ItemStash(ItemStash&& other) noexcept :
+            m_buffer(std::move(other.m_buffer)),
+            m_index(std::move(other.m_index)),
+            m_count_items(other.m_count_items),
+            m_count_removed(other.m_count_removed),
+            m_spill_fd(other.m_spill_fd),
+            m_spill_size(other.m_spill_size),
+            m_max_memory(other.m_max_memory),
+            m_first_unspilled(other.m_first_unspilled),
+            m_spill_mapping(std::move(other.m_spill_mapping)) {
+            other.m_spill_fd = -1;
+            other.m_spill_size = 0;
+            other.m_first_unspilled = 0;
+        }
+
+        ItemStash& operator=(ItemStash&& other) noexcept {
+            using std::swap;
+            swap(m_buffer, other.m_buffer);
+            swap(m_index, other.m_index);
+            swap(m_count_items, other.m_count_items);
+            swap(m_count_removed, other.m_count_removed);
+            swap(m_spill_fd, other.m_spill_fd);
+            swap(m_spill_size, other.m_spill_size);
+            swap(m_max_memory, other.m_max_memory);
+            swap(m_first_unspilled, other.m_first_unspilled);
+            swap(m_spill_mapping, other.m_spill_mapping);
+            return *this;
+        }
+
+        ~ItemStash() noexcept {
+            try {
+                close_spill_file();
+            } catch (...) {
+                // ignore errors
+            }
+        }
+
+        /**
+         * Enable spilling items into a temporary file. Whenever the
+         * in-memory buffer holds more than max_memory bytes when a new item
+         * is added, all items in it are moved into the file. Handles stay
+         * valid, but pointers and references to items are invalidated.
+         * Space taken up by items removed after they have been
+         * spilled is not reclaimed until clear() is called.
+         *
+         * @param max_memory Maximum number of bytes kept in the in-memory
+         *                   buffer. Set to 0 to disable spilling (items
+         *                   already spilled stay in the file).
+         */
+        void enable_spilling(std::size_t max_memory) noexcept {
+            m_max_memory = max_memory;
+        }
+
+        /**
+         * The number of bytes in the spill file.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t spilled_bytes() const noexcept {
+            return m_spill_size;
+        }
+
         /**
          * Return an estimate of the number of bytes currently used by this
          * ItemStash instance.
@@ -240,6 +390,8 @@ namespace osmium {
             m_index.clear();
             m_count_items = 0;
             m_count_removed = 0;
+            m_first_unspilled = 0;
+            close_spill_file();
         }
 
         /**
@@ -249,7 +401,9 @@ namespace osmium {
          * Complexity: Amortized constant.
          */
         handle_type add_item(const osmium::memory::Item& item) {
-            if (should_gc()) {
+            if (should_spill()) {
+                spill();
+            } else if (should_gc()) {
                 garbage_collect();
             }
             ++m_count_items;
@@ -272,7 +426,7 @@ namespace osmium {
          *      item.
          */
         osmium::memory::Item& get_item(handle_type handle) const {
-            return m_buffer.get<osmium::memory::Item>(get_item_offset(handle));
+            return item_at(get_item_offset(handle));
         }
 
         /**
@@ -311,7 +465,7 @@ namespace osmium {
 #endif
 
             m_count_removed = 0;
-            cleanup_helper helper{m_index};
+            cleanup_helper helper{m_index, m_first_unspilled};
             m_buffer.purge_removed(&helper);
 
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
@@ -337,12 +491,14 @@ namespace osmium {
          */
         void remove_item(handle_type handle) {
             auto& offset = get_item_offset_ref(handle);
-            auto& item = m_buffer.get<osmium::memory::Item>(offset);
+            auto& item = item_at(offset);
             assert(!item.removed() && "can not call remove_item() on already removed item");
             item.set_removed(true);
+            if (!(offset & spilled_flag)) {
+                ++m_count_removed;
+            }
             offset = removed_item_offset;
             --m_count_items;
-            ++m_count_removed;
         }
 
     }; // class ItemStash
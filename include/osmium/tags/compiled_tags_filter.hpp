@@ -0,0 +1,299 @@
+#ifndef OSMIUM_TAGS_COMPILED_TAGS_FILTER_HPP
+#define OSMIUM_TAGS_COMPILED_TAGS_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/detail/string_index.hpp>
+#include <osmium/tags/matcher.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/util/string_matcher.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * A compiled version of a TagsFilterBase giving the same results with
+     * the same first-match semantics, but much faster for filters with
+     * many rules.
+     *
+     * When compiling, rules matching keys (and values) against equal or
+     * list StringMatchers are put into hash tables, so they are found
+     * with one lookup per tag instead of testing each rule in turn.
+     * Rules matching keys by prefix are put into a hash table looked up
+     * for each prefix length in use. Only the remaining rules (with
+     * substring, regex, or always_true key matchers) are checked one after
+     * the other. Rules that can never match are dropped.
+     *
+     * Changes to the original filter after compiling are not reflected in
+     * the compiled filter.
+     *
+     * @code
+     * osmium::TagsFilter filter{false};
+     * filter.add_rule(true, "highway", "primary");
+     * ...
+     * const osmium::CompiledTagsFilter compiled{filter};
+     * bool result = compiled(tag);
+     * @endcode
+     */
+    template <typename TResult>
+    class CompiledTagsFilterBase {
+
+        using rule_type = std::pair<TResult, TagMatcher>;
+
+        enum : std::size_t {
+            no_rule = detail::string_index::not_found
+        };
+
+        std::vector<rule_type> m_rules;
+
+        // Set for rules that match any value of a tag with matching key.
+        std::vector<bool> m_any_value;
+
+        // "key\0value" -> first rule matching this tag
+        detail::string_index m_tag_index;
+
+        // key -> bucket with rules matching this key
+        detail::string_index m_key_index;
+
+        // prefix -> bucket with rules matching keys with this prefix
+        detail::string_index m_prefix_index;
+
+        // m_prefix_lengths[n] is set if there is a prefix of length n
+        std::vector<bool> m_prefix_lengths;
+
+        // Each bucket contains rule numbers in order.
+        std::vector<std::vector<std::size_t>> m_buckets;
+
+        // Rules that have to be checked for every tag.
+        std::vector<std::size_t> m_other_rules;
+
+        TResult m_default_result;
+
+        void add_to_bucket(detail::string_index& index, const std::string& str, std::size_t rule) {
+            auto& bucket = index[str];
+            if (bucket == detail::string_index::not_found) {
+                bucket = m_buckets.size();
+                m_buckets.emplace_back();
+            }
+            m_buckets[bucket].push_back(rule);
+        }
+
+        static bool never_matches_value(const TagMatcher& matcher) noexcept {
+            const auto& value_matcher = matcher.value_matcher();
+            if (matcher.inverted()) {
+                return value_matcher.get<StringMatcher::always_true>() != nullptr;
+            }
+            return value_matcher.get<StringMatcher::always_false>() != nullptr;
+        }
+
+        static std::vector<std::string> exact_strings(const StringMatcher& matcher) {
+            if (const auto* m = matcher.get<StringMatcher::equal>()) {
+                return {m->str()};
+            }
+            return matcher.get<StringMatcher::list>()->strings();
+        }
+
+        static bool is_exact(const StringMatcher& matcher) noexcept {
+            return matcher.get<StringMatcher::equal>() || matcher.get<StringMatcher::list>();
+        }
+
+        void compile_rule(std::size_t rule) {
+            const TagMatcher& matcher = m_rules[rule].second;
+            const StringMatcher& key_matcher = matcher.key_matcher();
+            const StringMatcher& value_matcher = matcher.value_matcher();
+
+            if (key_matcher.get<StringMatcher::always_false>() || never_matches_value(matcher)) {
+                return;
+            }
+
+            if (is_exact(key_matcher)) {
+                if (!matcher.inverted() && is_exact(value_matcher)) {
+                    for (const auto& key : exact_strings(key_matcher)) {
+                        for (const auto& value : exact_strings(value_matcher)) {
+                            auto& first_rule = m_tag_index[key + '\0' + value];
+                            if (first_rule == detail::string_index::not_found) {
+                                first_rule = rule;
+                            }
+                        }
+                    }
+                } else {
+                    for (const auto& key : exact_strings(key_matcher)) {
+                        add_to_bucket(m_key_index, key, rule);
+                    }
+                }
+                return;
+            }
+
+            if (const auto* prefix = key_matcher.get<StringMatcher::prefix>()) {
+                add_to_bucket(m_prefix_index, prefix->str(), rule);
+                const auto length = prefix->str().size();
+                if (m_prefix_lengths.size() <= length) {
+                    m_prefix_lengths.resize(length + 1);
+                }
+                m_prefix_lengths[length] = true;
+                return;
+            }
+
+            m_other_rules.push_back(rule);
+        }
+
+        // Check the rules in the bucket before the best rule found so far.
+        void check_bucket(std::size_t bucket, const char* key, const char* value, std::size_t& best) const noexcept {
+            if (bucket == detail::string_index::not_found) {
+                return;
+            }
+            for (const auto rule : m_buckets[bucket]) {
+                if (rule >= best) {
+                    return;
+                }
+                if (m_any_value[rule] || m_rules[rule].second(key, value)) {
+                    best = rule;
+                    return;
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * Compile the specified filter.
+         */
+        explicit CompiledTagsFilterBase(const TagsFilterBase<TResult>& filter) :
+            m_rules(filter.rules()),
+            m_default_result(filter.default_result()) {
+            m_any_value.reserve(m_rules.size());
+            for (const auto& rule : m_rules) {
+                m_any_value.push_back(!rule.second.inverted() &&
+                                      rule.second.value_matcher().template get<StringMatcher::always_true>() != nullptr);
+            }
+            for (std::size_t rule = 0; rule < m_rules.size(); ++rule) {
+                compile_rule(rule);
+            }
+        }
+
+        /**
+         * Matching function. Check the specified key and value against
+         * the rules.
+         *
+         * @returns The result of the first matching rule, or, if none of
+         *          the rules matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
+            std::size_t best = no_rule;
+
+            uint64_t hash = detail::string_index::hash_start();
+            std::size_t key_length = 0;
+            for (; key[key_length] != '\0'; ++key_length) {
+                hash = detail::string_index::hash_add(hash, key[key_length]);
+            }
+
+            if (!m_tag_index.empty()) {
+                uint64_t tag_hash = detail::string_index::hash_add(hash, '\0');
+                std::size_t value_length = 0;
+                for (; value[value_length] != '\0'; ++value_length) {
+                    tag_hash = detail::string_index::hash_add(tag_hash, value[value_length]);
+                }
+                best = m_tag_index.find(key, key_length, value, value_length, tag_hash);
+            }
+
+            if (!m_key_index.empty()) {
+                check_bucket(m_key_index.find(key, key_length, nullptr, 0, hash), key, value, best);
+            }
+
+            if (!m_prefix_index.empty()) {
+                uint64_t prefix_hash = detail::string_index::hash_start();
+                const std::size_t max_length = std::min(key_length, m_prefix_lengths.size() - 1);
+                for (std::size_t length = 0; length <= max_length; ++length) {
+                    if (m_prefix_lengths[length]) {
+                        check_bucket(m_prefix_index.find(key, length, nullptr, 0, prefix_hash), key, value, best);
+                    }
+                    prefix_hash = detail::string_index::hash_add(prefix_hash, key[length]);
+                }
+            }
+
+            for (const auto rule : m_other_rules) {
+                if (rule >= best) {
+                    break;
+                }
+                if (m_rules[rule].second(key, value)) {
+                    best = rule;
+                    break;
+                }
+            }
+
+            return best == no_rule ? m_default_result : m_rules[best].first;
+        }
+
+        /**
+         * Matching function. Check the specified tag against the rules.
+         *
+         * @param tag A tag.
+         * @returns The result of the first matching rule, or, if none of
+         *          the rules matched, the default result.
+         */
+        TResult operator()(const osmium::Tag& tag) const noexcept {
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Return the number of rules in this filter.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t count() const noexcept {
+            return m_rules.size();
+        }
+
+        /**
+         * Is this filter empty, ie are there no rules defined?
+         *
+         * Complexity: Constant.
+         */
+        bool empty() const noexcept {
+            return m_rules.empty();
+        }
+
+    }; // class CompiledTagsFilterBase
+
+    using CompiledTagsFilter = CompiledTagsFilterBase<bool>;
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_COMPILED_TAGS_FILTER_HPP
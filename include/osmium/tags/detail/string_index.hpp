@@ -0,0 +1,172 @@
+#ifndef OSMIUM_TAGS_DETAIL_STRING_INDEX_HPP
+#define OSMIUM_TAGS_DETAIL_STRING_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Hash table from strings to indexes using open addressing. Used
+         * in the CompiledTagsFilterBase and KeyTable classes. The FNV-1a
+         * hash is used because it can be computed incrementally while
+         * walking a string, so hashes for all prefixes of a string are
+         * available for free.
+         */
+        class string_index {
+
+            struct entry {
+                std::string str;
+                uint64_t hash = 0;
+                std::size_t value = not_found;
+            };
+
+            std::vector<entry> m_table;
+            std::size_t m_size = 0;
+
+            std::size_t mask() const noexcept {
+                return m_table.size() - 1;
+            }
+
+            void grow() {
+                std::vector<entry> old_table{std::move(m_table)};
+                m_table = std::vector<entry>(old_table.empty() ? 16 : old_table.size() * 2);
+                for (auto& e : old_table) {
+                    if (e.value != not_found) {
+                        auto pos = static_cast<std::size_t>(e.hash) & mask();
+                        while (m_table[pos].value != not_found) {
+                            pos = (pos + 1) & mask();
+                        }
+                        m_table[pos] = std::move(e);
+                    }
+                }
+            }
+
+        public:
+
+            enum : std::size_t {
+                not_found = std::numeric_limits<std::size_t>::max()
+            };
+
+            static constexpr uint64_t hash_start() noexcept {
+                return 14695981039346656037ULL;
+            }
+
+            static uint64_t hash_add(uint64_t hash, char c) noexcept {
+                return (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+            }
+
+            static uint64_t hash(const std::string& str) noexcept {
+                uint64_t hash = hash_start();
+                for (const char c : str) {
+                    hash = hash_add(hash, c);
+                }
+                return hash;
+            }
+
+            bool empty() const noexcept {
+                return m_size == 0;
+            }
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Get a reference to the value stored for the string. If there
+             * is no such string in the index yet, it is added with the
+             * value not_found which must be changed by the caller.
+             */
+            std::size_t& operator[](const std::string& str) {
+                if (2 * (m_size + 1) > m_table.size()) {
+                    grow();
+                }
+
+                const auto h = hash(str);
+                auto pos = static_cast<std::size_t>(h) & mask();
+                while (m_table[pos].value != not_found) {
+                    if (m_table[pos].hash == h && m_table[pos].str == str) {
+                        return m_table[pos].value;
+                    }
+                    pos = (pos + 1) & mask();
+                }
+
+                ++m_size;
+                m_table[pos].str = str;
+                m_table[pos].hash = h;
+                return m_table[pos].value;
+            }
+
+            /**
+             * Find the value for the string str1 or, if str2 is not
+             * nullptr, for str1 and str2 joined by a 0 byte.
+             *
+             * @param hash The hash of the whole string.
+             * @returns The value or not_found.
+             */
+            std::size_t find(const char* str1, std::size_t len1, const char* str2, std::size_t len2, uint64_t hash) const noexcept {
+                if (m_table.empty()) {
+                    return not_found;
+                }
+
+                const std::size_t len = str2 ? len1 + 1 + len2 : len1;
+                auto pos = static_cast<std::size_t>(hash) & mask();
+                while (m_table[pos].value != not_found) {
+                    const auto& e = m_table[pos];
+                    if (e.hash == hash && e.str.size() == len &&
+                        !std::memcmp(e.str.data(), str1, len1) &&
+                        (!str2 || !std::memcmp(e.str.data() + len1 + 1, str2, len2))) {
+                        return e.value;
+                    }
+                    pos = (pos + 1) & mask();
+                }
+
+                return not_found;
+            }
+
+        }; // class string_index
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_DETAIL_STRING_INDEX_HPP
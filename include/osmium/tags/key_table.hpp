@@ -0,0 +1,261 @@
+#ifndef OSMIUM_TAGS_KEY_TABLE_HPP
+#define OSMIUM_TAGS_KEY_TABLE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/detail/string_index.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Type for IDs of interned keys in a KeyTable.
+     */
+    using key_id_type = uint32_t;
+
+    enum : key_id_type {
+        /// ID returned for keys not in a KeyTable.
+        unknown_key_id = std::numeric_limits<key_id_type>::max()
+    };
+
+    /**
+     * A table of interned keys. Each key added to the table gets a small
+     * integer ID (counting from 0). Looking up the ID of a key needs one
+     * pass over the key and one hash table probe.
+     *
+     * Use this together with the TagListIndex to look up values of
+     * common keys in a TagList by ID.
+     *
+     * @code
+     * osmium::KeyTable keys{"highway", "name", "building"};
+     * const auto highway = keys.get("highway");
+     * @endcode
+     */
+    class KeyTable {
+
+        detail::string_index m_index;
+        std::vector<std::string> m_keys;
+
+    public:
+
+        KeyTable() = default;
+
+        /**
+         * Create a key table with the specified keys. The keys get IDs
+         * in the order they are given.
+         */
+        KeyTable(std::initializer_list<const char*> keys) {
+            for (const char* key : keys) {
+                add(key);
+            }
+        }
+
+        /**
+         * Add a key to the table if it isn't there already.
+         *
+         * @returns The ID of the key.
+         * @throws std::length_error if the table is full.
+         */
+        key_id_type add(const std::string& key) {
+            auto& id = m_index[key];
+            if (id == detail::string_index::not_found) {
+                if (m_keys.size() >= unknown_key_id) {
+                    throw std::length_error{"too many keys in KeyTable"};
+                }
+                id = m_keys.size();
+                m_keys.push_back(key);
+            }
+            return static_cast<key_id_type>(id);
+        }
+
+        /**
+         * Look up the ID of a key.
+         *
+         * @returns The ID or unknown_key_id if the key isn't in the table.
+         */
+        key_id_type get(const char* key) const noexcept {
+            uint64_t hash = detail::string_index::hash_start();
+            std::size_t length = 0;
+            for (; key[length] != '\0'; ++length) {
+                hash = detail::string_index::hash_add(hash, key[length]);
+            }
+            const auto id = m_index.find(key, length, nullptr, 0, hash);
+            return id == detail::string_index::not_found ? unknown_key_id : static_cast<key_id_type>(id);
+        }
+
+        /**
+         * Look up the ID of a key.
+         *
+         * @returns The ID or unknown_key_id if the key isn't in the table.
+         */
+        key_id_type get(const std::string& key) const noexcept {
+            const auto id = m_index.find(key.data(), key.size(), nullptr, 0, detail::string_index::hash(key));
+            return id == detail::string_index::not_found ? unknown_key_id : static_cast<key_id_type>(id);
+        }
+
+        /**
+         * Get the key with the specified ID.
+         *
+         * @pre @code id < size() @endcode
+         */
+        const char* key(key_id_type id) const noexcept {
+            return m_keys[id].c_str();
+        }
+
+        /**
+         * The number of keys in the table.
+         */
+        std::size_t size() const noexcept {
+            return m_keys.size();
+        }
+
+        bool empty() const noexcept {
+            return m_keys.empty();
+        }
+
+    }; // class KeyTable
+
+    /**
+     * Index of the tags in a TagList by the key IDs from a KeyTable. After
+     * calling update() with a TagList, getting the value for a key ID is
+     * a single array access. Tags with keys not in the key table are
+     * ignored.
+     *
+     * This is useful if several handlers look at the same tags of each
+     * object: Call update() once for each object (for instance in the
+     * first handler) and use the index from all handlers instead of
+     * comparing strings in each call to TagList::get_value_by_key().
+     *
+     * The index stores pointers into the TagList, so the TagList must be
+     * available as long as the index is used.
+     */
+    class TagListIndex {
+
+        const KeyTable* m_key_table;
+        std::vector<const char*> m_values;
+        std::vector<key_id_type> m_used;
+
+    public:
+
+        /**
+         * Create an index using the specified key table. Keys added to
+         * the table later are not used for indexing.
+         */
+        explicit TagListIndex(const KeyTable& key_table) :
+            m_key_table(&key_table),
+            m_values(key_table.size(), nullptr) {
+        }
+
+        /**
+         * Index the tags in the specified TagList. This replaces the
+         * tags from the previous call. If a key appears several times,
+         * the first value is used.
+         *
+         * Complexity: Linear in the number of tags.
+         */
+        void update(const osmium::TagList& tags) {
+            clear();
+            for (const auto& tag : tags) {
+                const auto id = m_key_table->get(tag.key());
+                if (id < m_values.size() && !m_values[id]) {
+                    m_values[id] = tag.value();
+                    m_used.push_back(id);
+                }
+            }
+        }
+
+        /**
+         * Remove all tags from the index.
+         */
+        void clear() noexcept {
+            for (const auto id : m_used) {
+                m_values[id] = nullptr;
+            }
+            m_used.clear();
+        }
+
+        /**
+         * Get the value of the tag with the specified key ID.
+         *
+         * Complexity: Constant.
+         *
+         * @param id The key ID from the KeyTable.
+         * @param default_value Returned if there is no tag with this key.
+         */
+        const char* get_value_by_key(key_id_type id, const char* default_value = nullptr) const noexcept {
+            if (id >= m_values.size() || !m_values[id]) {
+                return default_value;
+            }
+            return m_values[id];
+        }
+
+        /**
+         * Is there a tag with the specified key ID?
+         *
+         * Complexity: Constant.
+         */
+        bool has_key(key_id_type id) const noexcept {
+            return get_value_by_key(id) != nullptr;
+        }
+
+        /**
+         * Is there a tag with the specified key ID and value?
+         *
+         * Complexity: Constant.
+         */
+        bool has_tag(key_id_type id, const char* value) const noexcept {
+            const char* v = get_value_by_key(id);
+            return v && !std::strcmp(v, value);
+        }
+
+        /**
+         * The number of tags in the index.
+         */
+        std::size_t size() const noexcept {
+            return m_used.size();
+        }
+
+    }; // class TagListIndex
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_KEY_TABLE_HPP
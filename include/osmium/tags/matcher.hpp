@@ -90,6 +90,27 @@ namespace osmium {
             m_result(!invert) {
         }
 
+        /**
+         * The StringMatcher used for the key.
+         */
+        const osmium::StringMatcher& key_matcher() const noexcept {
+            return m_key_matcher;
+        }
+
+        /**
+         * The StringMatcher used for the value.
+         */
+        const osmium::StringMatcher& value_matcher() const noexcept {
+            return m_value_matcher;
+        }
+
+        /**
+         * Is the result of the value matcher inverted?
+         */
+        bool inverted() const noexcept {
+            return !m_result;
+        }
+
         /**
          * Match against the specified key and value.
          *
@@ -134,6 +134,21 @@ namespace osmium {
             return m_default_result;
         }
 
+        /**
+         * The default result returned if none of the rules matched.
+         */
+        TResult default_result() const noexcept {
+            return m_default_result;
+        }
+
+        /**
+         * Access the rules of this filter in the order they were added.
+         * Each rule is a pair of the result and the TagMatcher.
+         */
+        const std::vector<std::pair<TResult, TagMatcher>>& rules() const noexcept {
+            return m_rules;
+        }
+
         /**
          * Return the number of rules in this filter.
          *
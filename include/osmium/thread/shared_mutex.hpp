@@ -0,0 +1,167 @@
+#ifndef OSMIUM_THREAD_SHARED_MUTEX_HPP
+#define OSMIUM_THREAD_SHARED_MUTEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A simple readers-writer lock. Any number of threads can hold the
+         * lock in shared mode at the same time, only one thread can hold
+         * it in exclusive mode. Writers waiting for the lock have priority
+         * over new readers, so writers don't starve.
+         *
+         * This has the same interface as std::shared_timed_mutex (without
+         * the timed functions), which is not available in C++11. Use
+         * std::lock_guard or std::unique_lock for exclusive locking and
+         * osmium::thread::shared_lock for shared locking.
+         */
+        class shared_mutex {
+
+            std::mutex m_mutex{};
+            std::condition_variable m_readers_cv{};
+            std::condition_variable m_writers_cv{};
+            int m_readers = 0;
+            int m_waiting_writers = 0;
+            bool m_writer = false;
+
+        public:
+
+            shared_mutex() = default;
+
+            shared_mutex(const shared_mutex&) = delete;
+            shared_mutex& operator=(const shared_mutex&) = delete;
+
+            shared_mutex(shared_mutex&&) = delete;
+            shared_mutex& operator=(shared_mutex&&) = delete;
+
+            ~shared_mutex() = default;
+
+            void lock() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_waiting_writers;
+                m_writers_cv.wait(lock, [this] {
+                    return !m_writer && m_readers == 0;
+                });
+                --m_waiting_writers;
+                m_writer = true;
+            }
+
+            void unlock() {
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    assert(m_writer);
+                    m_writer = false;
+                }
+                m_writers_cv.notify_one();
+                m_readers_cv.notify_all();
+            }
+
+            void lock_shared() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_readers_cv.wait(lock, [this] {
+                    return !m_writer && m_waiting_writers == 0;
+                });
+                ++m_readers;
+            }
+
+            void unlock_shared() {
+                bool last_reader = false;
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    assert(m_readers > 0);
+                    --m_readers;
+                    last_reader = (m_readers == 0);
+                }
+                if (last_reader) {
+                    m_writers_cv.notify_one();
+                }
+            }
+
+        }; // class shared_mutex
+
+        /**
+         * RAII helper holding a lock in shared mode. Works with
+         * osmium::thread::shared_mutex and any other class with
+         * lock_shared() and unlock_shared() functions.
+         */
+        template <typename TMutex>
+        class shared_lock {
+
+            TMutex* m_mutex;
+
+        public:
+
+            explicit shared_lock(TMutex& mutex) :
+                m_mutex(&mutex) {
+                m_mutex->lock_shared();
+            }
+
+            shared_lock(const shared_lock&) = delete;
+            shared_lock& operator=(const shared_lock&) = delete;
+
+            shared_lock(shared_lock&& other) noexcept :
+                m_mutex(other.m_mutex) {
+                other.m_mutex = nullptr;
+            }
+
+            shared_lock& operator=(shared_lock&& other) noexcept {
+                if (this != &other) {
+                    if (m_mutex) {
+                        m_mutex->unlock_shared();
+                    }
+                    m_mutex = other.m_mutex;
+                    other.m_mutex = nullptr;
+                }
+                return *this;
+            }
+
+            ~shared_lock() noexcept {
+                if (m_mutex) {
+                    m_mutex->unlock_shared();
+                }
+            }
+
+        }; // class shared_lock
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SHARED_MUTEX_HPP
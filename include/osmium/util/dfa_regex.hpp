@@ -0,0 +1,787 @@
+#ifndef OSMIUM_UTIL_DFA_REGEX_HPP
+#define OSMIUM_UTIL_DFA_REGEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2019 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        using regex_char_set = std::bitset<256>;
+
+        /**
+         * Node of the syntax tree of a regular expression.
+         */
+        struct regex_node {
+
+            enum class kind {
+                chars,
+                concat,
+                alternate,
+                repeat,
+                begin,
+                end
+            };
+
+            enum {
+                infinite = -1
+            };
+
+            kind type;
+            regex_char_set chars{};
+            std::vector<std::unique_ptr<regex_node>> children{};
+            int min = 0;
+            int max = 0;
+
+            explicit regex_node(kind t) noexcept :
+                type(t) {
+            }
+
+        }; // struct regex_node
+
+        /**
+         * Recursive descent parser for the subset of the ECMAScript regular
+         * expression syntax supported by the DFARegex class.
+         */
+        class regex_parser {
+
+            enum {
+                max_repeat = 1000
+            };
+
+            const std::string& m_pattern;
+            std::size_t m_pos = 0;
+            bool m_icase;
+
+            [[noreturn]] void error(const char* message) const {
+                throw std::invalid_argument{std::string{"invalid regex '"} + m_pattern + "' at position " + std::to_string(m_pos) + ": " + message};
+            }
+
+            bool at_end() const noexcept {
+                return m_pos >= m_pattern.size();
+            }
+
+            char peek() const noexcept {
+                return m_pattern[m_pos];
+            }
+
+            bool accept(char c) noexcept {
+                if (!at_end() && peek() == c) {
+                    ++m_pos;
+                    return true;
+                }
+                return false;
+            }
+
+            static void add_range(regex_char_set& set, unsigned char from, unsigned char to) noexcept {
+                for (unsigned int c = from; c <= to; ++c) {
+                    set.set(c);
+                }
+            }
+
+            static regex_char_set digits() noexcept {
+                regex_char_set set;
+                add_range(set, '0', '9');
+                return set;
+            }
+
+            static regex_char_set word_chars() noexcept {
+                regex_char_set set;
+                add_range(set, '0', '9');
+                add_range(set, 'A', 'Z');
+                add_range(set, 'a', 'z');
+                set.set('_');
+                return set;
+            }
+
+            static regex_char_set space_chars() noexcept {
+                regex_char_set set;
+                for (const char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+                    set.set(static_cast<unsigned char>(c));
+                }
+                return set;
+            }
+
+            static int hex_value(char c) noexcept {
+                if (c >= '0' && c <= '9') {
+                    return c - '0';
+                }
+                if (c >= 'a' && c <= 'f') {
+                    return c - 'a' + 10;
+                }
+                if (c >= 'A' && c <= 'F') {
+                    return c - 'A' + 10;
+                }
+                return -1;
+            }
+
+            // Parse escape sequence after the backslash. Returns true and
+            // sets the set if it is a character class escape, otherwise
+            // sets the single character.
+            bool parse_escape(regex_char_set& set, unsigned char& single) {
+                if (at_end()) {
+                    error("trailing backslash");
+                }
+                const char c = m_pattern[m_pos++];
+                switch (c) {
+                    case 'd': set = fold_case(digits()); return true;
+                    case 'D': set = ~fold_case(digits()); return true;
+                    case 'w': set = fold_case(word_chars()); return true;
+                    case 'W': set = ~fold_case(word_chars()); return true;
+                    case 's': set = fold_case(space_chars()); return true;
+                    case 'S': set = ~fold_case(space_chars()); return true;
+                    case 'n': single = '\n'; return false;
+                    case 'r': single = '\r'; return false;
+                    case 't': single = '\t'; return false;
+                    case 'v': single = '\v'; return false;
+                    case 'f': single = '\f'; return false;
+                    case '0': single = '\0'; return false;
+                    case 'x': {
+                        if (m_pos + 2 > m_pattern.size() || hex_value(m_pattern[m_pos]) < 0 || hex_value(m_pattern[m_pos + 1]) < 0) {
+                            error("invalid hex escape");
+                        }
+                        single = static_cast<unsigned char>(hex_value(m_pattern[m_pos]) * 16 + hex_value(m_pattern[m_pos + 1]));
+                        m_pos += 2;
+                        return false;
+                    }
+                    default:
+                        break;
+                }
+                if ((c >= '1' && c <= '9') || c == 'b' || c == 'B') {
+                    error("back references and word boundaries are not supported");
+                }
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                    error("unknown escape sequence");
+                }
+                single = static_cast<unsigned char>(c);
+                return false;
+            }
+
+            regex_char_set parse_class() {
+                regex_char_set set;
+                const bool negate = accept('^');
+                while (true) {
+                    if (at_end()) {
+                        error("missing ']'");
+                    }
+                    if (accept(']')) {
+                        break;
+                    }
+
+                    unsigned char from = 0;
+                    if (accept('\\')) {
+                        regex_char_set escaped;
+                        if (parse_escape(escaped, from)) {
+                            set |= escaped;
+                            continue;
+                        }
+                    } else {
+                        from = static_cast<unsigned char>(m_pattern[m_pos++]);
+                    }
+
+                    if (m_pos + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_pos + 1] != ']') {
+                        ++m_pos;
+                        unsigned char to = 0;
+                        if (accept('\\')) {
+                            regex_char_set escaped;
+                            if (parse_escape(escaped, to)) {
+                                error("character class escape in range");
+                            }
+                        } else {
+                            to = static_cast<unsigned char>(m_pattern[m_pos++]);
+                        }
+                        if (to < from) {
+                            error("invalid range in character class");
+                        }
+                        add_range(set, from, to);
+                    } else {
+                        set.set(from);
+                    }
+                }
+                // Case folding has to happen before the negation, otherwise
+                // [^a] would match 'a' because it contains 'A'.
+                set = fold_case(set);
+                return negate ? ~set : set;
+            }
+
+            // If ignoring case, add the other case of all ASCII letters in
+            // the set.
+            regex_char_set fold_case(const regex_char_set& set) const {
+                regex_char_set result{set};
+                if (m_icase) {
+                    for (unsigned int c = 'A'; c <= 'Z'; ++c) {
+                        if (set[c] || set[c + ('a' - 'A')]) {
+                            result.set(c);
+                            result.set(c + ('a' - 'A'));
+                        }
+                    }
+                }
+                return result;
+            }
+
+            // The set must already be case folded.
+            static std::unique_ptr<regex_node> make_chars(const regex_char_set& set) {
+                std::unique_ptr<regex_node> node{new regex_node{regex_node::kind::chars}};
+                node->chars = set;
+                return node;
+            }
+
+            std::unique_ptr<regex_node> parse_atom() {
+                const char c = m_pattern[m_pos++];
+                switch (c) {
+                    case '(': {
+                        if (accept('?')) {
+                            if (!accept(':')) {
+                                error("lookahead is not supported");
+                            }
+                        }
+                        auto node = parse_alternate();
+                        if (!accept(')')) {
+                            error("missing ')'");
+                        }
+                        return node;
+                    }
+                    case '[':
+                        return make_chars(parse_class());
+                    case '.': {
+                        regex_char_set set;
+                        set.set();
+                        set.reset('\n');
+                        set.reset('\r');
+                        return make_chars(set);
+                    }
+                    case '^':
+                        return std::unique_ptr<regex_node>{new regex_node{regex_node::kind::begin}};
+                    case '$':
+                        return std::unique_ptr<regex_node>{new regex_node{regex_node::kind::end}};
+                    case '\\': {
+                        regex_char_set set;
+                        unsigned char single = 0;
+                        if (!parse_escape(set, single)) {
+                            set.set(single);
+                            set = fold_case(set);
+                        }
+                        return make_chars(set);
+                    }
+                    case '*':
+                    case '+':
+                    case '?':
+                    case '{':
+                        --m_pos;
+                        error("nothing to repeat");
+                    default:
+                        break;
+                }
+                regex_char_set set;
+                set.set(static_cast<unsigned char>(c));
+                return make_chars(fold_case(set));
+            }
+
+            int parse_number() {
+                if (at_end() || peek() < '0' || peek() > '9') {
+                    error("number expected");
+                }
+                int value = 0;
+                while (!at_end() && peek() >= '0' && peek() <= '9') {
+                    value = value * 10 + (peek() - '0');
+                    if (value > max_repeat) {
+                        error("repeat count too large");
+                    }
+                    ++m_pos;
+                }
+                return value;
+            }
+
+            std::unique_ptr<regex_node> parse_repeat() {
+                auto node = parse_atom();
+                while (!at_end()) {
+                    int min = 0;
+                    int max = regex_node::infinite;
+                    if (accept('*')) {
+                        // min = 0, max = infinite
+                    } else if (accept('+')) {
+                        min = 1;
+                    } else if (accept('?')) {
+                        max = 1;
+                    } else if (accept('{')) {
+                        min = parse_number();
+                        max = min;
+                        if (accept(',')) {
+                            max = (!at_end() && peek() == '}') ? static_cast<int>(regex_node::infinite) : parse_number();
+                        }
+                        if (!accept('}')) {
+                            error("missing '}'");
+                        }
+                        if (max != regex_node::infinite && max < min) {
+                            error("invalid repeat range");
+                        }
+                    } else {
+                        break;
+                    }
+
+                    // Lazy quantifiers match the same strings.
+                    accept('?');
+
+                    std::unique_ptr<regex_node> repeat{new regex_node{regex_node::kind::repeat}};
+                    repeat->min = min;
+                    repeat->max = max;
+                    repeat->children.push_back(std::move(node));
+                    node = std::move(repeat);
+                }
+                return node;
+            }
+
+            std::unique_ptr<regex_node> parse_concat() {
+                std::unique_ptr<regex_node> node{new regex_node{regex_node::kind::concat}};
+                while (!at_end() && peek() != '|' && peek() != ')') {
+                    node->children.push_back(parse_repeat());
+                }
+                return node;
+            }
+
+            std::unique_ptr<regex_node> parse_alternate() {
+                std::unique_ptr<regex_node> node{new regex_node{regex_node::kind::alternate}};
+                node->children.push_back(parse_concat());
+                while (accept('|')) {
+                    node->children.push_back(parse_concat());
+                }
+                return node;
+            }
+
+        public:
+
+            regex_parser(const std::string& pattern, bool icase) noexcept :
+                m_pattern(pattern),
+                m_icase(icase) {
+            }
+
+            std::unique_ptr<regex_node> parse() {
+                auto node = parse_alternate();
+                if (!at_end()) {
+                    error("unmatched ')'");
+                }
+                return node;
+            }
+
+        }; // class regex_parser
+
+        /**
+         * Nondeterministic finite automaton (Thompson construction) built
+         * from the syntax tree of a regular expression.
+         */
+        class regex_nfa {
+
+        public:
+
+            enum class kind {
+                chars,
+                split,
+                begin,
+                end,
+                match
+            };
+
+            struct state {
+                kind type;
+                std::size_t chars; // index into char sets (for chars)
+                std::size_t out;
+                std::size_t out2; // second path (for split)
+            };
+
+            enum : std::size_t {
+                max_states = 100000
+            };
+
+        private:
+
+            std::vector<state> m_states;
+            std::vector<regex_char_set> m_char_sets;
+            std::size_t m_start = 0;
+
+            std::size_t add_state(kind type, std::size_t out, std::size_t out2 = 0, std::size_t chars = 0) {
+                if (m_states.size() >= max_states) {
+                    throw std::invalid_argument{"regex too large"};
+                }
+                m_states.push_back(state{type, chars, out, out2});
+                return m_states.size() - 1;
+            }
+
+            // Build states for node in front of the state next.
+            std::size_t compile(const regex_node& node, std::size_t next) {
+                switch (node.type) {
+                    case regex_node::kind::chars:
+                        m_char_sets.push_back(node.chars);
+                        return add_state(kind::chars, next, 0, m_char_sets.size() - 1);
+                    case regex_node::kind::concat:
+                        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+                            next = compile(**it, next);
+                        }
+                        break;
+                    case regex_node::kind::alternate: {
+                        std::size_t result = compile(*node.children.back(), next);
+                        for (auto it = std::next(node.children.rbegin()); it != node.children.rend(); ++it) {
+                            const auto branch = compile(**it, next);
+                            result = add_state(kind::split, branch, result);
+                        }
+                        return result;
+                    }
+                    case regex_node::kind::repeat: {
+                        const auto& child = *node.children.front();
+                        std::size_t result = next;
+                        if (node.max == regex_node::infinite) {
+                            const auto loop = add_state(kind::split, 0, next);
+                            const auto body = compile(child, loop);
+                            m_states[loop].out = body;
+                            result = loop;
+                        } else {
+                            for (int i = node.min; i < node.max; ++i) {
+                                const auto body = compile(child, result);
+                                result = add_state(kind::split, body, next);
+                            }
+                        }
+                        for (int i = 0; i < node.min; ++i) {
+                            result = compile(child, result);
+                        }
+                        return result;
+                    }
+                    case regex_node::kind::begin:
+                        return add_state(kind::begin, next);
+                    case regex_node::kind::end:
+                        return add_state(kind::end, next);
+                }
+                return next;
+            }
+
+        public:
+
+            explicit regex_nfa(const regex_node& root) {
+                const auto match = add_state(kind::match, 0);
+                m_start = compile(root, match);
+            }
+
+            const std::vector<state>& states() const noexcept {
+                return m_states;
+            }
+
+            const std::vector<regex_char_set>& char_sets() const noexcept {
+                return m_char_sets;
+            }
+
+            std::size_t start() const noexcept {
+                return m_start;
+            }
+
+        }; // class regex_nfa
+
+    } // namespace detail
+
+    /**
+     * Regular expression matcher compiling the expression into a
+     * deterministic finite automaton (DFA). Matching needs one table
+     * lookup per byte of the input and never backtracks, so it is much
+     * faster than std::regex_search(), especially for longer strings.
+     *
+     * Like std::regex_search() it checks whether the expression matches
+     * anywhere in the string. A subset of the ECMAScript syntax is
+     * supported: literal characters, escapes (\\d, \\w, \\s and their
+     * negations, \\n, \\t, \\xHH, ...), ".", character classes ([a-z],
+     * [^...]), groups ((...) and (?:...)), alternatives (|), the
+     * quantifiers *, +, ?, {n}, {n,}, and {n,m} (lazy versions match the
+     * same strings), and the anchors ^ and $ at the beginning and end of
+     * the string. Back references, lookahead, and word boundaries are
+     * not supported. Matching works on bytes, so "." matches one byte of
+     * a multi-byte UTF-8 character.
+     *
+     * The DFA is built completely when the object is constructed, so it
+     * can be used from several threads at the same time. Some
+     * expressions (like ".*a.{20}") lead to a huge number of states; the
+     * constructor throws if more than max_states states are needed.
+     */
+    class DFARegex {
+
+        enum : uint8_t {
+            flag_accept = 1,
+            flag_dead = 2,
+            flag_accept_at_end = 4
+        };
+
+        std::string m_pattern;
+        std::array<uint8_t, 256> m_byte_class{};
+        std::size_t m_num_classes = 0;
+        std::vector<uint32_t> m_transitions;
+        std::vector<uint8_t> m_flags;
+
+        using state_set = std::vector<std::size_t>;
+
+        class closure_builder {
+
+            const detail::regex_nfa& m_nfa;
+            std::vector<bool> m_seen;
+            std::vector<std::size_t> m_stack;
+
+        public:
+
+            explicit closure_builder(const detail::regex_nfa& nfa) :
+                m_nfa(nfa),
+                m_seen(nfa.states().size()) {
+            }
+
+            // Add all states reachable from the seed state without
+            // consuming input to the set. Only chars, end, and match
+            // states are added, the others are just followed.
+            void add(std::size_t seed, bool allow_begin, bool follow_end, state_set& set) {
+                m_stack.push_back(seed);
+                while (!m_stack.empty()) {
+                    const auto pos = m_stack.back();
+                    m_stack.pop_back();
+                    if (m_seen[pos]) {
+                        continue;
+                    }
+                    m_seen[pos] = true;
+                    const auto& state = m_nfa.states()[pos];
+                    switch (state.type) {
+                        case detail::regex_nfa::kind::split:
+                            m_stack.push_back(state.out2);
+                            m_stack.push_back(state.out);
+                            break;
+                        case detail::regex_nfa::kind::begin:
+                            if (allow_begin) {
+                                m_stack.push_back(state.out);
+                            }
+                            break;
+                        case detail::regex_nfa::kind::end:
+                            if (follow_end) {
+                                m_stack.push_back(state.out);
+                            } else {
+                                set.push_back(pos);
+                            }
+                            break;
+                        default:
+                            set.push_back(pos);
+                    }
+                }
+            }
+
+            // Finish a set: reset seen flags and sort.
+            void finish(state_set& set) {
+                std::fill(m_seen.begin(), m_seen.end(), false);
+                std::sort(set.begin(), set.end());
+            }
+
+        }; // class closure_builder
+
+        void build_byte_classes(const detail::regex_nfa& nfa) {
+            // Split byte classes until all bytes in a class are in the
+            // same char sets.
+            m_num_classes = 1;
+            for (const auto& set : nfa.char_sets()) {
+                std::array<int, 512> new_class;
+                new_class.fill(-1);
+                std::size_t count = 0;
+                for (std::size_t c = 0; c < 256; ++c) {
+                    auto& nc = new_class[m_byte_class[c] * 2 + (set[c] ? 1 : 0)];
+                    if (nc < 0) {
+                        nc = static_cast<int>(count++);
+                    }
+                    m_byte_class[c] = static_cast<uint8_t>(nc);
+                }
+                m_num_classes = count;
+            }
+        }
+
+        void build(const detail::regex_nfa& nfa, std::size_t max_states) {
+            build_byte_classes(nfa);
+
+            std::array<unsigned char, 256> representative{};
+            for (std::size_t c = 256; c > 0; --c) {
+                representative[m_byte_class[c - 1]] = static_cast<unsigned char>(c - 1);
+            }
+
+            const auto& states = nfa.states();
+            closure_builder closure{nfa};
+
+            // States re-added at each position, because the expression
+            // can match anywhere.
+            state_set restart;
+            closure.add(nfa.start(), false, false, restart);
+            closure.finish(restart);
+
+            state_set initial;
+            closure.add(nfa.start(), true, false, initial);
+            closure.finish(initial);
+
+            std::map<state_set, uint32_t> ids;
+            std::vector<const state_set*> sets;
+
+            const auto get_id = [&](state_set&& set) -> uint32_t {
+                const auto it = ids.find(set);
+                if (it != ids.end()) {
+                    return it->second;
+                }
+                if (sets.size() >= max_states) {
+                    throw std::invalid_argument{"regex '" + m_pattern + "' needs too many DFA states"};
+                }
+                const auto id = static_cast<uint32_t>(sets.size());
+                sets.push_back(&ids.emplace(std::move(set), id).first->first);
+                return id;
+            };
+
+            get_id(std::move(initial));
+
+            for (std::size_t id = 0; id < sets.size(); ++id) {
+                const state_set& set = *sets[id];
+                uint8_t flags = 0;
+
+                state_set at_end;
+                for (const auto pos : set) {
+                    if (states[pos].type == detail::regex_nfa::kind::match) {
+                        flags |= flag_accept;
+                    } else if (states[pos].type == detail::regex_nfa::kind::end) {
+                        closure.add(states[pos].out, false, true, at_end);
+                    }
+                }
+                closure.finish(at_end);
+                if (std::any_of(at_end.cbegin(), at_end.cend(), [&](std::size_t pos) {
+                    return states[pos].type == detail::regex_nfa::kind::match;
+                })) {
+                    flags |= flag_accept_at_end;
+                }
+                if (set.empty()) {
+                    flags |= flag_dead;
+                }
+                m_flags.push_back(flags);
+
+                const auto base = m_transitions.size();
+                m_transitions.resize(base + m_num_classes, static_cast<uint32_t>(id));
+                if (flags & (flag_accept | flag_dead)) {
+                    continue;
+                }
+
+                for (std::size_t cls = 0; cls < m_num_classes; ++cls) {
+                    state_set next;
+                    for (const auto pos : set) {
+                        const auto& state = states[pos];
+                        if (state.type == detail::regex_nfa::kind::chars && nfa.char_sets()[state.chars][representative[cls]]) {
+                            closure.add(state.out, false, false, next);
+                        }
+                    }
+                    for (const auto pos : restart) {
+                        closure.add(pos, false, false, next);
+                    }
+                    closure.finish(next);
+                    m_transitions[base + cls] = get_id(std::move(next));
+                }
+            }
+        }
+
+    public:
+
+        enum : std::size_t {
+            /// Default for the maximum number of states in the DFA.
+            default_max_states = 10000
+        };
+
+        /**
+         * Compile a regular expression.
+         *
+         * @param pattern The regular expression.
+         * @param icase Ignore case of ASCII letters when matching.
+         * @param max_states Maximum number of DFA states.
+         * @throws std::invalid_argument if the pattern is invalid, uses
+         *         unsupported features, or needs too many states.
+         */
+        explicit DFARegex(std::string pattern, bool icase = false, std::size_t max_states = default_max_states) :
+            m_pattern(std::move(pattern)) {
+            const auto root = detail::regex_parser{m_pattern, icase}.parse();
+            const detail::regex_nfa nfa{*root};
+            build(nfa, max_states);
+        }
+
+        /**
+         * Does the regular expression match anywhere in the string?
+         *
+         * Complexity: Linear in the length of the string.
+         */
+        bool search(const char* str) const noexcept {
+            uint32_t state = 0;
+            if (m_flags[state] & flag_accept) {
+                return true;
+            }
+            if (m_flags[state] & flag_dead) {
+                return false;
+            }
+            for (; *str != '\0'; ++str) {
+                state = m_transitions[state * m_num_classes + m_byte_class[static_cast<unsigned char>(*str)]];
+                const auto flags = m_flags[state];
+                if (flags & flag_accept) {
+                    return true;
+                }
+                if (flags & flag_dead) {
+                    return false;
+                }
+            }
+            return (m_flags[state] & flag_accept_at_end) != 0;
+        }
+
+        /**
+         * The regular expression this DFA was built from.
+         */
+        const std::string& pattern() const noexcept {
+            return m_pattern;
+        }
+
+        /**
+         * The number of states in the DFA.
+         */
+        std::size_t num_states() const noexcept {
+            return m_flags.size();
+        }
+
+    }; // class DFARegex
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_DFA_REGEX_HPP
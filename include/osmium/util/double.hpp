@@ -35,18 +35,97 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <iterator>
 #include <string>
 
 namespace osmium {
 
+    namespace detail {
+
+        // Calculate the exact product a * b as the sum hi + lo.
+        inline void two_product(double a, double b, double& hi, double& lo) noexcept {
+            hi = a * b;
+#ifdef FP_FAST_FMA
+            lo = std::fma(a, b, -hi);
+#else
+            // Dekker's algorithm
+            constexpr const double split = 134217729.0; // 2^27 + 1
+            const double ca = split * a;
+            const double ah = ca - (ca - a);
+            const double al = a - ah;
+            const double cb = split * b;
+            const double bh = cb - (cb - b);
+            const double bl = b - bh;
+            lo = ((ah * bh - hi) + ah * bl + al * bh) + al * bl;
+#endif
+        }
+
+        /**
+         * Round value * 10^precision to the nearest integer (ties to even)
+         * based on the exact product, so the result is the same as the
+         * one from printf("%.*f"). Returns false if the value is too
+         * large, infinite, or NaN.
+         *
+         * @pre value >= 0 && precision >= 0 && precision <= 17
+         */
+        inline bool scale_and_round(double value, int precision, uint64_t& result) noexcept {
+            static const double powers_of_ten[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+            };
+
+            double hi;
+            double lo;
+            two_product(value, powers_of_ten[precision], hi, lo);
+            if (!(hi < 4503599627370496.0)) { // 2^52
+                return false;
+            }
+
+            const double q = std::nearbyint(hi);
+            const double d = hi - q; // exact
+            result = static_cast<uint64_t>(q);
+
+            // The exact fractional part is d + lo. Correct the result if
+            // that is beyond +/-0.5 or exactly on it and the result is odd.
+            const bool odd = (result & 1U) != 0;
+            const double above = (d - 0.5) + lo;
+            const double below = (d + 0.5) + lo;
+            if (above > 0.0 || (!(above < 0.0) && odd)) {
+                ++result;
+            } else if (below < 0.0 || (!(below > 0.0) && odd)) {
+                --result;
+            }
+
+            return true;
+        }
+
+        template <typename T>
+        inline T append_uint64(T iterator, uint64_t value, int min_digits) {
+            char buffer[20];
+            char* p = buffer;
+            do {
+                *p++ = static_cast<char>('0' + value % 10);
+                value /= 10;
+                --min_digits;
+            } while (value != 0 || min_digits > 0);
+            return std::reverse_copy(buffer, p, iterator);
+        }
+
+    } // namespace detail
+
     inline namespace util {
 
         /**
          * Write double to iterator, removing superfluous '0' characters at
          * the end. The decimal dot will also be removed if necessary.
          *
+         * The result is the same as printing with printf("%.*f") and
+         * removing the zeros, but for the usual values this doesn't call
+         * printf() and is much faster.
+         *
          * @tparam T iterator type
          * @param iterator output iterator
          * @param value the value that should be written
@@ -56,6 +135,34 @@ namespace osmium {
         inline T double2string(T iterator, double value, int precision) {
             assert(precision <= 17);
 
+            uint64_t scaled = 0;
+            if (precision >= 0 && detail::scale_and_round(std::abs(value), precision, scaled)) {
+                static const uint64_t powers_of_ten[] = {
+                    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+                    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL
+                };
+
+                if (std::signbit(value)) {
+                    *iterator++ = '-';
+                }
+
+                iterator = detail::append_uint64(iterator, scaled / powers_of_ten[precision], 1);
+
+                uint64_t fraction = scaled % powers_of_ten[precision];
+                if (fraction != 0) {
+                    int digits = precision;
+                    while (fraction % 10 == 0) {
+                        fraction /= 10;
+                        --digits;
+                    }
+                    *iterator++ = '.';
+                    iterator = detail::append_uint64(iterator, fraction, digits);
+                }
+
+                return iterator;
+            }
+
             enum {
                 max_double_length = 20 // should fit decimal representation of any double
             };
@@ -69,11 +176,16 @@ namespace osmium {
 #endif
             assert(len > 0 && len < max_double_length);
 
-            while (buffer[len - 1] == '0') {
-                --len;
-            }
-            if (buffer[len - 1] == '.') {
-                --len;
+            // Only remove zeros after the decimal point. (There is none
+            // for precision 0, but a negative precision means the default
+            // of 6 digits.)
+            if (std::find(buffer, buffer + len, '.') != buffer + len) {
+                while (buffer[len - 1] == '0') {
+                    --len;
+                }
+                if (buffer[len - 1] == '.') {
+                    --len;
+                }
             }
 
             return std::copy_n(buffer, len, iterator);
@@ -44,6 +44,10 @@ DEALINGS IN THE SOFTWARE.
 
 #ifndef _WIN32
 # include <sys/mman.h>
+# include <unistd.h>
+# ifdef __linux__
+#  include <sys/syscall.h>
+# endif
 #else
 # include <fcntl.h>
 # include <io.h>
@@ -55,6 +59,35 @@ namespace osmium {
 
     inline namespace util {
 
+        /**
+         * Options for anonymous memory mappings. These are hints to the
+         * operating system which can make access to large mappings faster.
+         * They are silently ignored on systems that don't support them.
+         * Currently they are only implemented on Linux.
+         */
+        struct anonymous_mapping_options {
+
+            /**
+             * Ask for transparent huge pages (madvise(MADV_HUGEPAGE)). This
+             * reduces TLB misses for large, randomly accessed mappings.
+             */
+            bool huge_pages = false;
+
+            /**
+             * Populate (prefault) the mapping when it is created or grows
+             * (MAP_POPULATE).
+             */
+            bool populate = false;
+
+            /**
+             * Interleave the pages of the mapping over all NUMA nodes
+             * (mbind(MPOL_INTERLEAVE)) instead of allocating them on the
+             * node of the thread touching them first.
+             */
+            bool numa_interleave = false;
+
+        }; // struct anonymous_mapping_options
+
         /**
          * Class for wrapping memory mapping system calls.
          *
@@ -116,6 +149,9 @@ namespace osmium {
             /// Mapping mode
             mapping_mode m_mapping_mode;
 
+            /// Options for anonymous mappings
+            anonymous_mapping_options m_options;
+
 #ifdef _WIN32
             HANDLE m_handle;
 #endif
@@ -137,6 +173,8 @@ namespace osmium {
 
             flag_type get_flags() const noexcept;
 
+            void apply_options(std::size_t from) noexcept;
+
             static std::size_t check_size(std::size_t size) {
                 if (size == 0) {
                     return osmium::get_pagesize();
@@ -183,6 +221,16 @@ namespace osmium {
              */
             MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0);
 
+            /**
+             * Create anonymous (writable, private) memory mapping of given
+             * size with the given options.
+             *
+             * @param size Size of the mapping in bytes
+             * @param options Options for the mapping
+             * @throws std::system_error if the mapping fails
+             */
+            MemoryMapping(std::size_t size, const anonymous_mapping_options& options);
+
             /**
              * @deprecated
              * For backwards compatibility only. Use the constructor taking
@@ -305,6 +353,10 @@ namespace osmium {
                 MemoryMapping(size, mapping_mode::write_private) {
             }
 
+            AnonymousMemoryMapping(std::size_t size, const anonymous_mapping_options& options) :
+                MemoryMapping(size, options) {
+            }
+
 #ifndef __linux__
             /**
              * On systems other than Linux anonymous mappings can not be
@@ -341,6 +393,18 @@ namespace osmium {
                 m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private) {
             }
 
+            /**
+             * Create anonymous typed memory mapping of given size with the
+             * given options.
+             *
+             * @param size Number of objects of type T to be mapped
+             * @param options Options for the mapping
+             * @throws std::system_error if the mapping fails
+             */
+            TypedMemoryMapping(std::size_t size, const anonymous_mapping_options& options) :
+                m_mapping(sizeof(T) * size, options) {
+            }
+
             /**
              * Create file-backed memory mapping of given size. The file must
              * contain at least `sizeof(T) * size` bytes!
@@ -513,6 +577,10 @@ namespace osmium {
                 TypedMemoryMapping<T>(size) {
             }
 
+            AnonymousTypedMemoryMapping(std::size_t size, const anonymous_mapping_options& options) :
+                TypedMemoryMapping<T>(size, options) {
+            }
+
 #ifndef __linux__
             /**
              * On systems other than Linux anonymous mappings can not be
@@ -559,6 +627,13 @@ inline int osmium::util::MemoryMapping::get_protection() const noexcept {
 
 inline int osmium::util::MemoryMapping::get_flags() const noexcept {
     if (m_fd == -1) {
+#ifdef MAP_POPULATE
+        // If other options are set, they have to be applied before the
+        // pages are touched, so populating is done in apply_options().
+        if (m_options.populate && !m_options.huge_pages && !m_options.numa_interleave) {
+            return MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE; // NOLINT(hicpp-signed-bitwise)
+        }
+#endif
         return MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
     }
     if (m_mapping_mode == mapping_mode::write_shared) {
@@ -579,11 +654,68 @@ inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode
     }
 }
 
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, const anonymous_mapping_options& options) :
+    m_size(check_size(size)),
+    m_offset(0),
+    m_fd(-1),
+    m_mapping_mode(mapping_mode::write_private),
+    m_options(options),
+    m_addr(::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset)) {
+    if (!is_valid()) {
+        throw std::system_error{errno, std::system_category(), "mmap failed"};
+    }
+    apply_options(0);
+}
+
+inline void osmium::util::MemoryMapping::apply_options(std::size_t from) noexcept {
+#ifdef __linux__
+    if (m_fd != -1 || !is_valid()) {
+        return;
+    }
+
+# ifdef MADV_HUGEPAGE
+    if (m_options.huge_pages) {
+        ::madvise(m_addr, m_size, MADV_HUGEPAGE);
+    }
+# endif
+
+# ifdef SYS_mbind
+    if (m_options.numa_interleave) {
+        // Same value as MPOL_INTERLEAVE in <linux/mempolicy.h>. Nodes that
+        // are not available are ignored by the kernel.
+        enum { mpol_interleave = 3 };
+        const unsigned long nodemask = ~0ul; // NOLINT(google-runtime-int)
+        ::syscall(SYS_mbind, m_addr, m_size, mpol_interleave, &nodemask, sizeof(nodemask) * 8, 0);
+    }
+# endif
+
+    const bool populated_by_mmap = from == 0 && !m_options.huge_pages && !m_options.numa_interleave;
+    if (m_options.populate && !populated_by_mmap && from < m_size) {
+        char* begin = get_addr<char>() + from;
+# ifdef MADV_POPULATE_WRITE
+        if (::madvise(begin, m_size - from, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+# endif
+        // Touch every page. The read and write of the same value keeps
+        // any data that might already be there.
+        const std::size_t pagesize = osmium::get_pagesize();
+        volatile char* const start = begin;
+        for (std::size_t offset = 0; offset < m_size - from; offset += pagesize) {
+            start[offset] = start[offset];
+        }
+    }
+#else
+    (void)from;
+#endif
+}
+
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_size(other.m_size),
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_addr(other.m_addr) {
     other.make_invalid();
 }
@@ -599,6 +731,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_addr         = other.m_addr;
     other.make_invalid();
     return *this;
@@ -621,7 +754,9 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mremap failed"};
         }
+        const std::size_t old_size = m_size;
         m_size = new_size;
+        apply_options(old_size);
 #else
         assert(false && "can't resize anonymous mappings on non-linux systems");
 #endif
@@ -747,11 +882,20 @@ inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMappin
     }
 }
 
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, const anonymous_mapping_options& options) :
+    MemoryMapping(size, mapping_mode::write_private) {
+    m_options = options;
+}
+
+inline void osmium::util::MemoryMapping::apply_options(std::size_t /*from*/) noexcept {
+}
+
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_size(other.m_size),
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_handle(std::move(other.m_handle)),
     m_addr(other.m_addr) {
     other.make_invalid();
@@ -764,6 +908,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_handle       = std::move(other.m_handle);
     m_addr         = other.m_addr;
     other.make_invalid();
@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/dfa_regex.hpp>
+
 #include <boost/variant.hpp>
 
 #include <cstring>
@@ -131,6 +133,10 @@ namespace osmium {
                 m_str(str) {
             }
 
+            const std::string& str() const noexcept {
+                return m_str;
+            }
+
             bool match(const char* test_string) const noexcept {
                 return !std::strcmp(m_str.c_str(), test_string);
             }
@@ -159,8 +165,12 @@ namespace osmium {
                 m_str(str) {
             }
 
+            const std::string& str() const noexcept {
+                return m_str;
+            }
+
             bool match(const char* test_string) const noexcept {
-                return m_str.compare(0, std::string::npos, test_string, 0, m_str.size()) == 0;
+                return std::strncmp(test_string, m_str.c_str(), m_str.size()) == 0;
             }
 
             template <typename TChar, typename TTraits>
@@ -187,6 +197,10 @@ namespace osmium {
                 m_str(str) {
             }
 
+            const std::string& str() const noexcept {
+                return m_str;
+            }
+
             bool match(const char* test_string) const noexcept {
                 return std::strstr(test_string, m_str.c_str()) != nullptr;
             }
@@ -224,6 +238,36 @@ namespace osmium {
         }; // class regex
 #endif
 
+        /**
+         * Matches if the test string matches the regular expression.
+         * Uses the DFARegex class which is much faster than std::regex,
+         * but only supports a subset of the regular expression syntax.
+         */
+        class dfa_regex : public matcher {
+
+            osmium::DFARegex m_regex;
+
+        public:
+
+            explicit dfa_regex(std::string pattern, bool icase = false) :
+                m_regex(std::move(pattern), icase) {
+            }
+
+            const std::string& str() const noexcept {
+                return m_regex.pattern();
+            }
+
+            bool match(const char* test_string) const noexcept {
+                return m_regex.search(test_string);
+            }
+
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                out << "dfa_regex[" << m_regex.pattern() << ']';
+            }
+
+        }; // class dfa_regex
+
         /**
          * Matches if the test string is equal to any of the stored strings.
          */
@@ -239,6 +283,10 @@ namespace osmium {
                 m_strings(std::move(strings)) {
             }
 
+            const std::vector<std::string>& strings() const noexcept {
+                return m_strings;
+            }
+
             list& add_string(const char* str) {
                 m_strings.emplace_back(str);
                 return *this;
@@ -280,6 +328,7 @@ namespace osmium {
 #ifdef OSMIUM_WITH_REGEX
                                             regex,
 #endif
+                                            dfa_regex,
                                             list>;
 
         matcher_type m_matcher;
@@ -387,7 +436,8 @@ namespace osmium {
          *
          * @tparam TMatcher Must be one of the matcher classes
          *                  osmium::StringMatcher::always_false, always_true,
-         *                  equal, prefix, substring, regex or list.
+         *                  equal, prefix, substring, regex, dfa_regex or
+         *                  list.
          */
         template <typename TMatcher, typename X = typename std::enable_if<
             std::is_base_of<matcher, TMatcher>::value, void>::type>
@@ -395,6 +445,21 @@ namespace osmium {
             m_matcher(std::forward<TMatcher>(matcher)) {
         }
 
+        /**
+         * Get the matcher of the specified type.
+         *
+         * @tparam TMatcher One of the matcher classes
+         *                  osmium::StringMatcher::always_false, always_true,
+         *                  equal, prefix, substring, regex, dfa_regex or
+         *                  list.
+         * @returns Pointer to the matcher or nullptr if this string matcher
+         *          is of a different type.
+         */
+        template <typename TMatcher>
+        const TMatcher* get() const noexcept {
+            return boost::get<TMatcher>(&m_matcher);
+        }
+
         /**
          * Match the specified string.
          */
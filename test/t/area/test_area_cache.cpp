@@ -0,0 +1,264 @@
+#include "catch.hpp"
+
+#include <osmium/area/area_cache.hpp>
+#include <osmium/area/area_dependencies.hpp>
+#include <osmium/area/assembler.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+
+#include <unistd.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, double x, double size) {
+        const osmium::object_id_type n = id * 10;
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _tag("building", "yes"),
+            _nodes({
+                {n + 1, {x,        1.0}},
+                {n + 2, {x,        1.0 + size}},
+                {n + 3, {x + size, 1.0 + size}},
+                {n + 4, {x + size, 1.0}},
+                {n + 1, {x,        1.0}}
+            })
+        );
+    }
+
+    osmium::memory::Buffer assemble_squares(osmium::object_id_type first, osmium::object_id_type last, double size) {
+        osmium::memory::Buffer ways{1024 * 64};
+        for (osmium::object_id_type id = first; id <= last; ++id) {
+            add_square(ways, id, static_cast<double>(id), size);
+        }
+
+        const osmium::area::Assembler::config_type config;
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer areas{1024 * 64};
+        for (const auto& way : ways.select<osmium::Way>()) {
+            REQUIRE(assembler(way, areas));
+        }
+        return areas;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Area cache add, replace, remove") {
+    osmium::area::AreaCache cache;
+    REQUIRE(cache.empty());
+
+    cache.add_buffer(assemble_squares(1, 10, 0.5));
+    REQUIRE(cache.size() == 10);
+
+    const auto* area = cache.get(14);
+    REQUIRE(area);
+    REQUIRE(area->orig_id() == 7);
+    REQUIRE(cache.get(15) == nullptr);
+
+    // replace areas 2 to 4 with bigger ones
+    cache.add_buffer(assemble_squares(2, 4, 0.75));
+    REQUIRE(cache.size() == 10);
+    const auto envelope = cache.get(6)->envelope();
+    REQUIRE(envelope.top_right().lat() == Approx(1.75));
+
+    REQUIRE(cache.remove(6));
+    REQUIRE_FALSE(cache.remove(6));
+    REQUIRE(cache.size() == 9);
+    REQUIRE(cache.get(6) == nullptr);
+
+    cache.compact();
+    int count = 0;
+    cache.for_each([&count](const osmium::Area& a) {
+        REQUIRE(a.id() != 6);
+        ++count;
+    });
+    REQUIRE(count == 9);
+    REQUIRE(cache.get(8)->envelope().top_right().lat() == Approx(1.75));
+    REQUIRE(cache.get(10)->envelope().top_right().lat() == Approx(1.5));
+}
+
+TEST_CASE("Area cache dump and load") {
+    osmium::area::AreaCache cache;
+    cache.add_buffer(assemble_squares(1, 100, 0.5));
+    cache.remove(20);
+
+    const int fd = osmium::detail::create_tmp_file();
+    cache.dump(fd);
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+
+    const osmium::area::AreaCache loaded{fd};
+    REQUIRE(loaded.size() == 99);
+    REQUIRE(loaded.get(20) == nullptr);
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        if (id != 10) {
+            const auto* area = loaded.get(id * 2);
+            REQUIRE(area);
+            REQUIRE(*area == *cache.get(id * 2));
+        }
+    }
+
+    // reading the truncated file fails
+    REQUIRE(::ftruncate(fd, 100) == 0);
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+    REQUIRE_THROWS_AS(osmium::area::AreaCache{fd}, const std::runtime_error&);
+
+    ::close(fd);
+}
+
+TEST_CASE("Area dependencies") {
+    osmium::memory::Buffer input{1024 * 64};
+    osmium::builder::add_way(input, _id(1), _nodes({1, 2, 3, 1}));
+    osmium::builder::add_way(input, _id(2), _nodes({3, 4, 5}));
+    osmium::builder::add_way(input, _id(3), _nodes({5, 6, 7}));
+    osmium::builder::add_relation(input, _id(10),
+        _member(osmium::item_type::way, 2, "outer"),
+        _member(osmium::item_type::way, 3, "outer"));
+    osmium::builder::add_relation(input, _id(11),
+        _member(osmium::item_type::way, 3, "outer"),
+        _member(osmium::item_type::node, 1, ""));
+
+    osmium::area::AreaDependencies deps;
+    for (const auto& way : input.select<osmium::Way>()) {
+        deps.add_way(way);
+    }
+    for (const auto& relation : input.select<osmium::Relation>()) {
+        deps.add_relation(relation);
+    }
+    deps.sort();
+    REQUIRE(deps.size() == 12);
+
+    osmium::memory::Buffer changes{1024 * 64};
+
+    SECTION("changed node in one way") {
+        osmium::builder::add_node(changes, _id(2));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>{2});
+    }
+
+    SECTION("changed node in several ways and relations") {
+        osmium::builder::add_node(changes, _id(5));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>({4, 6, 21, 23}));
+    }
+
+    SECTION("changed relation") {
+        osmium::builder::add_relation(changes, _id(11));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>{23});
+    }
+
+    SECTION("apply changes") {
+        // way 3 doesn't contain node 5 any more, way 2 is deleted
+        osmium::builder::add_way(changes, _id(3), _nodes({6, 7, 8}));
+        osmium::builder::add_way(changes, _id(2), _visible(false));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>({4, 6, 21, 23}));
+
+        // way 3 is added again, because it is a member of relations
+        // in the index, even though the filter doesn't want it
+        const auto missing = deps.apply_changes(changes, [](const osmium::OSMObject& /*object*/) {
+            return false;
+        });
+        REQUIRE(missing.empty());
+
+        osmium::memory::Buffer more_changes{1024 * 64};
+        osmium::builder::add_node(more_changes, _id(5));
+        REQUIRE(deps.affected_areas(more_changes).empty());
+
+        osmium::builder::add_node(more_changes, _id(8));
+        REQUIRE(deps.affected_areas(more_changes) == std::vector<osmium::object_id_type>({6, 21, 23}));
+
+        const int fd = osmium::detail::create_tmp_file();
+        deps.dump(fd);
+        REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+        const osmium::area::AreaDependencies loaded{fd};
+        ::close(fd);
+
+        REQUIRE(loaded.size() == deps.size());
+        REQUIRE(loaded.affected_areas(more_changes) == std::vector<osmium::object_id_type>({6, 21, 23}));
+    }
+
+    SECTION("relation gets existing way not in index") {
+        osmium::builder::add_relation(changes, _id(10),
+            _member(osmium::item_type::way, 2, "outer"),
+            _member(osmium::item_type::way, 3, "outer"),
+            _member(osmium::item_type::way, 9, "inner"));
+
+        const auto missing = deps.apply_changes(changes, [](const osmium::OSMObject& object) {
+            return object.type() == osmium::item_type::relation;
+        });
+        REQUIRE(missing == std::vector<osmium::object_id_type>{9});
+
+        osmium::memory::Buffer more_changes{1024 * 64};
+        osmium::builder::add_node(more_changes, _id(31));
+        REQUIRE(deps.affected_areas(more_changes).empty());
+
+        // the way from the database
+        osmium::memory::Buffer ways{1024};
+        osmium::builder::add_way(ways, _id(9), _nodes({30, 31, 32, 30}));
+        deps.add_way(ways.get<osmium::Way>(0));
+        deps.sort();
+
+        REQUIRE(deps.affected_areas(more_changes) == std::vector<osmium::object_id_type>({18, 21}));
+    }
+
+    SECTION("filter rejects objects that can't become areas") {
+        osmium::builder::add_way(changes, _id(50), _nodes({40, 41}), _tag("highway", "primary"));
+        osmium::builder::add_relation(changes, _id(60),
+            _member(osmium::item_type::way, 50, ""),
+            _member(osmium::item_type::way, 51, ""),
+            _tag("type", "route"));
+
+        const auto missing = deps.apply_changes(changes, [](const osmium::OSMObject& object) {
+            if (object.type() == osmium::item_type::way) {
+                return static_cast<const osmium::Way&>(object).is_closed();
+            }
+            return object.tags().has_tag("type", "multipolygon");
+        });
+        REQUIRE(missing.empty());
+        REQUIRE(deps.size() == 12);
+
+        osmium::memory::Buffer more_changes{1024 * 64};
+        osmium::builder::add_node(more_changes, _id(40));
+        REQUIRE(deps.affected_areas(more_changes).empty());
+    }
+}
+
+TEST_CASE("Area dependencies with negative IDs") {
+    osmium::memory::Buffer input{1024 * 64};
+    osmium::builder::add_way(input, _id(5), _nodes({1, 2, 3, 1}));
+    osmium::builder::add_way(input, _id(-5), _nodes({-1, -2, -3, -1}));
+
+    osmium::area::AreaDependencies deps;
+    for (const auto& way : input.select<osmium::Way>()) {
+        deps.add_way(way);
+    }
+    deps.sort();
+
+    osmium::memory::Buffer changes{1024 * 64};
+
+    SECTION("positive node") {
+        osmium::builder::add_node(changes, _id(2));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>{10});
+    }
+
+    SECTION("negative node") {
+        osmium::builder::add_node(changes, _id(-2));
+        REQUIRE(deps.affected_areas(changes) == std::vector<osmium::object_id_type>{-10});
+    }
+
+    SECTION("deleting negative way keeps positive way") {
+        osmium::builder::add_way(changes, _id(-5), _visible(false));
+        deps.apply_changes(changes, [](const osmium::OSMObject& /*object*/) {
+            return true;
+        });
+        REQUIRE(deps.size() == 3);
+
+        osmium::memory::Buffer more_changes{1024 * 64};
+        osmium::builder::add_node(more_changes, _id(-2));
+        osmium::builder::add_node(more_changes, _id(2));
+        REQUIRE(deps.affected_areas(more_changes) == std::vector<osmium::object_id_type>{10});
+    }
+}
@@ -5,6 +5,10 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 
+#include <cstring>
+#include <iterator>
+#include <vector>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Build area from way") {
@@ -141,3 +145,111 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+namespace {
+
+    // Multipolygon with a 10x10 grid of inner rings and an island in the
+    // inner rings on the diagonal.
+    std::size_t add_many_rings_relation(osmium::memory::Buffer& buffer, std::vector<const osmium::Way*>& ways) {
+        std::vector<std::size_t> positions;
+        std::vector<member_type> members;
+        osmium::object_id_type way_id = 1;
+        osmium::object_id_type node_id = 1;
+
+        const auto add_square = [&](int32_t x, int32_t y, int32_t size, const char* role) {
+            const osmium::object_id_type first = node_id;
+            positions.push_back(osmium::builder::add_way(buffer,
+                _id(way_id),
+                _nodes({
+                    {node_id++, osmium::Location{x,        y}},
+                    {node_id++, osmium::Location{x,        y + size}},
+                    {node_id++, osmium::Location{x + size, y + size}},
+                    {node_id++, osmium::Location{x + size, y}},
+                    {first,     osmium::Location{x,        y}}
+                })
+            ));
+            members.emplace_back(osmium::item_type::way, way_id++, role);
+        };
+
+        add_square(0, 0, 11000, "outer");
+        for (int32_t i = 0; i < 10; ++i) {
+            for (int32_t j = 0; j < 10; ++j) {
+                add_square(1000 + i * 1000 + j * 3, 1000 + j * 1000 + i * 7, 600, "inner");
+                if (i == j) {
+                    add_square(1100 + i * 1000 + j * 3, 1100 + j * 1000 + i * 7, 300, "outer");
+                }
+            }
+        }
+
+        const auto rpos = osmium::builder::add_relation(buffer,
+            _id(1),
+            _members(members),
+            _tag("type", "multipolygon"),
+            _tag("landuse", "forest")
+        );
+
+        for (const auto pos : positions) {
+            ways.push_back(&buffer.get<osmium::Way>(pos));
+        }
+
+        return rpos;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Build area from relation with many inner rings and islands") {
+    osmium::memory::Buffer buffer{1024 * 1024};
+    std::vector<const osmium::Way*> ways;
+    const auto rpos = add_many_rings_relation(buffer, ways);
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240};
+    REQUIRE(assembler(buffer.get<osmium::Relation>(rpos), ways, area_buffer));
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.outer_rings == 11);
+    REQUIRE(s.inner_rings == 100);
+
+    const auto& area = area_buffer.get<osmium::Area>(0);
+    const auto outer_rings = area.outer_rings();
+    REQUIRE(std::distance(outer_rings.begin(), outer_rings.end()) == 11);
+    REQUIRE(std::distance(area.inner_rings(*outer_rings.begin()).begin(), area.inner_rings(*outer_rings.begin()).end()) == 100);
+    for (auto it = std::next(outer_rings.begin()); it != outer_rings.end(); ++it) {
+        REQUIRE(area.inner_rings(*it).begin() == area.inner_rings(*it).end());
+    }
+}
+
+TEST_CASE("Reuse assembler for several objects") {
+    osmium::memory::Buffer buffer{1024 * 1024};
+    std::vector<const osmium::Way*> ways;
+    const auto rpos = add_many_rings_relation(buffer, ways);
+    const auto& relation = buffer.get<osmium::Relation>(rpos);
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer1{10240};
+    REQUIRE(assembler(relation, ways, area_buffer1));
+    const auto stats1 = assembler.stats();
+
+    REQUIRE(assembler(*ways.front(), area_buffer1));
+    REQUIRE(assembler.stats().from_ways == 1);
+    REQUIRE(assembler.stats().from_relations == 0);
+
+    osmium::memory::Buffer area_buffer2{10240};
+    REQUIRE(assembler(relation, ways, area_buffer2));
+    REQUIRE(assembler.stats().outer_rings == stats1.outer_rings);
+    REQUIRE(assembler.stats().inner_rings == stats1.inner_rings);
+    REQUIRE(assembler.stats().nodes == stats1.nodes);
+
+    const auto& area1 = area_buffer1.get<osmium::Area>(0);
+    const auto& area2 = area_buffer2.get<osmium::Area>(0);
+    REQUIRE(area1.byte_size() == area2.byte_size());
+    REQUIRE(std::memcmp(area1.data(), area2.data(), area1.byte_size()) == 0);
+
+    assembler.reset();
+    REQUIRE(assembler.stats().nodes == 0);
+    REQUIRE(assembler.stats().outer_rings == 0);
+}
@@ -0,0 +1,316 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, double x, double y, double size, bool tagged) {
+        const osmium::object_id_type n = id * 10;
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _tag(tagged ? "building" : "note", "yes"),
+            _nodes({
+                {n + 1, {x,        y}},
+                {n + 2, {x,        y + size}},
+                {n + 3, {x + size, y + size}},
+                {n + 4, {x + size, y}},
+                {n + 1, {x,        y}}
+            })
+        );
+    }
+
+    osmium::memory::Buffer create_input() {
+        osmium::memory::Buffer buffer{1024 * 1024};
+
+        // closed ways not in any relation
+        for (osmium::object_id_type id = 1; id <= 50; ++id) {
+            add_square(buffer, id, static_cast<double>(id), 1.0, 0.5, true);
+        }
+
+        // outer and inner ways of multipolygons, their tags don't match
+        // the filter so they are not assembled on their own
+        for (osmium::object_id_type id = 100; id < 140; id += 2) {
+            add_square(buffer, id, static_cast<double>(id), 10.0, 1.0, false);
+            add_square(buffer, id + 1, static_cast<double>(id) + 0.25, 10.25, 0.5, false);
+        }
+
+        for (osmium::object_id_type id = 100; id < 140; id += 2) {
+            osmium::builder::add_relation(buffer,
+                _id(id),
+                _member(osmium::item_type::way, id, "outer"),
+                _member(osmium::item_type::way, id + 1, "inner"),
+                _tag("type", "multipolygon"),
+                _tag("landuse", "forest")
+            );
+        }
+
+        return buffer;
+    }
+
+    osmium::memory::Buffer assemble(const osmium::memory::Buffer& input, osmium::thread::Pool* pool, std::size_t batch_size, osmium::area::area_stats& stats) {
+        const osmium::area::Assembler::config_type config;
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, "building");
+        filter.add_rule(true, "landuse");
+        osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config, filter};
+
+        for (const auto& relation : input.select<osmium::Relation>()) {
+            manager.relation(relation);
+        }
+        manager.prepare_for_lookup();
+
+        if (pool) {
+            manager.set_thread_pool(pool, batch_size);
+        }
+
+        osmium::apply(input, manager.handler());
+
+        auto result = manager.read();
+        stats = manager.stats();
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("MultipolygonManager assembling in thread pool gives same result") {
+    const auto input = create_input();
+
+    osmium::area::area_stats serial_stats;
+    const auto serial = assemble(input, nullptr, 0, serial_stats);
+
+    REQUIRE(serial_stats.from_ways == 50);
+    REQUIRE(serial_stats.from_relations == 20);
+    REQUIRE(serial_stats.inner_rings == 20);
+
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& area : serial.select<osmium::Area>()) {
+        ids.push_back(area.id());
+    }
+    REQUIRE(ids.size() == 70);
+
+    osmium::thread::Pool pool{2};
+
+    for (const std::size_t batch_size : {1, 3, 1000}) {
+        osmium::area::area_stats parallel_stats;
+        const auto parallel = assemble(input, &pool, batch_size, parallel_stats);
+
+        REQUIRE(parallel_stats.from_ways == serial_stats.from_ways);
+        REQUIRE(parallel_stats.from_relations == serial_stats.from_relations);
+        REQUIRE(parallel_stats.inner_rings == serial_stats.inner_rings);
+        REQUIRE(parallel_stats.nodes == serial_stats.nodes);
+
+        REQUIRE(parallel.committed() == serial.committed());
+        REQUIRE(std::memcmp(parallel.data(), serial.data(), serial.committed()) == 0);
+    }
+}
+
+TEST_CASE("MultipolygonManager assembling in thread pool with several input buffers") {
+    const auto input = create_input();
+
+    osmium::area::area_stats serial_stats;
+    const auto serial = assemble(input, nullptr, 0, serial_stats);
+
+    // Split input into buffers of a few objects each like a reader would.
+    std::vector<osmium::memory::Buffer> buffers;
+    std::size_t n = 0;
+    for (const auto& object : input.select<osmium::OSMObject>()) {
+        if (n++ % 7 == 0) {
+            buffers.emplace_back(1024 * 1024);
+        }
+        buffers.back().add_item(object);
+        buffers.back().commit();
+    }
+    REQUIRE(buffers.size() > 10);
+
+    const osmium::area::Assembler::config_type config;
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "building");
+    filter.add_rule(true, "landuse");
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config, filter};
+
+    for (const auto& relation : input.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    osmium::thread::Pool pool{2};
+    manager.set_thread_pool(&pool, 3);
+
+    osmium::memory::Buffer parallel{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    auto& handler = manager.handler([&parallel](osmium::memory::Buffer&& buffer) {
+        parallel.add_buffer(buffer);
+        parallel.commit();
+    });
+
+    for (const auto& buffer : buffers) {
+        osmium::apply(buffer, handler);
+    }
+    manager.finish_output();
+
+    REQUIRE(manager.stats().from_ways == serial_stats.from_ways);
+    REQUIRE(manager.stats().from_relations == serial_stats.from_relations);
+    REQUIRE(parallel.committed() == serial.committed());
+    REQUIRE(std::memcmp(parallel.data(), serial.data(), serial.committed()) == 0);
+}
+
+
+TEST_CASE("MultipolygonManager with area filter only assembles some areas") {
+    const auto input = create_input();
+
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> area_ids;
+    area_ids.set(osmium::object_id_to_area_id(7, osmium::item_type::way));
+    area_ids.set(osmium::object_id_to_area_id(104, osmium::item_type::relation));
+    area_ids.set(osmium::object_id_to_area_id(105, osmium::item_type::way)); // not tagged
+
+    const osmium::area::Assembler::config_type config;
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "building");
+    filter.add_rule(true, "landuse");
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config, filter};
+    manager.set_area_filter(&area_ids);
+
+    for (const auto& relation : input.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+    REQUIRE(manager.relations_database().count_relations() == 1);
+
+    osmium::apply(input, manager.handler());
+
+    const auto result = manager.read();
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& area : result.select<osmium::Area>()) {
+        ids.push_back(area.id());
+    }
+    REQUIRE(ids == std::vector<osmium::object_id_type>({14, 209}));
+}
+
+namespace {
+
+    using manager_type = osmium::area::MultipolygonManager<osmium::area::Assembler>;
+
+    struct assembled {
+        std::size_t collected = 0;
+        std::size_t rejected = 0;
+        std::vector<osmium::object_id_type> ids;
+    };
+
+    template <typename TFunc>
+    assembled assemble_relations(const osmium::memory::Buffer& input, TFunc&& configure) {
+        const osmium::area::Assembler::config_type config;
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, "landuse");
+        manager_type manager{config, filter};
+        std::forward<TFunc>(configure)(manager);
+
+        for (const auto& relation : input.select<osmium::Relation>()) {
+            manager.relation(relation);
+        }
+        manager.prepare_for_lookup();
+
+        assembled result;
+        result.collected = manager.relations_database().count_relations();
+
+        osmium::apply(input, manager.handler());
+
+        const auto buffer = manager.read();
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            result.ids.push_back(area.orig_id());
+        }
+        result.rejected = manager.rejected_relations();
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("MultipolygonManager rejecting relations before collecting members") {
+    const auto input = create_input();
+
+    SECTION("no checks") {
+        const auto result = assemble_relations(input, [](manager_type& /*manager*/) {});
+        REQUIRE(result.collected == 20);
+        REQUIRE(result.ids.size() == 20);
+    }
+
+    SECTION("by number of way members") {
+        REQUIRE(assemble_relations(input, [](manager_type& manager) {
+            manager.set_max_way_members(2);
+        }).collected == 20);
+
+        const auto result = assemble_relations(input, [](manager_type& manager) {
+            manager.set_max_way_members(1);
+        });
+        REQUIRE(result.collected == 0);
+        REQUIRE(result.ids.empty());
+    }
+
+    SECTION("by relation filter") {
+        const auto result = assemble_relations(input, [](manager_type& manager) {
+            manager.set_relation_filter([](const osmium::Relation& relation) {
+                return relation.id() % 4 == 0;
+            });
+        });
+        REQUIRE(result.collected == 10);
+        REQUIRE(result.ids.size() == 10);
+        REQUIRE(result.ids.front() == 100);
+        REQUIRE(result.rejected == 0);
+    }
+
+    SECTION("by envelope") {
+        const auto result = assemble_relations(input, [](manager_type& manager) {
+            manager.set_envelope_check([](const osmium::Box& envelope) {
+                return envelope.top_right().lon() <= 120.0;
+            });
+        });
+        REQUIRE(result.collected == 20);
+        REQUIRE(result.rejected == 10);
+        REQUIRE(result.ids.size() == 10);
+        REQUIRE(result.ids.back() == 118);
+    }
+}
+
+TEST_CASE("MultipolygonManager ring closure check") {
+    osmium::memory::Buffer input{1024 * 64};
+
+    // Two open ways forming a ring
+    osmium::builder::add_way(input, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {1.0, 2.0}}, {3, {2.0, 2.0}}}));
+    osmium::builder::add_way(input, _id(2), _nodes({{3, {2.0, 2.0}}, {4, {2.0, 1.0}}, {1, {1.0, 1.0}}}));
+
+    // Two open ways not meeting at one end
+    osmium::builder::add_way(input, _id(3), _nodes({{5, {5.0, 1.0}}, {6, {5.0, 2.0}}, {7, {6.0, 2.0}}}));
+    osmium::builder::add_way(input, _id(4), _nodes({{7, {6.0, 2.0}}, {8, {6.0, 1.0}}, {9, {5.5, 1.0}}}));
+
+    for (const osmium::object_id_type id : {10, 11}) {
+        osmium::builder::add_relation(input, _id(id),
+            _member(osmium::item_type::way, id == 10 ? 1 : 3, "outer"),
+            _member(osmium::item_type::way, id == 10 ? 2 : 4, "outer"),
+            _tag("type", "multipolygon"),
+            _tag("landuse", "forest")
+        );
+    }
+
+    // Without the check an empty area is created for relation 11
+    const auto unchecked = assemble_relations(input, [](manager_type& /*manager*/) {});
+    REQUIRE(unchecked.ids == std::vector<osmium::object_id_type>({10, 11}));
+
+    const auto checked = assemble_relations(input, [](manager_type& manager) {
+        manager.enable_ring_closure_check();
+    });
+    REQUIRE(checked.ids == std::vector<osmium::object_id_type>{10});
+    REQUIRE(checked.rejected == 1);
+}
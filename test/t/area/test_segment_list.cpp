@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct intersection {
+        osmium::Location a1;
+        osmium::Location a2;
+        osmium::Location b1;
+        osmium::Location b2;
+        osmium::Location location;
+
+        bool operator==(const intersection& other) const noexcept {
+            return a1 == other.a1 && a2 == other.a2 &&
+                   b1 == other.b1 && b2 == other.b2 &&
+                   location == other.location;
+        }
+    };
+
+    class RecordingProblemReporter : public osmium::area::ProblemReporter {
+
+    public:
+
+        std::vector<intersection> intersections;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location way1_seg_start, osmium::Location way1_seg_end,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location way2_seg_start, osmium::Location way2_seg_end, osmium::Location intersection) override {
+            intersections.push_back({way1_seg_start, way1_seg_end, way2_seg_start, way2_seg_end, intersection});
+        }
+
+    }; // class RecordingProblemReporter
+
+    // Random walk with some long jumps, so there are long segments
+    // overlapping many others in x direction.
+    const osmium::Way& random_way(osmium::memory::Buffer& buffer, std::size_t num_nodes) {
+        uint32_t state = 12345;
+        const auto random = [&state](int32_t max) {
+            state = state * 1103515245U + 12345U;
+            return static_cast<int32_t>((state >> 8U) % static_cast<uint32_t>(max));
+        };
+
+        std::vector<osmium::NodeRef> nodes;
+        int32_t x = 0;
+        int32_t y = 0;
+        for (std::size_t i = 1; i <= num_nodes; ++i) {
+            if (random(20) == 0) {
+                x = random(1000000);
+                y = random(1000000);
+            } else {
+                x = std::max(0, x + random(20001) - 10000);
+                y = std::max(0, y + random(20001) - 10000);
+            }
+            nodes.emplace_back(static_cast<osmium::object_id_type>(i), osmium::Location{x, y});
+        }
+
+        const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+        return buffer.get<osmium::Way>(pos);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Sweep line finds the same intersections as simple algorithm") {
+    osmium::memory::Buffer buffer{1024 * 1024};
+    const auto& way = random_way(buffer, 3000);
+
+    osmium::area::detail::SegmentList segment_list{false};
+    uint64_t duplicate_nodes = 0;
+    segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segment_list.sort();
+    uint64_t duplicate_segments = 0;
+    uint64_t overlapping_segments = 0;
+    segment_list.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+    REQUIRE(segment_list.size() >= osmium::area::detail::SegmentList::min_segments_for_sweep_line);
+
+    RecordingProblemReporter simple;
+    const auto num_simple = segment_list.find_intersections_simple(&simple);
+
+    RecordingProblemReporter sweep;
+    const auto num_sweep = segment_list.find_intersections_sweep_line(&sweep);
+
+    REQUIRE(num_simple > 0);
+    REQUIRE(num_simple == simple.intersections.size());
+    REQUIRE(num_sweep == num_simple);
+    REQUIRE(sweep.intersections == simple.intersections);
+
+    REQUIRE(segment_list.find_intersections(nullptr) == num_simple);
+}
+
+TEST_CASE("Sweep line on empty segment list") {
+    const osmium::area::detail::SegmentList segment_list{false};
+    REQUIRE(segment_list.find_intersections_sweep_line(nullptr) == 0);
+    REQUIRE(segment_list.find_intersections_simple(nullptr) == 0);
+}
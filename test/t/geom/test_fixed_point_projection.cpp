@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+#include "wnl_helper.hpp"
+
+#include <osmium/geom/geojson.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/geom/wkt.hpp>
+
+#include <string>
+
+TEST_CASE("Fixed point projection") {
+    const osmium::geom::FixedPointProjection projection;
+    REQUIRE(projection.epsg() == 4326);
+    REQUIRE(projection(osmium::Location{3.2, 4.2}) == osmium::Location(3.2, 4.2));
+    REQUIRE_THROWS_AS(projection(osmium::Location{}), const osmium::invalid_location&);
+}
+
+TEST_CASE("Fixed point append with precision") {
+    std::string str;
+
+    SECTION("full precision") {
+        osmium::geom::detail::append_fixed_point(str, -1234567890, 7);
+        REQUIRE(str == "-123.456789");
+    }
+
+    SECTION("rounded") {
+        osmium::geom::detail::append_fixed_point(str, 1234567850, 5);
+        REQUIRE(str == "123.45679");
+    }
+
+    SECTION("rounded negative") {
+        osmium::geom::detail::append_fixed_point(str, -1234567850, 5);
+        REQUIRE(str == "-123.45679");
+    }
+
+    SECTION("rounded to integer") {
+        osmium::geom::detail::append_fixed_point(str, 1795000000, 0);
+        REQUIRE(str == "180");
+    }
+}
+
+TEST_CASE("WKT geometry with fixed point projection") {
+    osmium::geom::WKTFactory<osmium::geom::FixedPointProjection> fp_factory;
+
+    REQUIRE(fp_factory.create_point(osmium::Location{3.2, 4.2}) == "POINT(3.2 4.2)");
+    REQUIRE_THROWS_AS(fp_factory.create_point(osmium::Location{}), const osmium::invalid_location&);
+
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("linestring") {
+        const auto& wnl = create_test_wnl_okay(buffer);
+        REQUIRE(fp_factory.create_linestring(wnl) == "LINESTRING(3.2 4.2,3.5 4.7,3.6 4.9)");
+        REQUIRE(fp_factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward) ==
+                "LINESTRING(3.6 4.9,3.5 4.7,3.5 4.7,3.2 4.2)");
+    }
+
+    SECTION("area") {
+        const auto& area = create_test_area_2outer_2inner(buffer);
+        osmium::geom::WKTFactory<> ref_factory;
+        REQUIRE(fp_factory.create_multipolygon(area) == ref_factory.create_multipolygon(area));
+    }
+}
+
+TEST_CASE("WKT geometry with fixed point projection and lower precision") {
+    osmium::geom::WKTFactory<osmium::geom::FixedPointProjection> factory{2, osmium::geom::wkt_type::ewkt};
+    REQUIRE(factory.create_point(osmium::Location{3.2456, -4.2}) == "SRID=4326;POINT(3.25 -4.2)");
+}
+
+TEST_CASE("GeoJSON geometry with fixed point projection") {
+    osmium::geom::GeoJSONFactory<osmium::geom::FixedPointProjection> fp_factory;
+    osmium::geom::GeoJSONFactory<> ref_factory;
+
+    REQUIRE(fp_factory.create_point(osmium::Location{3.2, 4.2}) == "{\"type\":\"Point\",\"coordinates\":[3.2,4.2]}");
+
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("linestring") {
+        const auto& wnl = create_test_wnl_okay(buffer);
+        REQUIRE(fp_factory.create_linestring(wnl) == ref_factory.create_linestring(wnl));
+    }
+
+    SECTION("area") {
+        const auto& area = create_test_area_2outer_2inner(buffer);
+        REQUIRE(fp_factory.create_multipolygon(area) == ref_factory.create_multipolygon(area));
+    }
+}
+
+TEST_CASE("WKB geometry with fixed point projection falls back to double coordinates") {
+    osmium::geom::WKBFactory<osmium::geom::FixedPointProjection> fp_factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+    osmium::geom::WKBFactory<> ref_factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+    REQUIRE(fp_factory.create_point(osmium::Location{3.2, 4.2}) == ref_factory.create_point(osmium::Location{3.2, 4.2}));
+    REQUIRE(fp_factory.create_linestring(wnl) == ref_factory.create_linestring(wnl));
+}
@@ -171,3 +171,43 @@ TEST_CASE("GeoJSON area geometry") {
 
 }
 
+
+TEST_CASE("GeoJSON geometries appended to caller-owned string") {
+    osmium::geom::GeoJSONFactory<> ref_factory;
+
+    std::string out;
+    osmium::geom::GeoJSONAppendFactory<> factory{out};
+
+    osmium::memory::Buffer area_buffer{10000};
+    const auto& area = create_test_area_2outer_2inner(area_buffer);
+
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl_line = create_test_wnl_okay(buffer);
+    const auto& wnl_ring = create_test_wnl_closed(buffer);
+
+    std::string expected;
+
+    factory.create_point(osmium::Location{3.2, 4.2});
+    expected += ref_factory.create_point(osmium::Location{3.2, 4.2});
+    out += ',';
+    expected += ',';
+    factory.create_linestring(wnl_line);
+    expected += ref_factory.create_linestring(wnl_line);
+    out += ',';
+    expected += ',';
+    factory.create_polygon(wnl_ring);
+    expected += ref_factory.create_polygon(wnl_ring);
+    out += ',';
+    expected += ',';
+    factory.create_multipolygon(area);
+    expected += ref_factory.create_multipolygon(area);
+
+    REQUIRE(out == expected);
+}
+
+TEST_CASE("GeoJSON geometries appended with fixed point projection") {
+    std::string out;
+    osmium::geom::GeoJSONAppendFactory<osmium::geom::FixedPointProjection> factory{out, 2};
+    factory.create_point(osmium::Location{3.2456, -4.2});
+    REQUIRE(out == "{\"type\":\"Point\",\"coordinates\":[3.25,-4.2]}");
+}
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    std::vector<osmium::Location> random_line(std::size_t num, double lat) {
+        std::vector<osmium::Location> locations;
+        uint32_t state = 12345;
+        double x = 10.0;
+        double y = lat;
+        for (std::size_t i = 0; i < num; ++i) {
+            state = state * 1103515245U + 12345U;
+            x += static_cast<double>((state >> 8U) % 2001U) * 1e-5 - 0.01;
+            state = state * 1103515245U + 12345U;
+            y += static_cast<double>((state >> 8U) % 2001U) * 1e-5 - 0.01;
+            locations.emplace_back(x, y);
+        }
+        return locations;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Haversine distance between two locations") {
+    const osmium::geom::Coordinates a{0.0, 0.0};
+    const osmium::geom::Coordinates b{1.0, 0.0};
+    const double one_degree = osmium::geom::haversine::EARTH_RADIUS_IN_METERS * osmium::geom::PI / 180;
+    REQUIRE(osmium::geom::haversine::distance(a, b) == Approx(one_degree));
+    REQUIRE(osmium::geom::haversine::distance(a, a) == Approx(0.0));
+}
+
+TEST_CASE("Haversine distance of location array and way node list") {
+    const auto locations = random_line(1000, 50.0);
+
+    double expected = 0.0;
+    for (std::size_t i = 1; i < locations.size(); ++i) {
+        expected += osmium::geom::haversine::distance(locations[i - 1], locations[i]);
+    }
+
+    REQUIRE(osmium::geom::haversine::distance(locations.data(), locations.size()) == expected);
+    REQUIRE(osmium::geom::haversine::distance(locations.data(), 1) == 0.0);
+    REQUIRE(osmium::geom::haversine::distance(locations.data(), 0) == 0.0);
+
+    std::vector<osmium::NodeRef> nodes;
+    for (const auto& location : locations) {
+        nodes.emplace_back(1, location);
+    }
+    osmium::memory::Buffer buffer{100000};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+    const auto& way = buffer.get<osmium::Way>(pos);
+    REQUIRE(osmium::geom::haversine::distance(way.nodes()) == expected);
+
+    REQUIRE(osmium::geom::haversine::approximate_distance(locations.data(), locations.size()) == Approx(expected).epsilon(1e-7));
+    REQUIRE(osmium::geom::haversine::approximate_distance(way.nodes()) == Approx(expected).epsilon(1e-7));
+}
+
+TEST_CASE("Approximate haversine distance") {
+    for (const double lat : {-80.0, -45.0, 0.0, 30.0, 60.0, 79.0}) {
+        const auto locations = random_line(100, lat);
+        const double exact = osmium::geom::haversine::distance(locations.data(), locations.size());
+        REQUIRE(osmium::geom::haversine::approximate_distance(locations.data(), locations.size()) == Approx(exact).epsilon(1e-6));
+    }
+}
+
+TEST_CASE("Haversine functions with invalid location") {
+    const std::vector<osmium::Location> locations = {
+        osmium::Location{1.0, 2.0},
+        osmium::Location{},
+        osmium::Location{1.0, 3.0}
+    };
+
+    REQUIRE_THROWS_AS(osmium::geom::haversine::distance(locations.data(), locations.size()), const osmium::invalid_location&);
+    REQUIRE_THROWS_AS(osmium::geom::haversine::approximate_distance(locations.data(), locations.size()), const osmium::invalid_location&);
+    REQUIRE_THROWS_AS(osmium::geom::haversine::area(locations.data(), locations.size()), const osmium::invalid_location&);
+}
+
+TEST_CASE("Haversine area of ring") {
+    // Area of a lat/lon rectangle on the sphere is R^2 * dlon * (sin(lat2) - sin(lat1))
+    const double r = osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+    const double expected = r * r * osmium::geom::deg_to_rad(2.0) *
+                            (std::sin(osmium::geom::deg_to_rad(51.0)) - std::sin(osmium::geom::deg_to_rad(50.0)));
+
+    const std::vector<osmium::Location> ccw = {
+        osmium::Location{8.0, 50.0},
+        osmium::Location{10.0, 50.0},
+        osmium::Location{10.0, 51.0},
+        osmium::Location{8.0, 51.0},
+        osmium::Location{8.0, 50.0}
+    };
+    REQUIRE(osmium::geom::haversine::area(ccw.data(), ccw.size()) == Approx(expected).epsilon(1e-9));
+
+    const std::vector<osmium::Location> cw(ccw.rbegin(), ccw.rend());
+    REQUIRE(osmium::geom::haversine::area(cw.data(), cw.size()) == Approx(-expected).epsilon(1e-9));
+
+    // small building-sized square
+    const std::vector<osmium::Location> small = {
+        osmium::Location{8.0, 50.0},
+        osmium::Location{8.0001, 50.0},
+        osmium::Location{8.0001, 50.0001},
+        osmium::Location{8.0, 50.0001},
+        osmium::Location{8.0, 50.0}
+    };
+    const double expected_small = r * r * osmium::geom::deg_to_rad(0.0001) *
+                                  (std::sin(osmium::geom::deg_to_rad(50.0001)) - std::sin(osmium::geom::deg_to_rad(50.0)));
+    REQUIRE(osmium::geom::haversine::area(small.data(), small.size()) == Approx(expected_small).epsilon(1e-6));
+}
+
+TEST_CASE("Haversine area of osmium::Area") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& area = create_test_area_1outer_1inner(buffer);
+
+    double outer = 0.0;
+    double inner = 0.0;
+    for (const auto& ring : area.outer_rings()) {
+        outer = osmium::geom::haversine::area(ring);
+        for (const auto& inner_ring : area.inner_rings(ring)) {
+            inner = osmium::geom::haversine::area(inner_ring);
+        }
+    }
+
+    REQUIRE(outer != 0.0);
+    REQUIRE(inner != 0.0);
+    REQUIRE(osmium::geom::haversine::area(area) == Approx(std::abs(outer) - std::abs(inner)));
+}
@@ -1,6 +1,15 @@
 #include "catch.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Mercator projection") {
     const osmium::geom::MercatorProjection projection;
@@ -32,3 +41,76 @@ TEST_CASE("Mercator bounds") {
     REQUIRE(osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0)) == Approx(osmium::geom::MERCATOR_MAX_LAT).epsilon(0.0000001));
 }
 
+
+TEST_CASE("Mercator projection of location arrays") {
+    std::vector<osmium::Location> locations;
+    for (int32_t lat = -850000000; lat <= 850000000; lat += 1234567) {
+        locations.emplace_back(lat * 2 % 1800000000, lat);
+    }
+    locations.emplace_back(0.0, 78.0);
+    locations.emplace_back(0.0, -78.0000001);
+    locations.emplace_back(180.0, osmium::geom::MERCATOR_MAX_LAT);
+
+    const osmium::geom::MercatorProjection projection;
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection(locations.data(), locations.data() + locations.size(), coordinates.data());
+
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        const auto c = projection(locations[i]);
+        REQUIRE(coordinates[i].x == Approx(c.x).epsilon(1e-12));
+        REQUIRE(coordinates[i].y == Approx(c.y).epsilon(1e-12));
+    }
+}
+
+TEST_CASE("Mercator projection of location arrays with invalid location") {
+    const std::vector<osmium::Location> locations = {
+        osmium::Location{1.0, 2.0},
+        osmium::Location{}
+    };
+
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    REQUIRE_THROWS_AS(osmium::geom::lonlat_to_mercator(locations.data(), locations.size(), coordinates.data()), const osmium::invalid_location&);
+}
+
+namespace {
+
+    // Mercator projection without the array interface
+    struct SingleMercatorProjection {
+
+        osmium::geom::Coordinates operator()(osmium::Location location) const {
+            return osmium::geom::MercatorProjection{}(location);
+        }
+
+        int epsg() const noexcept {
+            return 3857;
+        }
+
+    }; // struct SingleMercatorProjection
+
+} // anonymous namespace
+
+TEST_CASE("Geometry factory uses Mercator projection of location arrays") {
+    static_assert(osmium::geom::detail::has_array_projection<osmium::geom::MercatorProjection>::type::value, "array projection");
+    static_assert(!osmium::geom::detail::has_array_projection<SingleMercatorProjection>::type::value, "no array projection");
+
+    osmium::memory::Buffer buffer{10000};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {3.2, 4.2}},
+        {2, {3.5, 4.7}},
+        {2, {3.5, 4.7}},
+        {3, {3.6, 80.1}},
+        {1, {3.2, 4.2}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(pos);
+
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{2};
+    osmium::geom::WKTFactory<SingleMercatorProjection> single_factory{2};
+
+    for (const auto un : {osmium::geom::use_nodes::unique, osmium::geom::use_nodes::all}) {
+        for (const auto dir : {osmium::geom::direction::forward, osmium::geom::direction::backward}) {
+            REQUIRE(factory.create_linestring(way, un, dir) == single_factory.create_linestring(way, un, dir));
+        }
+    }
+    REQUIRE(factory.create_linestring(way) == "LINESTRING(356222.37 467961.14,389618.22 523789.37,400750.17 15603136.85,356222.37 467961.14)");
+    REQUIRE(factory.create_polygon(way) == single_factory.create_polygon(way));
+}
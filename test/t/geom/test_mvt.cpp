@@ -0,0 +1,221 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/mvt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct point {
+        int32_t x;
+        int32_t y;
+    };
+
+    struct part {
+        std::vector<point> points;
+        bool closed = false;
+
+        int64_t area() const {
+            int64_t sum = 0;
+            point prev = points.back();
+            for (const auto& p : points) {
+                sum += static_cast<int64_t>(prev.x) * p.y - static_cast<int64_t>(p.x) * prev.y;
+                prev = p;
+            }
+            return sum;
+        }
+    };
+
+    int32_t unzigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1U) ^ -static_cast<int32_t>(value & 1U);
+    }
+
+    // Decode MVT geometry, checking the command structure on the way.
+    std::vector<part> decode(const std::vector<uint32_t>& geometry) {
+        std::vector<part> parts;
+        point cursor{0, 0};
+        std::size_t i = 0;
+        while (i < geometry.size()) {
+            const uint32_t command = geometry[i] & 0x7U;
+            const uint32_t count = geometry[i] >> 3U;
+            ++i;
+            if (command == 7) {
+                REQUIRE(count == 1);
+                REQUIRE_FALSE(parts.empty());
+                parts.back().closed = true;
+                continue;
+            }
+            REQUIRE((command == 1 || command == 2));
+            if (command == 1) {
+                REQUIRE(count == 1);
+                parts.emplace_back();
+            }
+            REQUIRE_FALSE(parts.empty());
+            for (uint32_t n = 0; n < count; ++n) {
+                REQUIRE(i + 1 < geometry.size());
+                cursor.x += unzigzag(geometry[i++]);
+                cursor.y += unzigzag(geometry[i++]);
+                parts.back().points.push_back(cursor);
+            }
+        }
+        return parts;
+    }
+
+    const osmium::Way& add_way(osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations) {
+        std::vector<osmium::NodeRef> nodes;
+        osmium::object_id_type id = 1;
+        for (const auto& location : locations) {
+            nodes.emplace_back(id++, location);
+        }
+        const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+        return buffer.get<osmium::Way>(pos);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("MVT command and zigzag encoding") {
+    REQUIRE(osmium::geom::detail::mvt_zigzag(0) == 0);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(-1) == 1);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(1) == 2);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(-2) == 3);
+    REQUIRE(osmium::geom::detail::mvt_command_integer(osmium::geom::detail::mvt_move_to, 1) == 9);
+    REQUIRE(osmium::geom::detail::mvt_command_integer(osmium::geom::detail::mvt_line_to, 3) == 26);
+    REQUIRE(osmium::geom::detail::mvt_command_integer(osmium::geom::detail::mvt_close_path, 1) == 15);
+}
+
+TEST_CASE("MVT factory needs Mercator projection") {
+    const osmium::geom::Tile tile{0, 0, 0};
+    REQUIRE_THROWS_AS(osmium::geom::MVTFactory<osmium::geom::IdentityProjection>{tile}, const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::geom::MVTFactory<>(tile, 0), const std::invalid_argument&);
+}
+
+TEST_CASE("MVT point") {
+    const osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+    REQUIRE(factory.create_point(osmium::Location{0.0, 0.0}) == std::vector<uint32_t>({9, 4096, 4096}));
+
+    // tile in north-west quarter of the world
+    const osmium::geom::MVTFactory<> factory_nw{osmium::geom::Tile{1, 0, 0}, 256, 0};
+    REQUIRE(factory_nw.create_point(osmium::Location{-90.0, 0.0}) == std::vector<uint32_t>({9, 256, 512}));
+    REQUIRE(factory_nw.create_point(osmium::Location{90.0, 10.0}).empty());
+}
+
+TEST_CASE("MVT linestring") {
+    osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 0, 0}, 4096, 64};
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("inside tile") {
+        const auto& way = add_way(buffer, {{-90.0, 10.0}, {-45.0, 10.0}, {-45.0, 20.0}});
+        const auto parts = decode(factory.create_linestring(way));
+        REQUIRE(parts.size() == 1);
+        REQUIRE_FALSE(parts[0].closed);
+        REQUIRE(parts[0].points.size() == 3);
+        REQUIRE(parts[0].points[0].x == 2048);
+        REQUIRE(parts[0].points[1].x == 3072);
+        REQUIRE(parts[0].points[1].y == parts[0].points[0].y);
+        REQUIRE(parts[0].points[2].y < parts[0].points[1].y);
+    }
+
+    SECTION("clipped at buffer") {
+        const auto& way = add_way(buffer, {{-90.0, 10.0}, {90.0, 10.0}});
+        const auto parts = decode(factory.create_linestring(way));
+        REQUIRE(parts.size() == 1);
+        REQUIRE(parts[0].points.size() == 2);
+        REQUIRE(parts[0].points[0].x == 2048);
+        REQUIRE(parts[0].points[1].x == 4096 + 64);
+        REQUIRE(parts[0].points[1].y == parts[0].points[0].y);
+    }
+
+    SECTION("leaving and entering tile gives two parts") {
+        const auto& way = add_way(buffer, {{-90.0, 10.0}, {90.0, 10.0}, {90.0, 20.0}, {-90.0, 20.0}});
+        const auto parts = decode(factory.create_linestring(way));
+        REQUIRE(parts.size() == 2);
+        REQUIRE(parts[0].points.back().x == 4160);
+        REQUIRE(parts[1].points.front().x == 4160);
+        REQUIRE(parts[1].points.back().x == 2048);
+    }
+
+    SECTION("crossing tile") {
+        const auto& way = add_way(buffer, {{-170.0, -10.0}, {10.0, 80.0}});
+        const auto parts = decode(factory.create_linestring(way));
+        REQUIRE(parts.size() == 1);
+        for (const auto& p : parts[0].points) {
+            REQUIRE(p.x >= -64);
+            REQUIRE(p.x <= 4160);
+            REQUIRE(p.y >= -64);
+            REQUIRE(p.y <= 4160);
+        }
+    }
+
+    SECTION("outside tile") {
+        const auto& way = add_way(buffer, {{10.0, 10.0}, {20.0, 20.0}});
+        REQUIRE(factory.create_linestring(way).empty());
+    }
+}
+
+TEST_CASE("MVT polygon") {
+    osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 0, 0}, 4096, 64};
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("inside tile in both orientations") {
+        const auto& way1 = add_way(buffer, {{-90.0, 10.0}, {-45.0, 10.0}, {-45.0, 20.0}, {-90.0, 10.0}});
+        const auto parts1 = decode(factory.create_polygon(way1));
+        REQUIRE(parts1.size() == 1);
+        REQUIRE(parts1[0].closed);
+        REQUIRE(parts1[0].points.size() == 3);
+        REQUIRE(parts1[0].area() > 0);
+
+        const auto& way2 = add_way(buffer, {{-90.0, 10.0}, {-45.0, 20.0}, {-45.0, 10.0}, {-90.0, 10.0}});
+        const auto parts2 = decode(factory.create_polygon(way2));
+        REQUIRE(parts2.size() == 1);
+        REQUIRE(parts2[0].area() == parts1[0].area());
+    }
+
+    SECTION("covering the whole tile") {
+        osmium::geom::MVTFactory<> factory_z2{osmium::geom::Tile{2, 1, 1}, 4096, 64};
+        const auto& way = add_way(buffer, {{-179.0, -80.0}, {179.0, -80.0}, {179.0, 80.0}, {-179.0, 80.0}, {-179.0, -80.0}});
+        const auto parts = decode(factory_z2.create_polygon(way));
+        REQUIRE(parts.size() == 1);
+        REQUIRE(parts[0].points.size() == 4);
+        for (const auto& p : parts[0].points) {
+            REQUIRE((p.x == -64 || p.x == 4160));
+            REQUIRE((p.y == -64 || p.y == 4160));
+        }
+        REQUIRE(parts[0].area() == 2LL * 4224 * 4224);
+    }
+
+    SECTION("outside tile") {
+        const auto& way = add_way(buffer, {{10.0, 10.0}, {20.0, 10.0}, {20.0, 20.0}, {10.0, 10.0}});
+        REQUIRE(factory.create_polygon(way).empty());
+    }
+}
+
+TEST_CASE("MVT multipolygon") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& area = create_test_area_1outer_1inner(buffer);
+
+    SECTION("inside tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{4, 8, 7}};
+        const auto parts = decode(factory.create_multipolygon(area));
+        REQUIRE(parts.size() == 2);
+        REQUIRE(parts[0].closed);
+        REQUIRE(parts[1].closed);
+        REQUIRE(parts[0].points.size() == 4);
+        REQUIRE(parts[1].points.size() == 4);
+        REQUIRE(parts[0].area() > 0);
+        REQUIRE(parts[1].area() < 0);
+    }
+
+    SECTION("outside tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{4, 2, 2}};
+        REQUIRE(factory.create_multipolygon(area).empty());
+    }
+}
@@ -0,0 +1,151 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/geom/wkb_batch.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::memory::Buffer create_input() {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (osmium::object_id_type id = 1; id <= 500; ++id) {
+            const double x = static_cast<double>(id) / 10.0;
+            osmium::builder::add_node(buffer, _id(id), _location(x, 1.0));
+            osmium::builder::add_way(buffer, _id(id), _nodes({
+                {1, {x, 1.0}},
+                {2, {x + 0.1, 1.0}},
+                {3, {x + 0.1, 1.1}}
+            }));
+            osmium::builder::add_area(buffer, _id(id * 2),
+                _outer_ring({
+                    {1, {x, 1.0}},
+                    {2, {x + 0.1, 1.0}},
+                    {3, {x + 0.1, 1.1}},
+                    {1, {x, 1.0}}
+                }),
+                _inner_ring({
+                    {4, {x + 0.05, 1.01}},
+                    {5, {x + 0.08, 1.01}},
+                    {6, {x + 0.08, 1.04}},
+                    {4, {x + 0.05, 1.01}}
+                })
+            );
+        }
+
+        // invalid objects
+        osmium::builder::add_node(buffer, _id(1000));
+        osmium::builder::add_way(buffer, _id(1000), _nodes({{1, {1.0, 1.0}}, {1, {1.0, 1.0}}}));
+        osmium::builder::add_area(buffer, _id(2000));
+
+        return buffer;
+    }
+
+    template <typename TProjection>
+    void check_batches(const osmium::memory::Buffer& input,
+                       osmium::geom::WKBBatchFactory<TProjection>& batch_factory,
+                       osmium::geom::WKBFactory<TProjection>& factory) {
+        const auto points = batch_factory.create_points(input);
+        const auto linestrings = batch_factory.create_linestrings(input, osmium::geom::use_nodes::unique, osmium::geom::direction::backward);
+        const auto multipolygons = batch_factory.create_multipolygons(input);
+
+        REQUIRE(points.size() == 500);
+        REQUIRE(points.errors() == 1);
+        REQUIRE(linestrings.size() == 500);
+        REQUIRE(linestrings.errors() == 1);
+        REQUIRE(multipolygons.size() == 500);
+        REQUIRE(multipolygons.errors() == 1);
+        REQUIRE(points.offsets().size() == 501);
+        REQUIRE(points.offsets().back() == points.data().size());
+
+        std::size_t n = 0;
+        for (const auto& node : input.select<osmium::Node>()) {
+            if (n < points.size()) {
+                REQUIRE(points.ids()[n] == node.id());
+                REQUIRE(points.geometry(n) == factory.create_point(node));
+            }
+            ++n;
+        }
+
+        n = 0;
+        for (const auto& way : input.select<osmium::Way>()) {
+            if (n < linestrings.size()) {
+                REQUIRE(linestrings.ids()[n] == way.id());
+                REQUIRE(linestrings.geometry(n) == factory.create_linestring(way, osmium::geom::use_nodes::unique, osmium::geom::direction::backward));
+            }
+            ++n;
+        }
+
+        n = 0;
+        for (const auto& area : input.select<osmium::Area>()) {
+            if (n < multipolygons.size()) {
+                REQUIRE(multipolygons.ids()[n] == area.id());
+                REQUIRE(multipolygons.geometry(n) == factory.create_multipolygon(area));
+            }
+            ++n;
+        }
+    }
+
+} // anonymous namespace
+
+TEST_CASE("WKB batch factory creates same geometries as WKB factory") {
+    const auto input = create_input();
+
+    osmium::geom::WKBBatchFactory<> batch_factory;
+    osmium::geom::WKBFactory<> factory;
+    REQUIRE(batch_factory.epsg() == 4326);
+
+    SECTION("in calling thread") {
+        check_batches(input, batch_factory, factory);
+    }
+
+    SECTION("in thread pool") {
+        osmium::thread::Pool pool{2};
+        batch_factory.set_thread_pool(&pool, 7);
+        check_batches(input, batch_factory, factory);
+    }
+}
+
+TEST_CASE("WKB batch factory with hex EWKB and projection") {
+    const auto input = create_input();
+
+    osmium::geom::WKBBatchFactory<osmium::geom::MercatorProjection> batch_factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+    osmium::geom::WKBFactory<osmium::geom::MercatorProjection> factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+    REQUIRE(batch_factory.epsg() == 3857);
+
+    osmium::thread::Pool pool{2};
+    batch_factory.set_thread_pool(&pool, 100);
+    check_batches(input, batch_factory, factory);
+}
+
+TEST_CASE("Appending and clearing WKB batches") {
+    osmium::geom::WKBBatch batch1;
+    batch1.add(1, "ab", osmium::geom::out_type::binary);
+    batch1.add(2, "c", osmium::geom::out_type::binary);
+
+    osmium::geom::WKBBatch batch2;
+    batch2.add(3, "d", osmium::geom::out_type::hex);
+    batch2.add_error();
+
+    batch1.append(batch2);
+    REQUIRE(batch1.size() == 3);
+    REQUIRE(batch1.data() == "abc64");
+    REQUIRE(batch1.geometry(2) == "64");
+    REQUIRE(batch1.geometry_size(0) == 2);
+    REQUIRE(batch1.ids().back() == 3);
+    REQUIRE(batch1.errors() == 1);
+
+    batch1.clear();
+    REQUIRE(batch1.empty());
+    REQUIRE(batch1.offsets().size() == 1);
+}
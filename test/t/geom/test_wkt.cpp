@@ -153,3 +153,40 @@ TEST_CASE("WKT geometry factory") {
 
 }
 
+
+TEST_CASE("WKT geometries appended to caller-owned string") {
+    osmium::geom::WKTFactory<> ref_factory{3, osmium::geom::wkt_type::ewkt};
+
+    std::string out{"START;"};
+    osmium::geom::WKTAppendFactory<> factory{out, 3, osmium::geom::wkt_type::ewkt};
+
+    osmium::memory::Buffer area_buffer{10000};
+    const auto& area = create_test_area_2outer_2inner(area_buffer);
+
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl_line = create_test_wnl_okay(buffer);
+    const auto& wnl_ring = create_test_wnl_closed(buffer);
+
+    std::string expected{"START;"};
+
+    factory.create_point(osmium::Location{3.2, 4.2});
+    expected += ref_factory.create_point(osmium::Location{3.2, 4.2});
+    REQUIRE(out == expected);
+
+    factory.create_linestring(wnl_line);
+    expected += ref_factory.create_linestring(wnl_line);
+    factory.create_polygon(wnl_ring);
+    expected += ref_factory.create_polygon(wnl_ring);
+    factory.create_multipolygon(area);
+    expected += ref_factory.create_multipolygon(area);
+    REQUIRE(out == expected);
+
+    // Failed geometry leaves partial output which has to be removed by the caller
+    const auto size = out.size();
+    REQUIRE_THROWS_AS(factory.create_linestring(create_test_wnl_same_location(buffer)), const osmium::geometry_error&);
+    out.resize(size);
+
+    factory.create_point(osmium::Location{1.0, 2.0});
+    expected += "SRID=4326;POINT(1 2)";
+    REQUIRE(out == expected);
+}
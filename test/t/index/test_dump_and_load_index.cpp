@@ -10,6 +10,10 @@
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 using dense_file_array = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
 using sparse_file_array = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
 
@@ -54,6 +58,21 @@ TEST_CASE("Dump DenseMmapArray, load as DenseFileArray") {
     auto dump_method = [](dense_mmap_array& index, const int fd) { index.dump_as_array(fd);};
     test_index<dense_mmap_array, dense_file_array>(dump_method);
 }
+
+using create_dense_mmap_array = osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray>;
+
+TEST_CASE("DenseMmapArray with mapping options from map config") {
+    const std::vector<std::string> config = {"dense_mmap_array", "huge_pages", "populate", "numa_interleave"};
+    std::unique_ptr<dense_mmap_array> index{create_dense_mmap_array{}(config)};
+
+    const osmium::Location loc{1.2, 4.5};
+    index->set(5000000, loc);
+    REQUIRE(index->get(5000000) == loc);
+    REQUIRE(index->get_noexcept(17) == osmium::Location{});
+
+    const std::vector<std::string> bad_config = {"dense_mmap_array", "foo"};
+    REQUIRE_THROWS_AS(create_dense_mmap_array{}(bad_config), const osmium::map_factory_error&);
+}
 #else
 # pragma message("not running 'DenseMmapArray' test case on this machine")
 #endif
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/flex_file.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <stdexcept>
+
+using flex_mem_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+using flex_file_type = osmium::index::map::FlexFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+static void fill_and_check(bool dense) {
+    const osmium::unsigned_object_id_type id1 = 12;
+    const osmium::unsigned_object_id_type id2 = 3;
+    const osmium::unsigned_object_id_type id3 = 1000000;
+    const osmium::Location loc1{1.2, 4.5};
+    const osmium::Location loc2{3.5, -7.2};
+    const osmium::Location loc3{-12.7, 14.5};
+
+    const int fd = osmium::detail::create_tmp_file();
+
+    {
+        flex_mem_type index{dense};
+        index.set(id1, loc1);
+        index.set(id2, loc2);
+        index.set(id3, loc3);
+        index.dump_as_flex(fd);
+    }
+
+    REQUIRE(osmium::file_size(fd) >= 3 * sizeof(osmium::Location));
+
+    flex_file_type file_index{fd};
+    REQUIRE(file_index.is_dense() == dense);
+
+    REQUIRE(loc1 == file_index.get(id1));
+    REQUIRE(loc2 == file_index.get(id2));
+    REQUIRE(loc3 == file_index.get(id3));
+    REQUIRE(file_index.get_noexcept(id1) == loc1);
+
+    REQUIRE_THROWS_AS(file_index.get(0), const osmium::not_found&);
+    REQUIRE_THROWS_AS(file_index.get(5), const osmium::not_found&);
+    REQUIRE_THROWS_AS(file_index.get(70000), const osmium::not_found&);
+    REQUIRE_THROWS_AS(file_index.get(100000000), const osmium::not_found&);
+    REQUIRE(file_index.get_noexcept(5) == osmium::Location{});
+
+    REQUIRE_THROWS_AS(file_index.set(1, loc1), const std::runtime_error&);
+
+    file_index.clear();
+    REQUIRE(file_index.size() == 0);
+    REQUIRE(file_index.get_noexcept(id1) == osmium::Location{});
+}
+
+TEST_CASE("Dump sparse FlexMem, load as FlexFile") {
+    fill_and_check(false);
+}
+
+TEST_CASE("Dump dense FlexMem, load as FlexFile") {
+    fill_and_check(true);
+}
+
+TEST_CASE("Dense FlexFile only contains used blocks") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    flex_mem_type index{true};
+    index.set(10, osmium::Location{1, 1});
+    index.set(10000000, osmium::Location{2, 2});
+    index.dump_as_flex(fd);
+
+    const auto block_size = (1ull << flex_mem_type::block_bits) * sizeof(osmium::Location);
+    REQUIRE(osmium::file_size(fd) < 3 * block_size);
+
+    flex_file_type file_index{fd};
+    REQUIRE(file_index.get(10) == (osmium::Location{1, 1}));
+    REQUIRE(file_index.get(10000000) == (osmium::Location{2, 2}));
+}
+
+TEST_CASE("FlexFile on empty or invalid file throws") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE_THROWS_AS(flex_file_type{fd}, const std::runtime_error&);
+
+    const char data[64] = "this is not a flex file";
+    osmium::io::detail::reliable_write(fd, data, sizeof(data));
+    REQUIRE_THROWS_AS(flex_file_type{fd}, const std::runtime_error&);
+}
+
+TEST_CASE("FlexFile from other value type throws") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::FlexMem<osmium::unsigned_object_id_type, uint32_t> index;
+    index.set(1, 17);
+    index.dump_as_flex(fd);
+
+    REQUIRE_THROWS_AS(flex_file_type{fd}, const std::runtime_error&);
+}
+
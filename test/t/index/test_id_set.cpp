@@ -3,6 +3,8 @@
 #include <osmium/index/id_set.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <vector>
+
 TEST_CASE("Basic functionality of IdSetDense") {
     osmium::index::IdSetDense<osmium::unsigned_object_id_type> s;
 
@@ -162,3 +164,107 @@ TEST_CASE("Iterating over IdSetSmall") {
     REQUIRE(it == s.end());
 }
 
+
+TEST_CASE("Merge IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s1;
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s2;
+
+    s1.set(3);
+    s1.set(17);
+    s2.set(17);
+    s2.set(42);
+    s2.set(1ull << 33u);
+
+    s1.merge(s2);
+    REQUIRE(s1.size() == 4);
+    REQUIRE(s1.count() == 4);
+    REQUIRE(s1.get(3));
+    REQUIRE(s1.get(17));
+    REQUIRE(s1.get(42));
+    REQUIRE(s1.get(1ull << 33u));
+    REQUIRE(s2.size() == 3);
+}
+
+TEST_CASE("Merge IdSetSmall into IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s1;
+    osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s2;
+
+    s1.set(3);
+    s2.set(3);
+    s2.set(100);
+
+    s1.merge(s2);
+    REQUIRE(s1.size() == 2);
+    REQUIRE(s1.get(3));
+    REQUIRE(s1.get(100));
+}
+
+TEST_CASE("Intersect and subtract IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s1;
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s2;
+
+    for (osmium::unsigned_object_id_type i = 0; i < 1000; i += 2) {
+        s1.set(i);
+    }
+    for (osmium::unsigned_object_id_type i = 0; i < 1000; i += 3) {
+        s2.set(i);
+    }
+    s1.set(1ull << 33u);
+
+    SECTION("intersect") {
+        s1.intersect(s2);
+        REQUIRE(s1.size() == 167);
+        REQUIRE(s1.count() == 167);
+        REQUIRE(s1.get(6));
+        REQUIRE_FALSE(s1.get(4));
+        REQUIRE_FALSE(s1.get(9));
+        REQUIRE_FALSE(s1.get(1ull << 33u));
+    }
+
+    SECTION("subtract") {
+        s1.subtract(s2);
+        REQUIRE(s1.size() == 334);
+        REQUIRE(s1.count() == 334);
+        REQUIRE(s1.get(4));
+        REQUIRE_FALSE(s1.get(6));
+        REQUIRE(s1.get(1ull << 33u));
+    }
+}
+
+TEST_CASE("Iterating over range of IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 4> s;
+    s.set(1);
+    s.set(5);
+    s.set(130);
+    s.set(1000);
+    s.set(1001);
+
+    const auto r = s.range(2, 1001);
+    std::vector<osmium::unsigned_object_id_type> ids(r.begin(), r.end());
+    REQUIRE(ids == (std::vector<osmium::unsigned_object_id_type>{5, 130, 1000}));
+
+    REQUIRE(s.range(6, 129).empty());
+    REQUIRE(s.range(2000, 3000).empty());
+}
+
+TEST_CASE("Split IdSetDense into ranges") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 4> s;
+    REQUIRE(s.split(4).empty());
+
+    const std::vector<osmium::unsigned_object_id_type> expected = {3, 200, 201, 700, 5000, 5001, 9999};
+    for (const auto id : expected) {
+        s.set(id);
+    }
+
+    for (std::size_t n = 1; n < 10; ++n) {
+        const auto ranges = s.split(n);
+        REQUIRE_FALSE(ranges.empty());
+        REQUIRE(ranges.size() <= n);
+        std::vector<osmium::unsigned_object_id_type> ids;
+        for (const auto& range : ranges) {
+            ids.insert(ids.end(), range.begin(), range.end());
+        }
+        REQUIRE(ids == expected);
+    }
+}
+
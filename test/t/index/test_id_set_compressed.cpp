@@ -0,0 +1,200 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using id_set_type = osmium::index::IdSetCompressed<osmium::unsigned_object_id_type>;
+using container = osmium::index::detail::id_set_container;
+
+static std::vector<osmium::unsigned_object_id_type> to_vector(const id_set_type& s) {
+    return std::vector<osmium::unsigned_object_id_type>(s.begin(), s.end());
+}
+
+TEST_CASE("Basic functionality of IdSetCompressed") {
+    id_set_type s;
+
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE_FALSE(s.get(28));
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0); // NOLINT(readability-container-size-empty)
+
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE_FALSE(s.get(28));
+    REQUIRE_FALSE(s.empty());
+    REQUIRE(s.size() == 1);
+
+    s.set(28);
+    REQUIRE(s.get(17));
+    REQUIRE(s.get(28));
+    REQUIRE(s.size() == 2);
+
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE(s.size() == 2);
+
+    s.unset(17);
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.size() == 1);
+
+    s.unset(12345678);
+    REQUIRE(s.size() == 1);
+
+    REQUIRE(s.check_and_set(32));
+    REQUIRE(s.get(32));
+    REQUIRE(s.size() == 2);
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE(s.begin() == s.end());
+}
+
+TEST_CASE("Iterating over IdSetCompressed") {
+    id_set_type s;
+    s.set(7);
+    s.set(35);
+    s.set(35);
+    s.set(20);
+    s.set(1ull << 33u);
+    s.set(21);
+    s.set((1ull << 27u) + 13u);
+
+    REQUIRE(s.size() == 6);
+
+    const std::vector<osmium::unsigned_object_id_type> expected = {
+        7, 20, 21, 35, (1ull << 27u) + 13u, 1ull << 33u
+    };
+    REQUIRE(to_vector(s) == expected);
+}
+
+TEST_CASE("IdSetCompressed switches between array and bitmap containers") {
+    id_set_type s;
+    std::set<osmium::unsigned_object_id_type> reference;
+
+    // Add values out of order, so the container becomes a bitmap
+    for (osmium::unsigned_object_id_type i = 0; i < 20000; ++i) {
+        const auto id = (i * 7919u) % 65536u;
+        s.set(id);
+        reference.insert(id);
+    }
+
+    REQUIRE(s.size() == reference.size());
+    REQUIRE(to_vector(s) == std::vector<osmium::unsigned_object_id_type>(reference.begin(), reference.end()));
+    REQUIRE(s.get(7919));
+    REQUIRE_FALSE(s.get(65536 + 7919));
+
+    // Remove most values again, so the container becomes an array
+    for (osmium::unsigned_object_id_type i = 0; i < 18000; ++i) {
+        const auto id = (i * 7919u) % 65536u;
+        s.unset(id);
+        reference.erase(id);
+    }
+
+    REQUIRE(s.size() == reference.size());
+    REQUIRE(to_vector(s) == std::vector<osmium::unsigned_object_id_type>(reference.begin(), reference.end()));
+}
+
+TEST_CASE("IdSetCompressed with runs after optimize()") {
+    id_set_type s;
+    for (osmium::unsigned_object_id_type i = 1000; i < 100000; ++i) {
+        s.set(i);
+    }
+    s.set(200000);
+
+    const auto before = s.used_memory();
+    s.optimize();
+    REQUIRE(s.used_memory() < before);
+    REQUIRE(s.size() == 99001);
+
+    REQUIRE_FALSE(s.get(999));
+    REQUIRE(s.get(1000));
+    REQUIRE(s.get(65535));
+    REQUIRE(s.get(65536));
+    REQUIRE(s.get(99999));
+    REQUIRE_FALSE(s.get(100000));
+    REQUIRE(s.get(200000));
+
+    REQUIRE(std::distance(s.begin(), s.end()) == 99001);
+    REQUIRE(*s.begin() == 1000);
+
+    // modifying a run container works
+    REQUIRE(s.check_and_set(999));
+    REQUIRE_FALSE(s.check_and_set(5000));
+    s.unset(5000);
+    REQUIRE_FALSE(s.get(5000));
+    REQUIRE(s.size() == 99001);
+}
+
+TEST_CASE("IdSetCompressed set operations") {
+    id_set_type a;
+    id_set_type b;
+    std::set<osmium::unsigned_object_id_type> ra;
+    std::set<osmium::unsigned_object_id_type> rb;
+
+    for (osmium::unsigned_object_id_type i = 0; i < 300000; i += 3) {
+        a.set(i);
+        ra.insert(i);
+    }
+    for (osmium::unsigned_object_id_type i = 100000; i < 500000; i += 5) {
+        b.set(i);
+        rb.insert(i);
+    }
+    b.set(7);
+    rb.insert(7);
+    b.optimize();
+
+    SECTION("merge") {
+        a.merge(b);
+        std::set<osmium::unsigned_object_id_type> r{ra};
+        r.insert(rb.begin(), rb.end());
+        REQUIRE(a.size() == r.size());
+        REQUIRE(to_vector(a) == std::vector<osmium::unsigned_object_id_type>(r.begin(), r.end()));
+    }
+
+    SECTION("intersect") {
+        a.intersect(b);
+        std::vector<osmium::unsigned_object_id_type> r;
+        std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(r));
+        REQUIRE(a.size() == r.size());
+        REQUIRE(to_vector(a) == r);
+    }
+
+    SECTION("subtract") {
+        a.subtract(b);
+        std::vector<osmium::unsigned_object_id_type> r;
+        std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(r));
+        REQUIRE(a.size() == r.size());
+        REQUIRE(to_vector(a) == r);
+    }
+}
+
+TEST_CASE("Serialize and deserialize IdSetCompressed") {
+    id_set_type s;
+    for (osmium::unsigned_object_id_type i = 0; i < 100000; i += 7) {
+        s.set(i);
+    }
+    for (osmium::unsigned_object_id_type i = 200000; i < 300000; ++i) {
+        s.set(i);
+    }
+    s.set(1ull << 40u);
+    s.optimize();
+
+    std::string data;
+    s.serialize(data);
+
+    id_set_type s2;
+    const char* end = s2.deserialize(data.data(), data.size());
+    REQUIRE(end == data.data() + data.size());
+    REQUIRE(s2.size() == s.size());
+    REQUIRE(to_vector(s2) == to_vector(s));
+
+    REQUIRE_THROWS_AS(s2.deserialize(data.data(), data.size() - 1), const std::runtime_error&);
+    REQUIRE(s2.empty());
+}
+
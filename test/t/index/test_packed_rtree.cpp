@@ -0,0 +1,295 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/relations.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/packed_rtree.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/visitor.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    std::vector<osmium::Box> random_boxes(std::size_t num) {
+        std::vector<osmium::Box> boxes;
+        uint32_t state = 4711;
+        const auto next = [&state](int32_t max) {
+            state = state * 1103515245U + 12345U;
+            return static_cast<int32_t>((state >> 4U) % static_cast<uint32_t>(max));
+        };
+        for (std::size_t i = 0; i < num; ++i) {
+            const osmium::Location bottom_left{next(20000000) + 80000000, next(20000000) + 470000000};
+            const osmium::Location top_right{bottom_left.x() + next(100000), bottom_left.y() + next(100000)};
+            boxes.emplace_back(bottom_left, top_right);
+        }
+        return boxes;
+    }
+
+    std::vector<osmium::object_id_type> ids(const std::vector<osmium::index::packed_rtree_entry>& entries) {
+        std::vector<osmium::object_id_type> result;
+        for (const auto& entry : entries) {
+            result.push_back(entry.id());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<osmium::object_id_type> brute_force(const std::vector<osmium::Box>& boxes, const osmium::Box& box) {
+        std::vector<osmium::object_id_type> result;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            if (osmium::geom::overlaps(boxes[i], box)) {
+                result.push_back(static_cast<osmium::object_id_type>(i));
+            }
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Hilbert index") {
+    // The first 16 positions on the curve fill the 4x4 corner
+    std::set<uint32_t> indexes;
+    std::vector<std::pair<uint32_t, uint32_t>> points(16);
+    for (uint32_t x = 0; x < 4; ++x) {
+        for (uint32_t y = 0; y < 4; ++y) {
+            const auto index = osmium::index::detail::hilbert_index(x, y);
+            REQUIRE(index < 16);
+            indexes.insert(index);
+            points[index] = std::make_pair(x, y);
+        }
+    }
+    REQUIRE(indexes.size() == 16);
+
+    // and consecutive positions are neighbours
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        const auto dx = static_cast<int>(points[i].first) - static_cast<int>(points[i - 1].first);
+        const auto dy = static_cast<int>(points[i].second) - static_cast<int>(points[i - 1].second);
+        REQUIRE(std::abs(dx) + std::abs(dy) == 1);
+    }
+}
+
+TEST_CASE("Empty PackedRTree") {
+    osmium::index::PackedRTreeBuilder builder;
+    const auto index = builder.build();
+    REQUIRE(index.empty());
+    REQUIRE_FALSE(index.envelope().valid());
+    REQUIRE(index.search(osmium::Box{0.0, 0.0, 10.0, 10.0}).empty());
+}
+
+TEST_CASE("PackedRTree with one entry") {
+    osmium::index::PackedRTreeBuilder builder;
+    builder.add(osmium::Box{1.0, 1.0, 2.0, 2.0}, osmium::item_type::way, 17);
+    builder.add(osmium::Box{}, osmium::item_type::way, 18);
+    REQUIRE(builder.size() == 1);
+
+    const auto index = builder.build();
+    REQUIRE(index.size() == 1);
+    REQUIRE(index.envelope() == osmium::Box(1.0, 1.0, 2.0, 2.0));
+
+    const auto result = index.search(osmium::Box{1.5, 1.5, 3.0, 3.0});
+    REQUIRE(result.size() == 1);
+    REQUIRE(result[0].id() == 17);
+    REQUIRE(result[0].type() == osmium::item_type::way);
+    REQUIRE(index.search(osmium::Box{2.5, 2.5, 3.0, 3.0}).empty());
+}
+
+TEST_CASE("PackedRTree search gives same result as brute force") {
+    const auto boxes = random_boxes(10000);
+    const auto queries = random_boxes(100);
+
+    for (const uint32_t node_size : {2U, 16U}) {
+        osmium::index::PackedRTreeBuilder builder{osmium::osm_entity_bits::nothing, node_size};
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            builder.add(boxes[i], osmium::item_type::node, static_cast<osmium::object_id_type>(i));
+        }
+        const auto index = builder.build();
+        REQUIRE(index.size() == boxes.size());
+
+        std::size_t found = 0;
+        for (const auto& query : queries) {
+            const auto result = ids(index.search(query));
+            REQUIRE(result == brute_force(boxes, query));
+            found += result.size();
+        }
+        REQUIRE(found > 0);
+
+        // location queries
+        for (std::size_t i = 0; i < 100; ++i) {
+            const auto location = boxes[i].bottom_left();
+            std::vector<osmium::index::packed_rtree_entry> result;
+            index.search(location, [&result](const osmium::index::packed_rtree_entry& entry) {
+                result.push_back(entry);
+            });
+            REQUIRE(ids(result) == brute_force(boxes, osmium::Box{location, location}));
+        }
+    }
+}
+
+TEST_CASE("PackedRTree dump and mmap") {
+    const auto boxes = random_boxes(1000);
+
+    osmium::index::PackedRTreeBuilder builder;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        builder.add(boxes[i], osmium::item_type::area, static_cast<osmium::object_id_type>(i));
+    }
+
+    const int fd = osmium::detail::create_tmp_file();
+    builder.dump(fd);
+
+    const osmium::index::PackedRTree index{fd};
+    REQUIRE(index.size() == boxes.size());
+    const auto in_memory = builder.build();
+    REQUIRE(index.envelope() == in_memory.envelope());
+
+    for (const auto& query : random_boxes(20)) {
+        REQUIRE(ids(index.search(query)) == brute_force(boxes, query));
+    }
+
+    // reading the truncated file fails
+    REQUIRE(::ftruncate(fd, 100) == 0);
+    REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+
+    // reading some other file fails
+    REQUIRE(::ftruncate(fd, 0) == 0);
+    REQUIRE(::ftruncate(fd, 1000) == 0);
+    REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+
+    ::close(fd);
+}
+
+TEST_CASE("PackedRTree with corrupt header or level bounds") {
+    const auto boxes = random_boxes(1000);
+
+    osmium::index::PackedRTreeBuilder builder;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        builder.add(boxes[i], osmium::item_type::area, static_cast<osmium::object_id_type>(i));
+    }
+
+    const int fd = osmium::detail::create_tmp_file();
+    builder.dump(fd);
+    REQUIRE_NOTHROW(osmium::index::PackedRTree{fd});
+
+    // overwrite a uint32_t or uint64_t at the given position in the file
+    const auto patch = [fd](off_t offset, uint64_t value, std::size_t size) {
+        REQUIRE(::pwrite(fd, &value, size, offset) == static_cast<ssize_t>(size));
+    };
+
+    // header: magic (8), version (4), node_size (4), num_entries (8),
+    // num_levels (8), then the level bounds 1000, 1063, 1067, 1068
+
+    SECTION("level bounds not consistent with layout") {
+        patch(40, 1066, 8);
+        REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+    }
+
+    SECTION("level bounds not increasing") {
+        patch(40, 1070, 8);
+        REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+    }
+
+    SECTION("node size not matching levels") {
+        patch(12, 8, 4);
+        REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+    }
+
+    SECTION("number of levels too small") {
+        patch(24, 3, 8);
+        REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+    }
+
+    SECTION("huge number of entries") {
+        patch(16, 1ULL << 62U, 8);
+        REQUIRE_THROWS_AS(osmium::index::PackedRTree{fd}, const std::runtime_error&);
+    }
+
+    ::close(fd);
+}
+
+TEST_CASE("PackedRTreeBuilder as handler and point-in-polygon join") {
+    osmium::memory::Buffer buffer{1024 * 64};
+
+    osmium::builder::add_node(buffer, _id(1), _location(1.5, 1.5), _tag("amenity", "pub"));
+    osmium::builder::add_node(buffer, _id(2), _location(3.0, 3.0), _tag("amenity", "cafe"));
+    osmium::builder::add_node(buffer, _id(3), _location(12.0, 12.0), _tag("amenity", "bar"));
+    osmium::builder::add_node(buffer, _id(4), _location(0.0, 10.0));
+    osmium::builder::add_node(buffer, _id(5), _location(1.0, 10.0));
+    osmium::builder::add_way(buffer, _id(10), _nodes({4, 5}));
+
+    // square with hole, the cafe is in the hole
+    osmium::builder::add_area(buffer, _id(20),
+        _outer_ring({
+            {101, {0.0, 0.0}},
+            {102, {5.0, 0.0}},
+            {103, {5.0, 5.0}},
+            {104, {0.0, 5.0}},
+            {101, {0.0, 0.0}}
+        }),
+        _inner_ring({
+            {105, {2.0, 2.0}},
+            {106, {2.0, 4.0}},
+            {107, {4.0, 4.0}},
+            {108, {4.0, 2.0}},
+            {105, {2.0, 2.0}}
+        })
+    );
+
+    osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> location_index;
+    osmium::handler::NodeLocationsForWays<decltype(location_index)> location_handler{location_index};
+
+    SECTION("all objects") {
+        osmium::index::PackedRTreeBuilder builder;
+        osmium::apply(buffer, location_handler, builder);
+        REQUIRE(builder.size() == 7);
+
+        const auto index = builder.build();
+        const auto result = index.search(osmium::Box{0.5, 9.0, 0.6, 11.0});
+        REQUIRE(result.size() == 1);
+        REQUIRE(result[0].type() == osmium::item_type::way);
+        REQUIRE(result[0].id() == 10);
+    }
+
+    SECTION("only areas") {
+        osmium::index::PackedRTreeBuilder builder{osmium::osm_entity_bits::area};
+        osmium::apply(buffer, builder);
+        REQUIRE(builder.size() == 1);
+        const auto index = builder.build();
+
+        std::vector<std::pair<osmium::object_id_type, osmium::object_id_type>> joined;
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            if (node.tags().empty()) {
+                continue;
+            }
+            index.search(node.location(), [&](const osmium::index::packed_rtree_entry& entry) {
+                // find area in buffer, a real program would use an index
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    if (area.id() == entry.id() && osmium::geom::within(node.location(), area)) {
+                        joined.emplace_back(node.id(), area.id());
+                    }
+                }
+            });
+        }
+
+        REQUIRE(joined.size() == 1);
+        REQUIRE(joined[0].first == 1);
+        REQUIRE(joined[0].second == 20);
+    }
+}
+
+TEST_CASE("PackedRTreeBuilder with invalid node size") {
+    REQUIRE_THROWS_AS(osmium::index::PackedRTreeBuilder(osmium::osm_entity_bits::all, 1), const std::invalid_argument&);
+}
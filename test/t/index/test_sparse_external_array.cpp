@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/multimap/sparse_external_array.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+using multimap_type = osmium::index::multimap::SparseExternalArray<id_type, id_type>;
+
+TEST_CASE("SparseExternalArray with data fitting in buffer") {
+    multimap_type map;
+    map.set(5, 1);
+    map.set(3, 2);
+    map.set(5, 3);
+    map.consolidate();
+
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.num_runs() == 1);
+
+    const auto r = map.get_all(5);
+    REQUIRE(std::distance(r.first, r.second) == 2);
+    REQUIRE(r.first->second == 1);
+    REQUIRE(std::next(r.first)->second == 3);
+
+    const auto r2 = map.get_all(4);
+    REQUIRE(r2.first == r2.second);
+}
+
+TEST_CASE("SparseExternalArray merges runs") {
+    multimap_type map{100};
+
+    std::vector<std::pair<id_type, id_type>> data;
+    for (id_type i = 0; i < 1000; ++i) {
+        const id_type id = (i * 7u) % 331u;
+        data.emplace_back(id, i);
+        map.set(id, i);
+    }
+    REQUIRE(map.num_runs() == 10);
+
+    map.consolidate();
+    REQUIRE(map.num_runs() == 1);
+    REQUIRE(map.size() == 1000);
+
+    std::sort(data.begin(), data.end());
+    REQUIRE(std::equal(data.begin(), data.end(), map.begin()));
+    REQUIRE(std::distance(map.begin(), map.end()) == 1000);
+
+    const auto r = map.get_all(7);
+    REQUIRE(std::distance(r.first, r.second) == 4);
+    for (auto it = r.first; it != r.second; ++it) {
+        REQUIRE(it->first == 7);
+    }
+
+    SECTION("add more data after consolidate") {
+        map.set(7, 5000);
+        map.set(1000, 5001);
+        map.consolidate();
+        REQUIRE(map.size() == 1002);
+        REQUIRE(std::distance(map.begin(), map.end()) == 1002);
+        const auto r2 = map.get_all(7);
+        REQUIRE(std::distance(r2.first, r2.second) == 5);
+        REQUIRE(std::prev(r2.second)->second == 5000);
+        REQUIRE(map.get_all(1000).first->second == 5001);
+    }
+
+    SECTION("dump as list") {
+        const int fd = osmium::detail::create_tmp_file();
+        map.dump_as_list(fd);
+        REQUIRE(osmium::file_size(fd) == 1000 * sizeof(multimap_type::element_type));
+    }
+
+    SECTION("clear") {
+        map.clear();
+        REQUIRE(map.size() == 0); // NOLINT(readability-container-size-empty)
+        REQUIRE(map.num_runs() == 0);
+        REQUIRE(map.begin() == map.end());
+    }
+}
+
+TEST_CASE("SparseExternalArray merges many runs with small buffer") {
+    multimap_type map{3};
+
+    std::vector<std::pair<id_type, id_type>> data;
+    for (id_type i = 0; i < 200; ++i) {
+        const id_type id = (i * 13u) % 47u;
+        data.emplace_back(id, i);
+        map.set(id, i);
+    }
+    REQUIRE(map.num_runs() > 60);
+
+    map.consolidate();
+    REQUIRE(map.num_runs() == 1);
+    REQUIRE(map.size() == 200);
+
+    std::sort(data.begin(), data.end());
+    REQUIRE(std::equal(data.begin(), data.end(), map.begin()));
+}
+
+TEST_CASE("Empty SparseExternalArray") {
+    multimap_type map;
+    map.consolidate();
+    REQUIRE(map.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(map.begin() == map.end());
+    const auto r = map.get_all(1);
+    REQUIRE(r.first == r.second);
+}
+
@@ -6,6 +6,8 @@
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include <vector>
+
 osmium::memory::Buffer fill_buffer() {
     using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
     osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
@@ -192,3 +194,83 @@ TEST_CASE("Remove non-existing object from members database doesn't do anything"
     REQUIRE(mdb.size() == 6);
 }
 
+
+namespace {
+
+    osmium::memory::Buffer fill_buffer_many_members() {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+        // Members are ways with IDs from -300 to 300 in steps of 3, some are
+        // members of several relations.
+        for (osmium::object_id_type id = 1; id <= 200; ++id) {
+            osmium::builder::add_relation(buffer,
+                _id(id),
+                _member(osmium::item_type::way, (id * 3) - 300, "outer"),
+                _member(osmium::item_type::way, ((id * 3 + 150) % 600) - 300, "inner")
+            );
+        }
+        for (osmium::object_id_type id = -310; id <= 310; ++id) {
+            osmium::builder::add_way(buffer, _id(id));
+        }
+
+        return buffer;
+    }
+
+    // Add all ways to a members database configured with the given
+    // lookup options and return the IDs of the completed relations.
+    std::vector<osmium::object_id_type> complete_relations(const osmium::memory::Buffer& buffer, bool hash_index, bool id_filter) {
+        osmium::ItemStash stash;
+        osmium::relations::RelationsDatabase rdb{stash};
+        osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+        if (hash_index) {
+            mdb.enable_hash_index();
+        }
+        if (id_filter) {
+            mdb.enable_id_filter();
+        }
+
+        for (const auto& relation : buffer.select<osmium::Relation>()) {
+            auto handle = rdb.add(relation);
+            int n = 0;
+            for (const auto& member : relation.members()) {
+                mdb.track(handle, member.ref(), n);
+                ++n;
+            }
+        }
+
+        mdb.prepare_for_lookup();
+
+        std::vector<osmium::object_id_type> complete;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            const bool added = mdb.add(way, [&](osmium::relations::RelationHandle& rel_handle) {
+                complete.push_back(rel_handle->id());
+            });
+            REQUIRE(added == (way.id() % 3 == 0 && way.id() >= -300 && way.id() <= 300));
+
+            const auto* way_ptr = mdb.get(way.id());
+            REQUIRE((way_ptr != nullptr) == added);
+            if (way_ptr) {
+                REQUIRE(way_ptr->id() == way.id());
+            }
+        }
+
+        const auto counts = mdb.count();
+        REQUIRE(counts.tracked == 0);
+        REQUIRE(counts.available == 400);
+
+        return complete;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Member database with hash index and ID filter gives same results") {
+    const auto buffer = fill_buffer_many_members();
+
+    const auto expected = complete_relations(buffer, false, false);
+    REQUIRE(expected.size() == 200);
+
+    REQUIRE(complete_relations(buffer, true, false) == expected);
+    REQUIRE(complete_relations(buffer, false, true) == expected);
+    REQUIRE(complete_relations(buffer, true, true) == expected);
+}
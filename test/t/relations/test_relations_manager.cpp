@@ -7,6 +7,7 @@
 #include <osmium/relations/relations_manager.hpp>
 
 #include <iterator>
+#include <vector>
 
 struct EmptyRM : public osmium::relations::RelationsManager<EmptyRM, true, true, true> {
 };
@@ -107,6 +108,16 @@ struct AnyRM : public osmium::relations::RelationsManager<AnyRM, true, true, tru
         return true;
     }
 };
+struct ReleaseRM : public osmium::relations::RelationsManager<ReleaseRM, true, true, true> {
+
+    std::vector<osmium::object_id_type> incomplete_ids;
+
+    void incomplete_relation(const osmium::Relation& relation) {
+        incomplete_ids.push_back(relation.id());
+    }
+
+};
+
 
 TEST_CASE("Use RelationsManager without any overloaded functions in derived class") {
     osmium::io::File file{with_data_dir("t/relations/data.osm")};
@@ -320,3 +331,60 @@ TEST_CASE("Check handling of missing members") {
     REQUIRE(missing_relations == 2);
 }
 
+
+TEST_CASE("Relations manager with stash spilling to disk") {
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+    manager.enable_stash_spilling(1);
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+
+    REQUIRE(manager.count_complete_rels == 2);
+
+    int n = 0;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        ++n;
+        REQUIRE(handle->id() == 31);
+        for (const auto& member : handle->members()) {
+            const auto* obj = manager.get_member_object(member);
+            if (member.ref() == 22) {
+                REQUIRE_FALSE(obj);
+            } else {
+                REQUIRE(obj);
+                REQUIRE(obj->id() == member.ref());
+            }
+        }
+    });
+    REQUIRE(n == 1);
+}
+
+TEST_CASE("Relations manager releasing incomplete relations early") {
+    osmium::io::File file{with_data_dir("t/relations/missing_members.osm")};
+
+    ReleaseRM manager;
+
+    osmium::relations::read_relations(file, manager);
+    manager.enable_early_release();
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+
+    // Relation 32 only has missing way members, it is released when the
+    // first relation is read. Relation 31 has missing relation members
+    // with IDs after all relations in the file, so it is still there.
+    REQUIRE(manager.incomplete_ids.size() == 1);
+    REQUIRE(manager.incomplete_ids[0] == 32);
+
+    int n = 0;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        ++n;
+        REQUIRE(handle->id() == 31);
+    });
+    REQUIRE(n == 1);
+}
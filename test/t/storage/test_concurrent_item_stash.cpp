@@ -0,0 +1,191 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/storage/concurrent_item_stash.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::memory::Buffer generate_nodes(osmium::object_id_type num) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (osmium::object_id_type id = 1; id <= num; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _tag("key", "value"));
+        }
+
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Concurrent item stash handle") {
+    const auto handle = osmium::ConcurrentItemStash::handle_type{};
+    REQUIRE_FALSE(handle.valid());
+
+    std::stringstream ss;
+    ss << handle;
+    REQUIRE(ss.str() == "-");
+}
+
+TEST_CASE("Concurrent item stash with invalid segment size") {
+    REQUIRE_THROWS_AS(osmium::ConcurrentItemStash{0}, const std::invalid_argument&);
+}
+
+TEST_CASE("Concurrent item stash") {
+    const auto buffer = generate_nodes(1000);
+
+    osmium::ConcurrentItemStash stash{4096};
+    REQUIRE(stash.size() == 0);
+    REQUIRE(stash.num_segments() == 0);
+
+    std::vector<osmium::ConcurrentItemStash::handle_type> handles;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        handles.push_back(stash.add_item(node));
+    }
+
+    REQUIRE(stash.size() == 1000);
+    REQUIRE(stash.count_removed() == 0);
+    const auto segments = stash.num_segments();
+    REQUIRE(segments > 10);
+
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        REQUIRE(stash.get<osmium::Node>(handles[i]).id() == static_cast<osmium::object_id_type>(i + 1));
+    }
+
+    SECTION("removing all items in a segment frees it") {
+        for (std::size_t i = 0; i < handles.size() - 1; ++i) {
+            stash.remove_item(handles[i]);
+        }
+        REQUIRE(stash.size() == 1);
+        REQUIRE(stash.num_segments() == 1);
+        REQUIRE(stash.get<osmium::Node>(handles.back()).id() == 1000);
+    }
+
+    SECTION("compaction keeps handles valid") {
+        for (std::size_t i = 0; i < handles.size(); ++i) {
+            if (i % 3 != 0) {
+                stash.remove_item(handles[i]);
+            }
+        }
+        REQUIRE(stash.size() == 334);
+        REQUIRE(stash.count_removed() == 666);
+
+        const auto memory_before = stash.used_memory();
+        REQUIRE(stash.compact());
+        REQUIRE(stash.num_segments() <= segments);
+
+        stash.garbage_collect();
+        REQUIRE_FALSE(stash.compact());
+        REQUIRE(stash.num_segments() < segments / 2 + 2);
+        REQUIRE(stash.count_removed() < 100);
+        REQUIRE(stash.used_memory() < memory_before);
+
+        for (std::size_t i = 0; i < handles.size(); i += 3) {
+            REQUIRE(stash.get<osmium::Node>(handles[i]).id() == static_cast<osmium::object_id_type>(i + 1));
+        }
+
+        // new items go after the compacted ones
+        const auto handle = stash.add_item(buffer.get<osmium::Node>(0));
+        REQUIRE(stash.get<osmium::Node>(handle).id() == 1);
+        REQUIRE(stash.size() == 335);
+    }
+
+    SECTION("clear") {
+        stash.clear();
+        REQUIRE(stash.size() == 0);
+        REQUIRE(stash.num_segments() == 0);
+        const auto handle = stash.add_item(buffer.get<osmium::Node>(0));
+        REQUIRE(stash.get<osmium::Node>(handle).id() == 1);
+    }
+}
+
+TEST_CASE("Concurrent item stash with items larger than segment size") {
+    const auto buffer = generate_nodes(3);
+
+    osmium::ConcurrentItemStash stash{64};
+    std::vector<osmium::ConcurrentItemStash::handle_type> handles;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(node.padded_size() > 64);
+        handles.push_back(stash.add_item(node));
+    }
+
+    REQUIRE(stash.num_segments() == 3);
+    REQUIRE(stash.get<osmium::Node>(handles[1]).id() == 2);
+    stash.remove_item(handles[0]);
+    REQUIRE(stash.num_segments() == 2);
+}
+
+TEST_CASE("Concurrent item stash with readers while adding, removing, and compacting") {
+    const auto buffer = generate_nodes(20000);
+
+    osmium::ConcurrentItemStash stash{8192};
+
+    // Handles of items that are never removed, shared with the readers.
+    std::mutex mutex;
+    std::vector<std::pair<osmium::ConcurrentItemStash::handle_type, osmium::object_id_type>> published;
+    std::atomic<bool> done{false};
+    std::atomic<int> errors{0};
+
+    const auto reader = [&]() {
+        std::size_t n = 0;
+        while (!done) {
+            std::pair<osmium::ConcurrentItemStash::handle_type, osmium::object_id_type> entry;
+            {
+                const std::lock_guard<std::mutex> lock{mutex};
+                if (published.empty()) {
+                    continue;
+                }
+                entry = published[n++ % published.size()];
+            }
+            const auto read_lock = stash.lock_for_reading();
+            const auto& node = stash.get<osmium::Node>(entry.first);
+            if (node.id() != entry.second || std::string{node.tags().get_value_by_key("key", "")} != "value") {
+                ++errors;
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back(reader);
+    }
+
+    std::vector<osmium::ConcurrentItemStash::handle_type> removable;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        const auto handle = stash.add_item(node);
+        if (node.id() % 4 == 0) {
+            const std::lock_guard<std::mutex> lock{mutex};
+            published.emplace_back(handle, node.id());
+        } else {
+            removable.push_back(handle);
+            if (removable.size() > 100) {
+                stash.remove_item(removable.front());
+                removable.erase(removable.begin());
+            }
+        }
+    }
+    stash.garbage_collect();
+
+    done = true;
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    REQUIRE(errors == 0);
+    REQUIRE(stash.size() == 5000 + removable.size());
+
+    for (const auto& entry : published) {
+        REQUIRE(stash.get<osmium::Node>(entry.first).id() == entry.second);
+    }
+}
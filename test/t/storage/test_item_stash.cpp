@@ -166,3 +166,64 @@ TEST_CASE("Fill item stash until it garbage collects") {
     REQUIRE(stash.count_removed() == 0);
 }
 
+
+TEST_CASE("Item stash spilling to disk") {
+    const auto buffer = generate_test_data();
+
+    osmium::ItemStash stash;
+    stash.enable_spilling(1024);
+    REQUIRE(stash.spilled_bytes() == 0);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (const auto& item : buffer) {
+        handles.push_back(stash.add_item(item));
+    }
+
+    REQUIRE(stash.size() == 180);
+    REQUIRE(stash.spilled_bytes() > 0);
+
+    osmium::object_id_type id = 1;
+    for (auto& handle : handles) {
+        const auto& obj = stash.get<osmium::OSMObject>(handle);
+        REQUIRE(obj.id() == id);
+        ++id;
+    }
+
+    // remove spilled and unspilled items
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        stash.remove_item(handles[i]);
+    }
+    REQUIRE(stash.size() == 90);
+
+    for (std::size_t i = 1; i < handles.size(); i += 2) {
+        REQUIRE(stash.get<osmium::OSMObject>(handles[i]).id() == static_cast<osmium::object_id_type>(i + 1));
+    }
+
+    // items added after removal are still found
+    const auto handle = stash.add_item(buffer.get<osmium::Node>(0));
+    REQUIRE(stash.get<osmium::Node>(handle).id() == 1);
+
+    osmium::ItemStash moved{std::move(stash)};
+    REQUIRE(moved.size() == 91);
+    REQUIRE(moved.get<osmium::OSMObject>(handles[179]).id() == 180);
+
+    moved.garbage_collect();
+    REQUIRE(moved.get<osmium::Node>(handle).id() == 1);
+    REQUIRE(moved.get<osmium::OSMObject>(handles[179]).id() == 180);
+
+    moved.clear();
+    REQUIRE(moved.size() == 0);
+    REQUIRE(moved.spilled_bytes() == 0);
+
+    // spilling starts again from the beginning after clear()
+    handles.clear();
+    for (const auto& item : buffer) {
+        handles.push_back(moved.add_item(item));
+    }
+    REQUIRE(moved.spilled_bytes() > 0);
+    id = 1;
+    for (auto& h : handles) {
+        REQUIRE(moved.get<osmium::OSMObject>(h).id() == id);
+        ++id;
+    }
+}
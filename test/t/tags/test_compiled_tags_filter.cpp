@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/compiled_tags_filter.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // The result of each rule is its number, so we can check that the
+    // compiled filter finds the same (first) rule.
+    osmium::TagsFilterBase<int> create_filter() {
+        osmium::TagsFilterBase<int> filter{-1};
+        int n = 0;
+
+        filter.add_rule(n++, osmium::StringMatcher::always_false{});
+        filter.add_rule(n++, "highway", "motorway");
+        filter.add_rule(n++, osmium::StringMatcher::prefix{"addr:"}, "10");
+        filter.add_rule(n++, "highway", osmium::StringMatcher::list{{"primary", "secondary"}});
+        filter.add_rule(n++, "highway", osmium::StringMatcher::prefix{"primary"});
+        filter.add_rule(n++, "highway", "motorway"); // never used
+        filter.add_rule(n++, "highway", "footway", true);
+        filter.add_rule(n++, osmium::StringMatcher::list{{"building", "building:part"}}, "no");
+        filter.add_rule(n++, osmium::StringMatcher::substring{"name"}, "X");
+        filter.add_rule(n++, osmium::StringMatcher::list{{"building", "amenity"}});
+        filter.add_rule(n++, osmium::StringMatcher::prefix{"name:"});
+        filter.add_rule(n++, osmium::StringMatcher::prefix{"addr:"});
+        filter.add_rule(n++, osmium::StringMatcher::prefix{""}, "yes");
+        filter.add_rule(n++, "landuse", true, true); // never matches
+        filter.add_rule(n++, "landuse", false, true);
+        filter.add_rule(n++, osmium::StringMatcher::always_true{}, osmium::StringMatcher::substring{"_link"});
+        filter.add_rule(n++, "name");
+
+        for (int i = 0; i < 100; ++i) {
+            filter.add_rule(n++, "shop", "shop" + std::to_string(i));
+        }
+
+        return filter;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Compiled tags filter gives same results as tags filter") {
+    const auto filter = create_filter();
+    const osmium::CompiledTagsFilterBase<int> compiled{filter};
+    REQUIRE(compiled.count() == filter.count());
+
+    const std::vector<std::string> keys = {
+        "", "highway", "high", "highways", "addr:", "addr:street", "addr",
+        "building", "building:part", "amenity", "name", "name:de", "old_name",
+        "landuse", "shop", "foo"
+    };
+    const std::vector<std::string> values = {
+        "", "motorway", "primary", "primary_link", "secondary", "footway",
+        "no", "X", "yes", "10", "forest", "shop7", "shop99", "shop100", "x"
+    };
+
+    std::vector<int> results;
+    for (const auto& key : keys) {
+        for (const auto& value : values) {
+            osmium::memory::Buffer buffer{1024};
+            osmium::builder::add_tag_list(buffer, osmium::builder::attr::_tag(key, value));
+            const auto& tag = *buffer.get<osmium::TagList>(0).begin();
+            REQUIRE(compiled(tag) == filter(tag));
+            REQUIRE(compiled(key.c_str(), value.c_str()) == filter(tag));
+            results.push_back(filter(tag));
+        }
+    }
+
+    // make sure the test covers rules of all kinds
+    for (const int rule : {-1, 1, 2, 3, 4, 6, 7, 8, 9, 10, 11, 12, 14, 15, 16, 24, 116}) {
+        REQUIRE(std::find(results.cbegin(), results.cend(), rule) != results.cend());
+    }
+}
+
+TEST_CASE("Compiled tags filter with tag list") {
+    osmium::TagsFilter filter{false};
+    filter.add_rule(false, "highway", "footway");
+    filter.add_rule(true, "highway");
+    filter.add_rule(true, osmium::StringMatcher::prefix{"railway"});
+    const osmium::CompiledTagsFilter compiled{filter};
+
+    osmium::memory::Buffer buffer{1024};
+    const auto pos1 = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({{"highway", "footway"}, {"name", "Main Street"}}));
+    const auto pos2 = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({{"name", "Station Road"}, {"railway", "rail"}}));
+
+    REQUIRE_FALSE(osmium::tags::match_any_of(buffer.get<osmium::TagList>(pos1), compiled));
+    REQUIRE(osmium::tags::match_any_of(buffer.get<osmium::TagList>(pos2), compiled));
+}
+
+TEST_CASE("Empty compiled tags filter") {
+    const osmium::CompiledTagsFilter compiled{osmium::TagsFilter{true}};
+    REQUIRE(compiled.empty());
+    REQUIRE(compiled("highway", "primary"));
+}
@@ -0,0 +1,63 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/key_table.hpp>
+
+#include <string>
+
+TEST_CASE("Key table") {
+    osmium::KeyTable keys{"highway", "name"};
+    REQUIRE(keys.size() == 2);
+
+    REQUIRE(keys.get("highway") == 0);
+    REQUIRE(keys.get(std::string{"name"}) == 1);
+    REQUIRE(keys.get("building") == osmium::unknown_key_id);
+    REQUIRE(keys.get("") == osmium::unknown_key_id);
+
+    REQUIRE(keys.add("building") == 2);
+    REQUIRE(keys.add("highway") == 0);
+    REQUIRE(keys.size() == 3);
+    REQUIRE(std::string{keys.key(2)} == "building");
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(keys.add("key" + std::to_string(i)) == static_cast<osmium::key_id_type>(i + 3));
+    }
+    REQUIRE(keys.get("key500") == 503);
+    REQUIRE(keys.get("highway") == 0);
+}
+
+TEST_CASE("Tag list index") {
+    const osmium::KeyTable keys{"highway", "name", "building"};
+    const auto highway = keys.get("highway");
+    const auto name = keys.get("name");
+    const auto building = keys.get("building");
+
+    osmium::memory::Buffer buffer{10240};
+    const auto pos1 = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({{"highway", "primary"}, {"name", "Main Street"}, {"source", "GPS"}, {"name", "Other"}}));
+    const auto pos2 = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({{"building", "yes"}}));
+
+    osmium::TagListIndex index{keys};
+    REQUIRE(index.size() == 0);
+    REQUIRE_FALSE(index.has_key(highway));
+
+    index.update(buffer.get<osmium::TagList>(pos1));
+    REQUIRE(index.size() == 2);
+    REQUIRE(std::string{index.get_value_by_key(highway)} == "primary");
+    REQUIRE(std::string{index.get_value_by_key(name)} == "Main Street");
+    REQUIRE(index.get_value_by_key(building) == nullptr);
+    REQUIRE(std::string{index.get_value_by_key(building, "no")} == "no");
+    REQUIRE(index.get_value_by_key(osmium::unknown_key_id) == nullptr);
+    REQUIRE(index.has_tag(highway, "primary"));
+    REQUIRE_FALSE(index.has_tag(highway, "secondary"));
+
+    index.update(buffer.get<osmium::TagList>(pos2));
+    REQUIRE(index.size() == 1);
+    REQUIRE_FALSE(index.has_key(highway));
+    REQUIRE(index.has_tag(building, "yes"));
+
+    index.clear();
+    REQUIRE_FALSE(index.has_key(building));
+}
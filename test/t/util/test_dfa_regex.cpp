@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/util/dfa_regex.hpp>
+#include <osmium/util/string_matcher.hpp>
+
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("DFA regex gives same results as std::regex_search") {
+    const std::vector<std::string> patterns = {
+        "", "abc", "^abc", "abc$", "^abc$", "^$", "a.c", "a*b", "^a*$",
+        "(ab|cd)+e", "[a-c]x", "[^a-z]", "\\d{2,3}", "^\\d{2,3}$", "colou?r",
+        "^(foo|bar)baz$", "x{3}", "^x{2,}$", "\\w+@\\w+\\.com", "[A-Z][a-z]*",
+        "(?:a|b)*c", "a+?b", "[.*]", "\\s", "\\S+\\s\\S+", "[\\d-]+x", "a|^b|c$",
+        "(a*)*b", "[]]", "\\x41", "a{0,2}c", "(^|,)red(,|$)"
+    };
+    const std::vector<std::string> strings = {
+        "", "abc", "xabcx", "ab", "aaab", "b", "ac", "axc", "a\nc", "abcde",
+        "cdabe", "cx", "A", "12", "x123y", "1", "color", "colour", "foobaz",
+        "barbaz", "xfoobaz", "xxx", "xx", "x", "me@example.com", "Hello",
+        "ccc", "a b", "ab  cd", "12-3x", "]", "red", "blue,red", "redder",
+        "green,red,blue", "aac", "aaac"
+    };
+
+    for (const auto& pattern : patterns) {
+        const osmium::DFARegex dfa{pattern};
+        const std::regex re{pattern};
+        for (const auto& str : strings) {
+            INFO("pattern '" << pattern << "' string '" << str << "'");
+            REQUIRE(dfa.search(str.c_str()) == std::regex_search(str, re));
+        }
+    }
+}
+
+TEST_CASE("DFA regex ignoring case gives same results as std::regex_search") {
+    const std::vector<std::string> patterns = {
+        "abc", "^main st(reet)?$", "[a-c]x", "[^a]", "[^A-Z]", "^[^x]+$",
+        "[^a-z0-9]", "^[^\\d]+$", "[^\\w]", "\\D", "\\W", "\\S+", "[^B]c",
+        "^[^aeiou]*$", "[Xy]+"
+    };
+    const std::vector<std::string> strings = {
+        "", "a", "A", "b", "B", "x", "X", "abc", "ABC", "Main Street", "MAIN ST",
+        "1", "a1", "-", "Bc", "bC", "xyz", "XYZ", "rhythm", "RHYTHM", "a b"
+    };
+
+    for (const auto& pattern : patterns) {
+        const osmium::DFARegex dfa{pattern, true};
+        const std::regex re{pattern, std::regex::ECMAScript | std::regex::icase};
+        for (const auto& str : strings) {
+            INFO("pattern '" << pattern << "' string '" << str << "'");
+            REQUIRE(dfa.search(str.c_str()) == std::regex_search(str, re));
+        }
+    }
+}
+
+TEST_CASE("DFA regex ignoring case") {
+    const osmium::DFARegex dfa{"^main st(reet)?$", true};
+    REQUIRE(dfa.search("Main Street"));
+    REQUIRE(dfa.search("MAIN ST"));
+    REQUIRE_FALSE(dfa.search("Main Road"));
+}
+
+TEST_CASE("DFA regex with unsupported or invalid patterns") {
+    for (const char* pattern : {"a(", "a)", "(?=a)", "(a)\\1", "\\bfoo", "*a", "a{2", "a{3,2}", "[a-", "[z-a]", "\\", "\\q", "a{1001}"}) {
+        INFO("pattern '" << pattern << "'");
+        REQUIRE_THROWS_AS(osmium::DFARegex{pattern}, const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("DFA regex with too many states") {
+    REQUIRE_THROWS_AS(osmium::DFARegex("a.{20}"), const std::invalid_argument&);
+    const osmium::DFARegex dfa{"a.{3}"};
+    REQUIRE(dfa.num_states() < 100);
+}
+
+TEST_CASE("String matcher: dfa_regex") {
+    const osmium::StringMatcher m{osmium::StringMatcher::dfa_regex{"^name(:[a-z]{2})?$"}};
+    REQUIRE(m("name"));
+    REQUIRE(m("name:de"));
+    REQUIRE_FALSE(m("name:de:1"));
+    REQUIRE_FALSE(m("old_name"));
+
+    std::stringstream ss;
+    ss << m;
+    REQUIRE(ss.str() == "dfa_regex[^name(:[a-z]{2})?$]");
+}
@@ -30,3 +30,41 @@ TEST_CASE("Check double2string function") {
     REQUIRE(s6 == "-0");
 }
 
+
+TEST_CASE("double2string rounds like printf") {
+    const auto convert = [](double value, int precision) {
+        std::string s;
+        osmium::double2string(s, value, precision);
+        return s;
+    };
+
+    REQUIRE(convert(180.0, 7) == "180");
+    REQUIRE(convert(-179.9999999, 7) == "-179.9999999");
+    REQUIRE(convert(0.00000006, 7) == "0.0000001");
+    REQUIRE(convert(0.00000004, 7) == "0");
+    REQUIRE(convert(-0.00000004, 7) == "-0");
+    REQUIRE(convert(1.23456789, 3) == "1.235");
+
+    // ties are rounded to even
+    REQUIRE(convert(0.5, 0) == "0");
+    REQUIRE(convert(1.5, 0) == "2");
+    REQUIRE(convert(2.5, 0) == "2");
+    REQUIRE(convert(0.125, 2) == "0.12");
+    REQUIRE(convert(0.375, 2) == "0.38");
+
+    // 1.005 is really 1.00499999999999989...
+    REQUIRE(convert(1.005, 2) == "1");
+
+    // no zeros removed without decimal point
+    REQUIRE(convert(180.0, 0) == "180");
+    REQUIRE(convert(1e15, 0) == "1000000000000000");
+
+    // large values use printf
+    REQUIRE(convert(1e18, 0) == "1000000000000000000");
+    REQUIRE(convert(123456789.125, 3) == "123456789.125");
+
+    // negative precision means printf default of 6 digits
+    REQUIRE(convert(1.5, -1) == "1.5");
+    REQUIRE(convert(1.0, -1) == "1");
+    REQUIRE(convert(0.1234567, -1) == "0.123457");
+}
@@ -110,6 +110,41 @@ TEST_CASE("Anonymous mapping: remapping to smaller size should work") {
 }
 #endif
 
+TEST_CASE("Anonymous mapping: mapping with options should work") {
+    osmium::anonymous_mapping_options options;
+    options.huge_pages = true;
+    options.populate = true;
+    options.numa_interleave = true;
+
+    osmium::AnonymousMemoryMapping mapping{100000, options};
+    REQUIRE(mapping.size() == 100000);
+
+    auto* addr1 = mapping.get_addr<int>();
+    REQUIRE(addr1[1000] == 0);
+    addr1[1000] = 42;
+
+    mapping.resize(200000);
+    REQUIRE(mapping.size() == 200000);
+
+    const auto* addr2 = mapping.get_addr<int>();
+    REQUIRE(addr2[1000] == 42);
+    REQUIRE(addr2[40000] == 0);
+}
+
+TEST_CASE("Anonymous mapping: mapping with populate option only should work") {
+    osmium::anonymous_mapping_options options;
+    options.populate = true;
+
+    osmium::AnonymousTypedMemoryMapping<int> mapping{10000, options};
+    REQUIRE(mapping.size() == 10000);
+    REQUIRE(mapping.begin()[9999] == 0);
+
+    mapping.begin()[5] = 17;
+    mapping.resize(20000);
+    REQUIRE(mapping.begin()[5] == 17);
+    REQUIRE(mapping.begin()[19999] == 0);
+}
+
 TEST_CASE("File-based mapping: writing to a mapped file should work") {
     char filename[] = "test_mmap_write_XXXXXX";
     const int fd = mkstemp(filename);